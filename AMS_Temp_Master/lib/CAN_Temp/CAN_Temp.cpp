@@ -2,46 +2,112 @@
 
 mcp2515_can CAN(SPI_CS_PIN); // Set CS pin
 
-CAN_Temp_MSG::CAN_Temp_MSG()
-    : avrTemp(0xAA), maxTemp(0xAA), minTemp(0xAA)
+CAN_Temp::CAN_Temp(const unsigned long id)
+    : id(id), msg{0, 0, 0, 0, 0, 0, 0, 0}, canState(CAN_STATE_INIT), canStateTime(0), lastBusCheckTime(0), txErrorCount(0), reinitCount(0)
 {
+    AvrTempSignal::set(msg, 0xAA);
+    MaxTempSignal::set(msg, 0xAA);
+    MinTempSignal::set(msg, 0xAA);
 }
 
-CAN_Temp::CAN_Temp(const unsigned long id)
-    : id(id)
+void CAN_Temp::init(void)
 {
-    msg = new CAN_Temp_MSG();
-    tempPara = new Parameter(-25, 0.5f, -25, 100);
+    canState = CAN_STATE_INIT;
+    service(millis());
 }
 
-void CAN_Temp::init(void)
+unsigned char CAN_Temp::service(unsigned long now)
+{
+    switch (canState)
+    {
+    case CAN_STATE_READY:
+        if (txErrorCount >= CAN_REINIT_TX_ERROR)
+        {
+            SERIAL_PORT_MONITOR.println("CAN TX error, reinit");
+            canState = CAN_STATE_INIT;
+            reinitCount++;
+        }
+        else if (now - lastBusCheckTime >= CAN_BUS_CHECK_PERIOD)
+        {
+            unsigned char eflg = 0;
+
+            lastBusCheckTime = now;
+            CAN.checkError(&eflg);
+
+            if (eflg & MCP_EFLG_TXBO)
+            {
+                SERIAL_PORT_MONITOR.println("CAN bus off, reinit");
+                canState = CAN_STATE_INIT;
+                reinitCount++;
+            }
+        }
+        break;
+
+    case CAN_STATE_RETRY:
+        if (now - canStateTime >= CAN_INIT_RETRY_PERIOD)
+        {
+            beginCan(now);
+        }
+        break;
+
+    default:
+        beginCan(now);
+        break;
+    }
+
+    return canState == CAN_STATE_READY;
+}
+
+void CAN_Temp::beginCan(unsigned long now)
 {
-    while (CAN_OK != CAN.begin(CAN_500KBPS))
+    canStateTime = now;
+
+    if (CAN_OK != CAN.begin(CAN_500KBPS))
     {
         SERIAL_PORT_MONITOR.println("CAN init fail, retry...");
-        delay(100);
+        canState = CAN_STATE_RETRY;
+        return;
     }
     SERIAL_PORT_MONITOR.println("CAN init OK!");
+
+    // 受信するIDは無いので, どのフレームも受信バッファに入れない
+    CAN_FILTER filter;
+
+    calcAcceptanceFilter(nullptr, 0, &filter);
+
+    for (int i = 0; i < CAN_FILTER_MASK_NUM; i++)
+    {
+        CAN.init_Mask(i, 0, filter.mask[i]);
+    }
+
+    for (int i = 0; i < CAN_FILTER_FILT_NUM; i++)
+    {
+        CAN.init_Filt(i, 0, filter.filt[i]);
+    }
+
+    canState = CAN_STATE_READY;
+    lastBusCheckTime = now;
+    txErrorCount = 0;
 }
 
 unsigned char CAN_Temp::setTemp(Type type, float physicalValue)
 {
-    if (tempPara->getMinPhysical() <= physicalValue && physicalValue <= tempPara->getMaxPhysical())
+    if (TempPara::getMinPhysical() <= physicalValue && physicalValue <= TempPara::getMaxPhysical())
     {
         switch (type)
         {
         case AVR_TEMP:
-            msg->avrTemp = tempPara->calcNormal(physicalValue);
+            AvrTempSignal::set(msg, TempPara::calcNormal(physicalValue));
             return 0;
             break;
 
         case MAX_TEMP:
-            msg->maxTemp = tempPara->calcNormal(physicalValue);
+            MaxTempSignal::set(msg, TempPara::calcNormal(physicalValue));
             return 0;
             break;
 
         case MIN_TEMP:
-            msg->minTemp = tempPara->calcNormal(physicalValue);
+            MinTempSignal::set(msg, TempPara::calcNormal(physicalValue));
             return 0;
             break;
 
@@ -54,15 +120,15 @@ unsigned char CAN_Temp::setTemp(Type type, float physicalValue)
     switch (type)
     {
     case AVR_TEMP:
-        msg->avrTemp = tempPara->calcNormal(tempPara->getMaxPhysical());
+        AvrTempSignal::set(msg, TempPara::calcNormalInt(TempPara::getMaxPhysical()));
         break;
 
     case MAX_TEMP:
-        msg->maxTemp = tempPara->calcNormal(tempPara->getMaxPhysical());
+        MaxTempSignal::set(msg, TempPara::calcNormalInt(TempPara::getMaxPhysical()));
         break;
 
     case MIN_TEMP:
-        msg->minTemp = tempPara->calcNormal(tempPara->getMaxPhysical());
+        MinTempSignal::set(msg, TempPara::calcNormalInt(TempPara::getMaxPhysical()));
         break;
 
     default:
@@ -76,13 +142,30 @@ unsigned char CAN_Temp::sendTempMsg(unsigned char printFlag)
 {
     unsigned char buf[8];
 
+    if (canState != CAN_STATE_READY)
+    {
+        return CAN_FAILINIT;
+    }
+
     for (int i = 0; i < 8; i++)
     {
-        buf[i] = msg->msg[i];
+        buf[i] = msg[i];
     }
 
     unsigned char result = CAN.sendMsgBuf(id, 0, 8, buf);
 
+    if (result != CAN_OK)
+    {
+        if (txErrorCount < CAN_REINIT_TX_ERROR)
+        {
+            txErrorCount++;
+        }
+    }
+    else
+    {
+        txErrorCount = 0;
+    }
+
     if (printFlag)
     {
         switch (result)
@@ -2,7 +2,9 @@
 #define _CAN_TEMP_H_
 
 #include "Parameter.hpp"
+#include "Signal.hpp"
 #include "CAN_Temp_dfs.hpp"
+#include "CANFilter.hpp"
 
 #include <SPI.h>
 /*
@@ -26,55 +28,76 @@ mcp2518fd CAN(SPI_CS_PIN); // Set CS pin
 // mcp2515_can CAN(SPI_CS_PIN); // Set CS pin
 // #endif
 
-union CAN_Temp_MSG
-{
-    unsigned char msg[8];
-    struct
-    {
-        unsigned char avrTemp : 8;
-        unsigned char maxTemp : 8;
-        unsigned char minTemp : 8;
-    };
+typedef Parameter<-25, 1, 2, -25, 100> TempPara; // 温度
 
-    CAN_Temp_MSG();
-};
+// CAN Massage のシグナル <開始ビット, ビット長, バイトオーダー, 変換>
+typedef Signal<0, 8, SIGNAL_INTEL, TempPara> AvrTempSignal;  // 平均温度
+typedef Signal<8, 8, SIGNAL_INTEL, TempPara> MaxTempSignal;  // 最大温度
+typedef Signal<16, 8, SIGNAL_INTEL, TempPara> MinTempSignal; // 最低温度
 
 class CAN_Temp
 {
 private:
     const unsigned long id;
-    CAN_Temp_MSG *msg;
-    Parameter *tempPara;
+    unsigned char msg[8]; // CAN Massage
+
+    CanState canState;
+    unsigned long canStateTime;     // 状態が変わった時刻[ms]
+    unsigned long lastBusCheckTime; // 最後にバスオフを確認した時刻[ms]
+    unsigned char txErrorCount;     // 連続した送信失敗の回数
+    unsigned short reinitCount;     // 再初期化した回数
+
+    // CANコントローラを初期化する. 失敗したときは CAN_INIT_RETRY_PERIOD 後に再試行する
+    void beginCan(unsigned long now);
 
 public:
     CAN_Temp(const unsigned long id);
 
+    /**
+     * CAN通信初期化処理
+     * このノードは送信専用なので, 受信フィルタは全てのフレームを捨てるように設定する
+     * 初期化を1回だけ試し, 失敗しても待たずに戻る (続きは service で再試行する)
+     */
     void init(void);
 
+    /**
+     * CANコントローラの初期化/再初期化を進める
+     * loop() で毎回呼ぶこと. 待ち続けることはない
+     * 初期化に失敗したときは CAN_INIT_RETRY_PERIOD ごとに再試行し,
+     * バスオフ, または CAN_REINIT_TX_ERROR 回連続の送信失敗で初期化し直す
+     * 戻り値 : 送信可能(1) or 初期化中(0)
+     */
+    unsigned char service(unsigned long now);
+
+    inline CanState getCanState(void) { return canState; }
+
+    inline unsigned short getReinitCount(void) { return reinitCount; }
+
     inline float getTemp(Type type)
     {
         switch (type)
         {
         case Type::AVR_TEMP:
-            return tempPara->calcPhysical(msg->avrTemp);
+            return AvrTempSignal::getPhysical(msg);
             break;
 
         case Type::MAX_TEMP:
-            return tempPara->calcPhysical(msg->maxTemp);
+            return MaxTempSignal::getPhysical(msg);
             break;
 
         case Type::MIN_TEMP:
-            return tempPara->calcPhysical(msg->minTemp);
+            return MinTempSignal::getPhysical(msg);
             break;
 
         default:
-            return tempPara->getMaxPhysical();
+            return TempPara::getMaxPhysical();
             break;
         }
     }
 
     unsigned char setTemp(Type type, float physicalValue);
 
+    // 初期化中は送信せずに CAN_FAILINIT を返す
     unsigned char sendTempMsg(unsigned char printFlag);
 
     void checkBuf(unsigned char *buf);
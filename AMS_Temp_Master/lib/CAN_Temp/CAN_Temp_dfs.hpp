@@ -14,4 +14,16 @@ enum Type
     MIN_TEMP
 };
 
+// CANコントローラの初期化状態 (CAN_Temp::service)
+enum CanState
+{
+    CAN_STATE_INIT,  // 初期化待ち
+    CAN_STATE_RETRY, // 初期化に失敗, CAN_INIT_RETRY_PERIOD 後に再試行
+    CAN_STATE_READY  // 送信可能
+};
+
+const unsigned long CAN_INIT_RETRY_PERIOD = 100; // 初期化の再試行間隔[ms]
+const unsigned long CAN_BUS_CHECK_PERIOD = 100;  // バスオフを確認する間隔[ms]
+const unsigned char CAN_REINIT_TX_ERROR = 3;     // 再初期化する連続送信失敗回数
+
 #endif
\ No newline at end of file
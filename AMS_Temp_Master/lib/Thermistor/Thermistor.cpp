@@ -1,4 +1,5 @@
 #include "Thermistor.hpp"
+#include "Probe.hpp"
 
 THM_DATA::THM_DATA()
     : data{0, 0, 0, 0, 0, 0, 0, 0}
@@ -21,19 +22,29 @@ Thermistor::Thermistor()
 
 unsigned char Thermistor::setData(unsigned char ecuIndex, unsigned char *data, unsigned char length)
 {
+    PROBE_SCOPE("Thermistor::setData");
+
     if (length <= 8)
     {
+        unsigned char buf[8];
+
         for (int i = 0; i < length; i++)
         {
             thm[ecuIndex]->data[i] = *(data + i);
         }
 
-        setVal(thm[ecuIndex]->thm1, ecuIndex, 0);
-        setVal(thm[ecuIndex]->thm2, ecuIndex, 1);
-        setVal(thm[ecuIndex]->thm3, ecuIndex, 2);
-        setVal(thm[ecuIndex]->thm4, ecuIndex, 3);
-        setVal(thm[ecuIndex]->thm5, ecuIndex, 4);
-        setVal(thm[ecuIndex]->thm6, ecuIndex, 5);
+        // thm は volatile なのでコピーしてから読む
+        for (int i = 0; i < 8; i++)
+        {
+            buf[i] = thm[ecuIndex]->data[i];
+        }
+
+        setVal(Thm1Signal::get(buf), ecuIndex, 0);
+        setVal(Thm2Signal::get(buf), ecuIndex, 1);
+        setVal(Thm3Signal::get(buf), ecuIndex, 2);
+        setVal(Thm4Signal::get(buf), ecuIndex, 3);
+        setVal(Thm5Signal::get(buf), ecuIndex, 4);
+        setVal(Thm6Signal::get(buf), ecuIndex, 5);
 
         for (int i = 0; i < thmNum; i++)
         {
@@ -32,28 +32,28 @@
 
 #include <math.h>
 #include "Thermistor_dfs.hpp"
+#include "Signal.hpp"
 
 //-------------------------------------------------------
 //  型定義
 //-------------------------------------------------------
-// ADCの結果を保存するデータ構造
-union THM_DATA
+// ADCの結果を保存するデータ構造 (AMS_Temp_slave から i2c で受け取る 8byte)
+struct THM_DATA
 {
     unsigned char data[8];
-    struct
-    {
-        unsigned short thm1 : 10;
-        unsigned short thm2 : 10;
-        unsigned short thm3 : 10;
-        unsigned short thm4 : 10;
-        unsigned short thm5 : 10;
-        unsigned short thm6 : 10;
-        unsigned char received : 4;
-    };
 
     THM_DATA();
 };
 
+// THM_DATA のシグナル <開始ビット, ビット長> (AVR のビットフィールドと同じ配置)
+typedef Signal<0, 10> Thm1Signal;
+typedef Signal<10, 10> Thm2Signal;
+typedef Signal<20, 10> Thm3Signal;
+typedef Signal<30, 10> Thm4Signal;
+typedef Signal<40, 10> Thm5Signal;
+typedef Signal<50, 10> Thm6Signal;
+typedef Signal<60, 4> ReceivedSignal;
+
 // サーミスタのパラメータ
 // アナログピンで読み取った値と算出したサーミスタの情報を格納する
 class Thermistor
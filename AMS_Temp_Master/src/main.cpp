@@ -3,6 +3,7 @@
 #include <Wire.h>
 #include "Thermistor.hpp"
 #include "CAN_Temp.hpp"
+#include "Probe.hpp"
 
 #define DANGER_OUTPUT (3)
 
@@ -25,6 +26,8 @@ void runCalibration(void);
 
 void setup()
 {
+    PROBE_BEGIN();
+
     _init_(1000);
 
     pinMode(DANGER_OUTPUT, OUTPUT);
@@ -39,6 +42,9 @@ void setup()
 
 void loop()
 {
+    // CANコントローラの初期化/再初期化 (失敗しても温度の監視は止めない)
+    ACC_Temp->service(millis());
+
     if (!countFlag)
     {
         if (count < ecuNum)
@@ -49,6 +55,8 @@ void loop()
             Serial.println(count);
             */
 
+            PROBE_SCOPE("i2c request");
+
             Wire.requestFrom(adrs[count], sizeof(data));
 
             uint8_t i = 0;
@@ -133,6 +141,13 @@ void loop()
     {
         lastCalTime = nowTime;
     }
+
+    // 'q' で処理時間の計測結果を表示, 'w' でリセット (Probe_dfs.hpp)
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        (void)PROBE_COMMAND(c);
+    }
 }
 
 void handler(void)
@@ -1,25 +1,16 @@
 #include <Arduino.h>
 #include <MsTimer2.h>
 #include <Wire.h>
+#include "Signal.hpp"
 
 #define ADRS (0b0000001)
 // #define ADRS (0b0000010)
 // #define ADRS (0b0000100)
 // #define ADRS (0b0001000)
 
-union THM_DATA
+struct THM_DATA
 {
     uint8_t data[8];
-    struct
-    {
-        uint16_t thm1 : 10;
-        uint16_t thm2 : 10;
-        uint16_t thm3 : 10;
-        uint16_t thm4 : 10;
-        uint16_t thm5 : 10;
-        uint16_t thm6 : 10;
-        uint8_t received : 4;
-    };
 
     THM_DATA()
         : data{ 0, 0, 0, 0, 0, 0, 0, 0 }
@@ -27,6 +18,15 @@ union THM_DATA
     }
 };
 
+// THM_DATA のシグナル <開始ビット, ビット長> (AMS_Temp_Master の Thermistor.hpp と同じ配置)
+typedef Signal<0, 10> Thm1Signal;
+typedef Signal<10, 10> Thm2Signal;
+typedef Signal<20, 10> Thm3Signal;
+typedef Signal<30, 10> Thm4Signal;
+typedef Signal<40, 10> Thm5Signal;
+typedef Signal<50, 10> Thm6Signal;
+typedef Signal<60, 4> ReceivedSignal;
+
 const uint8_t thmNum = 6; // サーミスタ本数
 static const uint8_t INPUT_PINS[6] = { A0, A1, A2, A3, A6, A7 };
 THM_DATA *thm = new THM_DATA();
@@ -70,21 +70,21 @@ void sendData(void)
 
 void checkData(void)
 {
-    Serial.println(thm->thm1);
-    Serial.println(thm->thm2);
-    Serial.println(thm->thm3);
-    Serial.println(thm->thm4);
-    Serial.println(thm->thm5);
-    Serial.println(thm->thm6);
+    Serial.println(Thm1Signal::get(thm->data));
+    Serial.println(Thm2Signal::get(thm->data));
+    Serial.println(Thm3Signal::get(thm->data));
+    Serial.println(Thm4Signal::get(thm->data));
+    Serial.println(Thm5Signal::get(thm->data));
+    Serial.println(Thm6Signal::get(thm->data));
     Serial.println();
 }
 
 void readThmVoltage(void)
 {
-    thm->thm1 = analogRead(INPUT_PINS[0]);
-    thm->thm2 = analogRead(INPUT_PINS[1]);
-    thm->thm3 = analogRead(INPUT_PINS[2]);
-    thm->thm4 = analogRead(INPUT_PINS[3]);
-    thm->thm5 = analogRead(INPUT_PINS[4]);
-    thm->thm6 = analogRead(INPUT_PINS[5]);
+    Thm1Signal::set(thm->data, analogRead(INPUT_PINS[0]));
+    Thm2Signal::set(thm->data, analogRead(INPUT_PINS[1]));
+    Thm3Signal::set(thm->data, analogRead(INPUT_PINS[2]));
+    Thm4Signal::set(thm->data, analogRead(INPUT_PINS[3]));
+    Thm5Signal::set(thm->data, analogRead(INPUT_PINS[4]));
+    Thm6Signal::set(thm->data, analogRead(INPUT_PINS[5]));
 }
\ No newline at end of file
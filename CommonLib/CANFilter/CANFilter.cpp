@@ -0,0 +1,66 @@
+#include "CANFilter.hpp"
+
+// ids の全てに一致する最も狭いマスク
+static unsigned long calcCommonMask(const unsigned long *ids, unsigned char num)
+{
+    unsigned long diff = 0;
+
+    for (int i = 1; i < num; i++)
+    {
+        diff |= ids[i] ^ ids[0];
+    }
+
+    return CAN_STANDARD_ID_MASK & ~diff;
+}
+
+void calcAcceptanceFilter(const unsigned long *ids, unsigned char num, CAN_FILTER *filter)
+{
+    if (num == 0)
+    {
+        for (int i = 0; i < CAN_FILTER_MASK_NUM; i++)
+        {
+            filter->mask[i] = CAN_STANDARD_ID_MASK;
+        }
+
+        for (int i = 0; i < CAN_FILTER_FILT_NUM; i++)
+        {
+            filter->filt[i] = CAN_UNUSED_ID;
+        }
+
+        return;
+    }
+
+    // RXB0 : 先頭の2個を完全一致で受信, 1個しかないときは同じIDを重ねる
+    filter->mask[0] = CAN_STANDARD_ID_MASK;
+    filter->filt[0] = ids[0] & CAN_STANDARD_ID_MASK;
+    filter->filt[1] = (num > 1 ? ids[1] : ids[0]) & CAN_STANDARD_ID_MASK;
+
+    // RXB1 : 3個目以降のID (フィルタ2~5), IDが CAN_FILTER_FILT_NUM (6個) を超える場合は共通するビットだけ比較する
+    if (num <= 2)
+    {
+        filter->mask[1] = CAN_STANDARD_ID_MASK;
+
+        for (int i = 2; i < CAN_FILTER_FILT_NUM; i++)
+        {
+            filter->filt[i] = filter->filt[0];
+        }
+    }
+    else if (num <= CAN_FILTER_FILT_NUM)
+    {
+        filter->mask[1] = CAN_STANDARD_ID_MASK;
+
+        for (int i = 2; i < CAN_FILTER_FILT_NUM; i++)
+        {
+            filter->filt[i] = (i < num ? ids[i] : ids[2]) & CAN_STANDARD_ID_MASK;
+        }
+    }
+    else
+    {
+        filter->mask[1] = calcCommonMask(ids + 2, num - 2);
+
+        for (int i = 2; i < CAN_FILTER_FILT_NUM; i++)
+        {
+            filter->filt[i] = ids[2] & filter->mask[1];
+        }
+    }
+}
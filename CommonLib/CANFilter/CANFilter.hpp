@@ -0,0 +1,32 @@
+#ifndef _CAN_FILTER_H_
+#define _CAN_FILTER_H_
+
+#define CAN_STANDARD_ID_MASK (0x7FF)
+#define CAN_UNUSED_ID (0x7FF)   // 0x7F0~0x7FF は標準IDとして使えないので, どのフレームにも一致しない
+
+#define CAN_FILTER_MASK_NUM (2) // MCP2515 のマスク数 (RXB0 : マスク0, RXB1 : マスク1)
+#define CAN_FILTER_FILT_NUM (6) // MCP2515 のフィルタ数 (RXB0 : フィルタ0~1, RXB1 : フィルタ2~5)
+
+// MCP2515 の受信マスクとフィルタの設定値(標準ID)
+struct CAN_FILTER
+{
+    unsigned long mask[CAN_FILTER_MASK_NUM];
+    unsigned long filt[CAN_FILTER_FILT_NUM];
+};
+
+/**
+ * @fn      calcAcceptanceFilter
+ *
+ * @brief   受信するIDの一覧から MCP2515 のマスクとフィルタを計算する
+ *          IDが6個以下なら全て完全一致のフィルタになる
+ *          7個以上のときはRXB1のマスクを共通するビットだけに広げるので,
+ *          余分に受信したフレームはソフトウェアで捨てる
+ *          IDが0個のときはどのフレームも受信しない
+ *
+ * @param   ids     受信するIDの配列
+ * @param   num     IDの個数
+ * @param   filter  計算結果
+ */
+void calcAcceptanceFilter(const unsigned long *ids, unsigned char num, CAN_FILTER *filter);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _PARAMETER_H_
+#define _PARAMETER_H_
+
+/**
+ * Parameter for changing massage to physical
+ * physical = Offset + normal * (ResolutionNum / ResolutionDen)
+ * physical(MinPhysical~MaxPhysical)
+ *
+ * 定数は全てテンプレート引数なのでコンパイル時に畳み込まれ, 変換は整数演算だけで済む
+ * Fixed Value : Physical Value を ResolutionDen 倍した整数 (resolution 0.5 なら 0.5 単位)
+ *
+ * 例) トルク resolution 0.5 Nm, offset -1000 Nm, -1000~1000 Nm
+ *     typedef Parameter<-1000, 1, 2, -1000, 1000> TorquePara;
+ */
+template <long Offset, long ResolutionNum, long ResolutionDen, long MinPhysical, long MaxPhysical>
+class Parameter
+{
+public:
+    static constexpr long getOffset() { return Offset; };
+    static constexpr float getResolution() { return (float)ResolutionNum / ResolutionDen; };
+    static constexpr long getMinPhysical() { return MinPhysical; };
+    static constexpr long getMaxPhysical() { return MaxPhysical; };
+    static constexpr long getMinFixed() { return MinPhysical * ResolutionDen; };
+    static constexpr long getMaxFixed() { return MaxPhysical * ResolutionDen; };
+
+    // Physical Value が範囲内か
+    static constexpr bool inRange(long physicalValue)
+    {
+        return MinPhysical <= physicalValue && physicalValue <= MaxPhysical;
+    }
+
+    // Fixed Value を範囲内に制限する
+    static constexpr long clampFixed(long fixedValue)
+    {
+        return fixedValue < getMinFixed() ? getMinFixed() : (getMaxFixed() < fixedValue ? getMaxFixed() : fixedValue);
+    }
+
+    // Normal ValueからFixed Valueを計算
+    static constexpr long calcFixed(unsigned short normal)
+    {
+        return (long)normal * ResolutionNum + Offset * ResolutionDen;
+    }
+
+    // Fixed ValueからNormal Valueを計算, 範囲外の値は制限する
+    static constexpr unsigned short calcNormalFixed(long fixedValue)
+    {
+        return (unsigned short)((clampFixed(fixedValue) - Offset * ResolutionDen) / ResolutionNum);
+    }
+
+    // Normal ValueからPhysical Valueを計算 (整数, 0方向に切り捨て)
+    static constexpr long calcPhysicalInt(unsigned short normal)
+    {
+        return calcFixed(normal) / ResolutionDen;
+    }
+
+    // Physical Value(整数)からNormal Valueを計算, 範囲外の値は制限する
+    static constexpr unsigned short calcNormalInt(long physicalValue)
+    {
+        return calcNormalFixed(physicalValue * ResolutionDen);
+    }
+
+    // Normal ValueからPhysical Valueを計算
+    // 整数で計算してから定数 1/ResolutionDen を掛ける (ResolutionDen = 1 なら掛け算も消える)
+    static constexpr float calcPhysical(unsigned short normal)
+    {
+        return calcFixed(normal) * (1.0f / ResolutionDen);
+    }
+
+    // Physical ValueからNormal Valueを計算, 範囲外の値は制限する
+    // (physicalValue - Offset) は 0 以上なので整数への変換は切り捨てになる
+    static constexpr unsigned short calcNormal(float physicalValue)
+    {
+        return physicalValue < MinPhysical ? calcNormalInt(MinPhysical)
+             : (MaxPhysical < physicalValue ? calcNormalInt(MaxPhysical)
+             : (unsigned short)((long)((physicalValue - Offset) * ResolutionDen) / ResolutionNum));
+    }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "Probe.hpp"
+#include <string.h>
+
+PROBE_STAT Probe::stats[PROBE_MAX];
+unsigned char Probe::probeCount = 0;
+unsigned char Probe::prescaler = PROBE_AVR_PRESCALER;
+
+void Probe::begin(unsigned char prescaler)
+{
+    Probe::prescaler = prescaler == 8 ? 8 : 1;
+
+#if defined(__AVR__)
+    // ノーマルモード (比較出力なし, 割り込みなし) で 0xFFFF まで数えて一周する
+    const unsigned char cs = Probe::prescaler == 8 ? 0x02 : 0x01;
+#if defined(TCNT4)
+    TCCR4A = 0;
+    TCCR4B = cs;
+    TCCR4C = 0;
+    TIMSK4 = 0;
+    TCNT4 = 0;
+#else
+    TCCR1A = 0;
+    TCCR1B = cs;
+    TCCR1C = 0;
+    TIMSK1 = 0;
+    TCNT1 = 0;
+#endif
+#elif defined(ARDUINO_ARCH_RENESAS) || defined(ARDUINO_UNO_R4)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    reset();
+}
+
+unsigned char Probe::add(const char *name)
+{
+    for (unsigned char i = 0; i < probeCount; i++)
+    {
+        if (strcmp(stats[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (probeCount >= PROBE_MAX)
+    {
+        return PROBE_NO_ID;
+    }
+
+    stats[probeCount].name = name;
+    stats[probeCount].count = 0;
+    stats[probeCount].sum = 0;
+    stats[probeCount].min = (ProbeTicks)~0UL;
+    stats[probeCount].max = 0;
+
+    return probeCount++;
+}
+
+void Probe::record(unsigned char id, ProbeTicks ticks)
+{
+    if (id >= probeCount)
+    {
+        return;
+    }
+
+    PROBE_STAT *stat = &stats[id];
+
+    if (ticks < stat->min)
+    {
+        stat->min = ticks;
+    }
+    if (stat->max < ticks)
+    {
+        stat->max = ticks;
+    }
+
+    // sum が溢れる前に sum と count を半分にする (平均は変わらない)
+    if (stat->sum + ticks < stat->sum)
+    {
+        stat->sum >>= 1;
+        stat->count >>= 1;
+    }
+    stat->sum += ticks;
+    stat->count++;
+}
+
+void Probe::reset(void)
+{
+    for (unsigned char i = 0; i < probeCount; i++)
+    {
+        stats[i].count = 0;
+        stats[i].sum = 0;
+        stats[i].min = (ProbeTicks)~0UL;
+        stats[i].max = 0;
+    }
+}
+
+unsigned long Probe::getTicksPerUs(void)
+{
+#if defined(__AVR__)
+    return F_CPU / 1000000UL / prescaler;
+#elif defined(ARDUINO_ARCH_RENESAS) || defined(ARDUINO_UNO_R4)
+    return SystemCoreClock / 1000000UL;
+#else
+    return 1;
+#endif
+}
+
+unsigned long Probe::toNanos(unsigned long ticks)
+{
+    const unsigned long tpu = getTicksPerUs();
+
+    // ticks * 1000 が溢れないように us と端数に分ける
+    return ticks / tpu * 1000UL + ticks % tpu * 1000UL / tpu;
+}
+
+void Probe::print(void)
+{
+    Serial.println();
+    Serial.print("----------Probe [ns] (1 tick = ");
+    Serial.print(toNanos(1000) / 1000.0f);
+    Serial.println(" ns)----------");
+
+    for (unsigned char i = 0; i < probeCount; i++)
+    {
+        const PROBE_STAT *stat = &stats[i];
+
+        Serial.print(stat->name);
+        Serial.print(" : n ");
+        Serial.print(stat->count);
+        Serial.print(" min ");
+        Serial.print(stat->count ? toNanos(stat->min) : 0);
+        Serial.print(" max ");
+        Serial.print(toNanos(stat->max));
+        Serial.print(" mean ");
+        Serial.println(stat->count ? toNanos(stat->sum / stat->count) : 0);
+    }
+
+    Serial.println("--------------------------------");
+    Serial.println();
+}
+
+unsigned char Probe::command(int c)
+{
+    switch (c)
+    {
+    case PROBE_CMD_PRINT:
+        print();
+        return 1;
+        break;
+
+    case PROBE_CMD_RESET:
+        reset();
+        return 1;
+        break;
+
+    default:
+        return 0;
+        break;
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef _PROBE_H_
+#define _PROBE_H_
+
+#include <Arduino.h>
+#include "Probe_dfs.hpp"
+
+/**
+ * フリーランのハードウェアタイマで区間の処理時間を測る
+ *  AVR : Timer4 (MEGA) / Timer1 (UNO, Pro Mini) を 16bit のフリーランにする
+ *  R4  : Cortex-M4 の DWT サイクルカウンタ (32bit, 48 MHz)
+ *  その他 (ホストPC) : micros()
+ *
+ * 統計は固定の静的テーブルに溜める (動的確保はしない)
+ * 同じプローブを割り込みの中と外の両方で使わないこと
+ */
+#if defined(__AVR__)
+typedef unsigned short ProbeTicks;
+#else
+typedef unsigned long ProbeTicks;
+#endif
+
+struct PROBE_STAT
+{
+    const char *name;
+    unsigned long count;
+    unsigned long sum; // [tick]
+    ProbeTicks min;    // [tick]
+    ProbeTicks max;    // [tick]
+};
+
+class Probe
+{
+private:
+    static PROBE_STAT stats[PROBE_MAX];
+    static unsigned char probeCount;
+    static unsigned char prescaler; // AVR のタイマのプリスケーラ (1 or 8)
+
+public:
+    /**
+     * @fn      begin
+     *
+     * @brief   タイマを開始する. setup() で1回呼ぶ
+     *
+     * @param   prescaler   AVR のタイマのプリスケーラ (1 or 8, それ以外は 1), AVR 以外では使わない
+     */
+    static void begin(unsigned char prescaler = PROBE_AVR_PRESCALER);
+
+    // タイマの現在値[tick]
+    static inline ProbeTicks now(void)
+    {
+#if defined(__AVR__)
+        // 16bit レジスタは2回に分けて読むので割り込みを止める
+        const unsigned char sreg = SREG;
+        cli();
+#if defined(TCNT4)
+        const ProbeTicks t = TCNT4;
+#else
+        const ProbeTicks t = TCNT1;
+#endif
+        SREG = sreg;
+        return t;
+#elif defined(ARDUINO_ARCH_RENESAS) || defined(ARDUINO_UNO_R4)
+        return DWT->CYCCNT;
+#else
+        return micros();
+#endif
+    }
+
+    /**
+     * @fn      add
+     *
+     * @brief   プローブを登録する. 同じ名前が登録済みならその番号を返す
+     *
+     * @return  プローブの番号, 一杯のときは PROBE_NO_ID
+     */
+    static unsigned char add(const char *name);
+
+    // 区間の時間[tick]を記録する
+    static void record(unsigned char id, ProbeTicks ticks);
+
+    static void reset(void);
+
+    // 1 us あたりの tick 数
+    static unsigned long getTicksPerUs(void);
+
+    // tick を ns に変換する
+    static unsigned long toNanos(unsigned long ticks);
+
+    // 全プローブの統計をシリアルモニタに表示
+    static void print(void);
+
+    /**
+     * シリアルモニタから受信した1文字のコマンドを処理する
+     * 戻り値 : 1(処理した) or 0(このクラスのコマンドではない)
+     */
+    static unsigned char command(int c);
+
+    static inline const PROBE_STAT *getStat(unsigned char id) { return id < probeCount ? &stats[id] : nullptr; }
+};
+
+/**
+ * スコープの入口から出口までの時間を記録する
+ * PROBE_SCOPE マクロから使う
+ */
+class ProbeScope
+{
+private:
+    const unsigned char id;
+    const ProbeTicks start;
+
+public:
+    inline ProbeScope(unsigned char id) : id(id), start(Probe::now()) {}
+    inline ~ProbeScope() { Probe::record(id, (ProbeTicks)(Probe::now() - start)); }
+};
+
+#define PROBE_CAT_(a, b) a##b
+#define PROBE_CAT(a, b) PROBE_CAT_(a, b)
+
+#ifdef PROBE_ENABLE
+// 関数やブロックの先頭に書くと, そのスコープを抜けるまでの時間を name のプローブに記録する
+#define PROBE_SCOPE(name)                                                            \
+    static const unsigned char PROBE_CAT(probeId, __LINE__) = Probe::add(name);      \
+    ProbeScope PROBE_CAT(probeScope, __LINE__)(PROBE_CAT(probeId, __LINE__))
+#define PROBE_BEGIN(...) Probe::begin(__VA_ARGS__)
+#define PROBE_COMMAND(c) Probe::command(c)
+#else
+#define PROBE_SCOPE(name) do {} while (0)
+#define PROBE_BEGIN(...) do {} while (0)
+#define PROBE_COMMAND(c) (0)
+#endif
+
+#endif
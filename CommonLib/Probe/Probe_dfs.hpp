@@ -0,0 +1,32 @@
+#ifndef _PROBE_DFS_H_
+#define _PROBE_DFS_H_
+
+/**
+ * ハードウェアタイマでの区間の処理時間の計測 (PROBE_SCOPE)
+ * コメントアウトする (または build_flags に -DPROBE_DISABLE) と計測処理とRAMが全て消える
+ */
+#ifndef PROBE_DISABLE
+#define PROBE_ENABLE
+#endif
+
+#ifndef PROBE_MAX
+#define PROBE_MAX (16)        // プローブの数 (名前ごとに1つ)
+#endif
+#define PROBE_NO_ID (0xFF)    // プローブが一杯で登録できなかったときの番号
+
+/**
+ * AVR の Timer4 (MEGA) / Timer1 (UNO, Pro Mini) のプリスケーラ (1 or 8)
+ *  1 : 62.5 ns 刻み, 4.09 ms まで
+ *  8 : 0.5 us 刻み, 32.7 ms まで
+ * 計測できる時間を超えると16bitのカウンタが一周して短く見える
+ * 既定値. build_flags を渡せない Arduino IDE のスケッチ (DC2259) は PROBE_BEGIN(8) で指定する
+ */
+#ifndef PROBE_AVR_PRESCALER
+#define PROBE_AVR_PRESCALER (1)
+#endif
+
+// シリアルコマンド
+#define PROBE_CMD_PRINT ('q') // 統計を表示
+#define PROBE_CMD_RESET ('w') // 統計をリセット
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef _SIGNAL_H_
+#define _SIGNAL_H_
+
+/**
+ * CAN Massage のシグナルの読み書き
+ * 開始ビット, ビット長, バイトオーダーをテンプレート引数で指定するので,
+ * 読み書きはコンパイル時に決まるバイト単位のシフトとマスクだけになる
+ *
+ * ビット番号は DBC と同じく buf[n] のビット m を n * 8 + m とする
+ *  SIGNAL_INTEL    : Start は最下位ビット, 上位ビットは後ろのバイトへ続く
+ *  SIGNAL_MOTOROLA : Start は最上位ビット, 下位ビットは後ろのバイトへ続く
+ *
+ * ビットフィールドの共用体と違ってコンパイラ(avr-gcc, arm-none-eabi-gcc, ホストPC)で配置が変わらない
+ *
+ * 例) MG-ECU1 のモータ回転数 bit 8~23, resolution 1 rpm, offset -14000 rpm
+ *     typedef Signal<8, 16, SIGNAL_INTEL, Parameter<-14000, 1, 1, -14000, 14000>> MotorSpeed;
+ *     long rpm = MotorSpeed::getPhysicalInt(buf);
+ */
+
+#define SIGNAL_INTEL (0)    // リトルエンディアン
+#define SIGNAL_MOTOROLA (1) // ビッグエンディアン
+
+// シグナルを含むバイト数に合わせた一時変数の型 (AVR で不要な 32bit 演算をしない)
+template <unsigned char Num>
+struct SignalRaw
+{
+    typedef unsigned long type;
+};
+
+template <>
+struct SignalRaw<1>
+{
+    typedef unsigned char type;
+};
+
+template <>
+struct SignalRaw<2>
+{
+    typedef unsigned short type;
+};
+
+/**
+ * シグナルを含むバイトを1つずつ読み書きする (テンプレートの再帰で展開される)
+ * First : 先頭のバイト, Num : バイト数, I : 処理中のバイト
+ */
+template <class Raw, unsigned char First, unsigned char Num, unsigned char Order, unsigned char I = 0>
+struct SignalBytes
+{
+    static constexpr unsigned char SHIFT = 8 * (Order == SIGNAL_INTEL ? I : Num - 1 - I);
+
+    static inline Raw read(const unsigned char *buf)
+    {
+        return ((Raw)buf[First + I] << SHIFT) | SignalBytes<Raw, First, Num, Order, I + 1>::read(buf);
+    }
+
+    static inline void write(unsigned char *buf, Raw raw, Raw mask)
+    {
+        const unsigned char m = (unsigned char)(mask >> SHIFT);
+
+        buf[First + I] = (buf[First + I] & ~m) | ((unsigned char)(raw >> SHIFT) & m);
+        SignalBytes<Raw, First, Num, Order, I + 1>::write(buf, raw, mask);
+    }
+};
+
+template <class Raw, unsigned char First, unsigned char Num, unsigned char Order>
+struct SignalBytes<Raw, First, Num, Order, Num>
+{
+    static inline Raw read(const unsigned char *) { return 0; }
+    static inline void write(unsigned char *, Raw, Raw) {}
+};
+
+/**
+ * CAN Massage の1つのシグナル
+ * Start  : 開始ビット (SIGNAL_INTEL は最下位ビット, SIGNAL_MOTOROLA は最上位ビット)
+ * Length : ビット長 (1~32)
+ * Order  : バイトオーダー
+ * Para   : Normal Value と Physical Value の変換 (Parameter.hpp), 変換しないシグナルは void
+ */
+template <unsigned char Start, unsigned char Length, unsigned char Order = SIGNAL_INTEL, class Para = void>
+class Signal
+{
+private:
+    static constexpr unsigned char FIRST = Start / 8;
+    static constexpr unsigned char NUM = Order == SIGNAL_INTEL ? (Start % 8 + Length + 7) / 8
+                                                               : (Length + 7 - Start % 8 + 7) / 8;
+    // 読み出した NUM バイトの中でのシグナルの最下位ビットの位置
+    static constexpr unsigned char SHIFT = Order == SIGNAL_INTEL ? Start % 8
+                                                                 : 8 * (NUM - 1) + Start % 8 + 1 - Length;
+
+    typedef typename SignalRaw<NUM>::type Raw;
+    typedef SignalBytes<Raw, FIRST, NUM, Order> Bytes;
+
+    static_assert(Length >= 1 && Length <= 32, "signal length must be 1 to 32 bits");
+    static_assert(NUM <= 4, "signal must fit in 4 bytes");
+    static_assert(FIRST + NUM <= 8, "signal must fit in 8 byte massage");
+
+public:
+    typedef typename SignalRaw<(Length + 7) / 8>::type Value;
+
+    static constexpr unsigned long MASK = Length == 32 ? 0xFFFFFFFFUL : (1UL << Length) - 1;
+
+    // Normal Value を読む
+    static inline Value get(const unsigned char *buf)
+    {
+        return (Value)((Bytes::read(buf) >> SHIFT) & (Raw)MASK);
+    }
+
+    // Normal Value を書く (ビット長を超える分は捨てる, 他のシグナルのビットは変えない)
+    static inline void set(unsigned char *buf, unsigned long normal)
+    {
+        Bytes::write(buf, (Raw)((Raw)normal << SHIFT), (Raw)((Raw)MASK << SHIFT));
+    }
+
+    // 以下は Para を指定したシグナルだけ使える
+
+    // 戻り値はPhysical Value
+    static inline float getPhysical(const unsigned char *buf) { return Para::calcPhysical(get(buf)); }
+
+    // 戻り値はPhysical Value(整数)
+    static inline long getPhysicalInt(const unsigned char *buf) { return Para::calcPhysicalInt(get(buf)); }
+
+    // 戻り値は 1/ResolutionDen 単位のPhysical Value
+    static inline long getFixed(const unsigned char *buf) { return Para::calcFixed(get(buf)); }
+};
+
+#endif
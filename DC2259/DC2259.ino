@@ -79,6 +79,9 @@ In this sketch book:
 //#include "UserInterface.h"   
 //#include "LTC681x.h"
 #include "LTC6811.h"
+// Probe is ../CommonLib/Probe: copy or link it into the Arduino libraries folder
+// (or pass --library ../CommonLib/Probe to arduino-cli)
+#include <Probe.hpp>
 
 /************************* Defines *****************************/
 #define ENABLED 1
@@ -180,6 +183,7 @@ uint32_t conv_time = 0;
 void setup()
 {
   Serial.begin(115200);
+  PROBE_BEGIN(8); // Free-running timer for PROBE_SCOPE, prescaler 8 as reading all ICs over SPI can exceed 4 ms
   quikeval_SPI_connect();
   spi_enable(SPI_CLOCK_DIV16); // This will set the Linduino to have a 1MHz Clock
   LTC6811_init_cfg(TOTAL_IC, BMS_IC);
@@ -217,6 +221,13 @@ void loop()
   }*/
 
   run_command(4);
+
+  // 'q' prints the LTC681x read timings, 'w' resets them (Probe_dfs.hpp)
+  while (Serial.available() > 0)
+  {
+    int c = Serial.read();
+    (void)PROBE_COMMAND(c);
+  }
 }
 
 /*!*****************************************
@@ -49,6 +49,7 @@
 #ifdef LINDUINO
 #include <Arduino.h>
 #endif
+#include <Probe.hpp>
 
 /* Wake isoSPI up from IDlE state and enters the READY state */
 void wakeup_idle(uint8_t total_ic) //Number of ICs in the system
@@ -438,6 +439,7 @@ uint8_t LTC681x_rdcv(uint8_t reg, // Controls which cell voltage register is rea
                      cell_asic *ic // Array of the parsed cell codes
                     )
 {
+  PROBE_SCOPE("LTC681x_rdcv");
 	int8_t pec_error = 0;
 	uint8_t *cell_data;
 	uint8_t c_ic = 0;
@@ -500,6 +502,7 @@ int8_t LTC681x_rdaux(uint8_t reg, //Determines which GPIO voltage register is re
                      cell_asic *ic//A two dimensional array of the gpio voltage codes.
                     )
 {
+  PROBE_SCOPE("LTC681x_rdaux");
 	uint8_t *data;
 	int8_t pec_error = 0;
 	uint8_t c_ic =0;
@@ -563,6 +566,7 @@ int8_t LTC681x_rdstat(uint8_t reg, //Determines which Stat  register is read bac
                      )
 
 {
+  PROBE_SCOPE("LTC681x_rdstat");
 	const uint8_t BYT_IN_REG = 6;
 	const uint8_t STAT_IN_REG = 3;
 	uint8_t *data;
@@ -1,10 +1,26 @@
 #include "Accel.hpp"
+#include "TorqueMap.hpp"
+#include "Probe.hpp"
 #include <stdlib.h>
 
-float Accel::calcDev(void)
+// x 以上の最小の整数 (コンパイル時の定数計算用)
+static constexpr long ceilCount(float x)
 {
-    float def = abs((val[0] - val[1]) * 0.0049f);  // 2つのセンサ値の差
-    return 100 * (def / AMOUNT_OF_MOVEMENT);    // 差をセンサ値の移動量で割って100をかける
+    return (long)x + ((float)(long)x < x ? 1 : 0);
+}
+
+#define RELEASE_SENSOR_VOLTAGE (0.7f) // アクセルを離したと判定する電圧
+
+static constexpr float DEV_PER_COUNT = 100 * (ADC_VOLTAGE_RESOLUTION / AMOUNT_OF_MOVEMENT); // センサ値の差1あたりの偏差[%]
+
+// 以下のセンサ値は電圧との比較と同じ結果になるようにコンパイル時に換算しておく
+static constexpr unsigned short THRESHOLD_DEVIATION_COUNT = ceilCount(THRESHOLD_DEVIATION / DEV_PER_COUNT);  // dev >= THRESHOLD_DEVIATION
+static constexpr unsigned short RELEASE_SENSOR_COUNT = ceilCount(RELEASE_SENSOR_VOLTAGE / ADC_VOLTAGE_RESOLUTION); // v < RELEASE_SENSOR_VOLTAGE
+static constexpr unsigned short MINIMUM_SENSOR_COUNT = ceilCount(MINIMUM_SENSOR_VOLTAGE / ADC_VOLTAGE_RESOLUTION); // v < MINIMUM_SENSOR_VOLTAGE
+
+float Accel::getDev(void)
+{
+    return devCount * DEV_PER_COUNT;    // 差をセンサ値の移動量で割って100をかける
 }
 
 float Accel::calcTorque()
@@ -12,19 +28,33 @@ float Accel::calcTorque()
     if (torqueOutputFlag)
     {
         unsigned short value = val[0] < val[1] ? val[0] : val[1];   // センサ値の小さい方を採用
-        float v = value * 0.0049f;                                  // センサ値→電圧値変換
+        float v = value * ADC_VOLTAGE_RESOLUTION;                   // センサ値→電圧値変換
 
         // センサ信号が想定範囲の電圧に収まっているか
         if (v < MINIMUM_SENSOR_VOLTAGE)
         {
             return 0;
         }
-        else if (v > MAXIMUM_SENSOR_VOLTAGE)
+
+        return TorqueMap::calc(torqueMap, value);
+    }
+
+    return 0;
+}
+
+short Accel::calcFixedTorque()
+{
+    if (torqueOutputFlag)
+    {
+        unsigned short value = val[0] < val[1] ? val[0] : val[1];   // センサ値の小さい方を採用
+
+        // センサ信号が想定範囲の電圧に収まっているか
+        if (value < MINIMUM_SENSOR_COUNT)
         {
-            v = MAXIMUM_SENSOR_VOLTAGE;
+            return 0;
         }
 
-        return MAXIMUM_TORQUE * (v - MINIMUM_SENSOR_VOLTAGE);
+        return TorqueMap::lookup(torqueMap, value);
     }
 
     return 0;
@@ -38,7 +68,7 @@ void Accel::updateTorqueOutputFlag(void)
     chatt[2] = chatt[1];
     chatt[1] = chatt[0];
     //chatt[0] = deviation[0] > THRESHOLD_DEVIATION && deviation[1] > THRESHOLD_DEVIATION;
-    chatt[0] = dev >= THRESHOLD_DEVIATION;
+    chatt[0] = devCount >= THRESHOLD_DEVIATION_COUNT;
     // エラーの立ち上がりでエラーフラグが立つ
     if (lastDevError == 0 && devError == 1)
     {
@@ -59,7 +89,7 @@ void Accel::updateTorqueOutputFlag(void)
     // アクセルを離してポジションが0%に戻ったらエラー解除
     if (devErrorFlag)
     {
-        if (val[0] * 0.0049f < 0.7f && val[1] * 0.0049f < 0.7f)
+        if (val[0] < RELEASE_SENSOR_COUNT && val[1] < RELEASE_SENSOR_COUNT)
         {
             if (lastDevError == 0 && devError == 0)
             {
@@ -76,8 +106,19 @@ void Accel::updateTorqueOutputFlag(void)
 }
 
 Accel::Accel()
-    : val{0, 0}, avr(0), devErrorFlag(1), dev(0), lastDevError(0), devError(0), chatt{1, 1, 1}, torqueOutputFlag(0), torque(0.0f)
+    : val{0, 0}, avr(0), devErrorFlag(1), devCount(0), lastDevError(0), devError(0), chatt{1, 1, 1}, torqueOutputFlag(0), torque(0.0f), fixedTorque(0), torqueMap(TORQUE_MAP_DEFAULT)
+{
+}
+
+unsigned char Accel::setTorqueMap(unsigned char map)
 {
+    if (map >= TORQUE_MAP_NUM)
+    {
+        return 1;
+    }
+
+    torqueMap = map;
+    return 0;
 }
 
 unsigned short Accel::getValue(unsigned char index)
@@ -92,9 +133,11 @@ unsigned short Accel::getValue(unsigned char index)
 
 unsigned char Accel::setValue(unsigned short *value)
 {
+    PROBE_SCOPE("Accel::setValue");
+
     for (int i = 0; i < 2; i++)
     {
-        if (*(value + i) <= 1023)
+        if (*(value + i) <= ACCEL_VALUE_MAX)
         {
             val[i] = *(value + i);
         }
@@ -104,26 +147,31 @@ unsigned char Accel::setValue(unsigned short *value)
         }
     }
 
-    avr = (val[0] + val[1]) / 2.0f;
-    dev = calcDev();
+    avr = (val[0] + val[1]) / 2;        // 平均値
+    devCount = abs(val[0] - val[1]);    // 偏差
 
     updateTorqueOutputFlag();
 
+    fixedTorque = calcFixedTorque();
+#ifndef FIXED_POINT_TORQUE
     torque = calcTorque();
+#endif
 
     return 0;
 }
 
 unsigned char Accel::setValue(int val1, int val2)
 {
+    PROBE_SCOPE("Accel::setValue");
+
     int v[2];
 
     v[0] = val1;
-    v[1] = ((-1) * val2) + 1023;                // 傾きを負から正に変換
+    v[1] = ((-1) * val2) + ACCEL_VALUE_MAX;     // 傾きを負から正に変換
 
     for (int i = 0; i < 2; i++)
     {
-        if (v[i] <= 1023)
+        if (v[i] <= ACCEL_VALUE_MAX)
         {
             val[i] = v[i];
         }
@@ -133,12 +181,15 @@ unsigned char Accel::setValue(int val1, int val2)
         }
     }
 
-    avr = (val[-1] + val[1]) / 2.0f;    // 平均値
-    dev = calcDev();                    // 偏差
+    avr = (val[0] + val[1]) / 2;        // 平均値
+    devCount = abs(val[0] - val[1]);    // 偏差
 
     updateTorqueOutputFlag();
 
+    fixedTorque = calcFixedTorque();
+#ifndef FIXED_POINT_TORQUE
     torque = calcTorque();
+#endif
 
     return 0;
 }
\ No newline at end of file
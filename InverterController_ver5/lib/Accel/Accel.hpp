@@ -2,31 +2,44 @@
 #define _ACCEL_H_
 
 #include "Accel_dfs.hpp"
+#include "TorqueMap_dfs.hpp"
 
 class Accel
 {
 private:
-    int val[2];                     // センサから読み取った値(0~1023)
+    int val[2];                     // センサから読み取った値(0~ACCEL_VALUE_MAX)
     unsigned short avr;             // 2つのセンサ値の平均
     unsigned char devErrorFlag;     // 偏差異常フラグ
-    float dev;                      // センサ値の差異[%]
+    unsigned short devCount;        // センサ値の差(0~ACCEL_VALUE_MAX)
     unsigned char lastDevError;     // ノイズ対策
     unsigned char devError;         // ノイズ対策
     unsigned char chatt[3];         // ノイズ対策
     unsigned char torqueOutputFlag; // トルク出力フラグ
     float torque;                   // アクセル開度から計算したトルク
-
-    float calcDev(void);
+    short fixedTorque;              // アクセル開度から計算したトルク [1/FIXED_TORQUE_RESOLUTION Nm]
+    unsigned char torqueMap;        // ペダル→トルクのマップ (TORQUE_MAP_*)
 
     /**
      * @fn      calcTorque
      *
      * @brief   センサ値にもとづいて指令トルクを決定する
+     *          マップの折れ線を float で計算する
      *
      * @return  指令トルク（0~60）
     */
     float calcTorque();
 
+    /**
+     * @fn      calcFixedTorque
+     *
+     * @brief   センサ値にもとづいて指令トルクを整数演算だけで決定する
+     *          コンパイル時に作ったマップの表 (TorqueMap) を引いて補間する
+     *          calcTorque() の結果を 1/FIXED_TORQUE_RESOLUTION Nm 単位に四捨五入した値とほぼ同じになる
+     *
+     * @return  指令トルク [1/FIXED_TORQUE_RESOLUTION Nm]
+    */
+    short calcFixedTorque();
+
     /**
      * @fn  updateTorqueOutputFlag
      *
@@ -44,7 +57,7 @@ public:
 
     /**
      * アクセルセンサから読み取った値をセットする
-     * analogReadで読み取った値をそのままセット
+     * AdcScan で読み取った値をそのままセット
      * 要素数2の配列に格納してそのポインタを渡す
      * 2つのセンサの特性が同じ
     */
@@ -53,7 +66,7 @@ public:
     /**
      * @fn      setValue
      *
-     * @brief   アクセルセンサの値をセット（0~1023）
+     * @brief   アクセルセンサの値をセット（0~ACCEL_VALUE_MAX）
      *          2つのセンサの特性が真逆（絶対値が同じで傾きが正負反対）
      *
      * @param   val1 - 特性が正の傾き
@@ -65,11 +78,36 @@ public:
 
     inline unsigned char getDevErrorFlag() { return devErrorFlag; }
 
+#ifdef FIXED_POINT_TORQUE
+    inline float getTorque() { return fixedTorque * (1.0f / FIXED_TORQUE_RESOLUTION); }
+#else
     inline float getTorque() { return torque; }
+#endif
+
+    // 戻り値は 1/FIXED_TORQUE_RESOLUTION Nm 単位のトルク
+    inline short getFixedTorque() { return fixedTorque; }
 
     inline unsigned char getTorqueOutputFlag() { return torqueOutputFlag; }
 
-    inline float getDev() { return dev; }
+    /**
+     * @fn      setTorqueMap
+     *
+     * @brief   ペダル→トルクのマップを切り替える (TorqueMap_dfs.hpp)
+     *          次の setValue から使う
+     *
+     * @param   map - TORQUE_MAP_*
+     *
+     * @return  切り替えた(0), 番号が範囲外(1)
+    */
+    unsigned char setTorqueMap(unsigned char map);
+
+    inline unsigned char getTorqueMap() { return torqueMap; }
+
+    // センサ値の差異[%]
+    float getDev(void);
+
+    // センサ値の差(0~ACCEL_VALUE_MAX)
+    inline unsigned short getDevCount(void) { return devCount; }
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef _ACCEL_DFS_H_
 #define _ACCEL_DFS_H_
 
+#include "AdcFilter_dfs.hpp"
+
 #define MINIMUM_SENSOR_VOLTAGE (0.3f)
 #define MAXIMUM_SENSOR_VOLTAGE (1.3f)
 
@@ -9,4 +11,23 @@
 #define MAXIMUM_TORQUE (2.0f)
 
 #define AMOUNT_OF_MOVEMENT (1.0f)  // ペダルの移動量
+
+/**
+ * センサ値は AdcScan で間引いた値 (AdcFilter_dfs.hpp の ADC_FILTER_EXTRA_BITS だけ 10bit より細かい)
+ */
+#define ACCEL_VALUE_MAX (ADC_FILTER_MAX) // センサ値の最大
+#define ADC_VOLTAGE_RESOLUTION (0.0049f / (1 << ADC_FILTER_EXTRA_BITS)) // センサ値1あたりの電圧[V]
+
+/**
+ * 固定小数点トルクモード
+ * 定義するとアクセルセンサ値からトルク指令値までを整数演算だけで計算する
+ * トルクは 1/FIXED_TORQUE_RESOLUTION Nm 単位 (EV-ECU1 要求トルクの分解能 0.5 Nm に合わせる)
+ * ホストPCの -O2 (InverterHost の env:pipeline) では float 13~18 ns に対して 9~15 ns
+ * AVR の時間は測っていないので, LoopProfiler の 'p' で STAGE_ACCEL, STAGE_INVERTER を比べること
+ */
+#define FIXED_POINT_TORQUE
+
+#ifndef FIXED_TORQUE_RESOLUTION
+#define FIXED_TORQUE_RESOLUTION (2)
+#endif
 #endif
\ No newline at end of file
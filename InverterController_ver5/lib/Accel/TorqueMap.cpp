@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include "TorqueMap.hpp"
+
+static constexpr TORQUE_MAP_POINT LINEAR_POINTS[] = {TORQUE_MAP_LINEAR_POINTS};
+static constexpr TORQUE_MAP_POINT RAIN_POINTS[] = {TORQUE_MAP_RAIN_POINTS};
+static constexpr TORQUE_MAP_POINT ENDURANCE_POINTS[] = {TORQUE_MAP_ENDURANCE_POINTS};
+static constexpr TORQUE_MAP_POINT ACCEL_POINTS[] = {TORQUE_MAP_ACCEL_POINTS};
+
+#define TORQUE_MAP_COUNT(points) ((unsigned char)(sizeof(points) / sizeof(points[0])))
+
+// TORQUE_MAP_* の番号の順
+static const TORQUE_MAP_POINT *const MAP_POINTS[TORQUE_MAP_NUM] = {LINEAR_POINTS, RAIN_POINTS, ENDURANCE_POINTS, ACCEL_POINTS};
+static const unsigned char MAP_COUNTS[TORQUE_MAP_NUM] = {
+    TORQUE_MAP_COUNT(LINEAR_POINTS), TORQUE_MAP_COUNT(RAIN_POINTS), TORQUE_MAP_COUNT(ENDURANCE_POINTS), TORQUE_MAP_COUNT(ACCEL_POINTS)};
+
+static_assert(TORQUE_MAP_COUNT(LINEAR_POINTS) <= TORQUE_MAP_POINT_MAX && TORQUE_MAP_COUNT(RAIN_POINTS) <= TORQUE_MAP_POINT_MAX &&
+                  TORQUE_MAP_COUNT(ENDURANCE_POINTS) <= TORQUE_MAP_POINT_MAX && TORQUE_MAP_COUNT(ACCEL_POINTS) <= TORQUE_MAP_POINT_MAX,
+              "too many points in a torque map");
+
+// トルク 100% [1/FIXED_TORQUE_RESOLUTION Nm] の Q8
+static constexpr float TORQUE_FULL_Q8 = MAXIMUM_TORQUE * (MAXIMUM_SENSOR_VOLTAGE - MINIMUM_SENSOR_VOLTAGE) * FIXED_TORQUE_RESOLUTION * 256.0f;
+
+static_assert(TORQUE_FULL_Q8 <= 65535.0f, "MAXIMUM_TORQUE is too large for the torque map table");
+
+// センサ値 → ペダル位置[%] (範囲外は 0, 100 にする)
+static constexpr float pedalOf(float value)
+{
+    return value * ADC_VOLTAGE_RESOLUTION <= MINIMUM_SENSOR_VOLTAGE   ? 0.0f
+           : value * ADC_VOLTAGE_RESOLUTION >= MAXIMUM_SENSOR_VOLTAGE ? 100.0f
+                                                                      : 100.0f * (value * ADC_VOLTAGE_RESOLUTION - MINIMUM_SENSOR_VOLTAGE) / (MAXIMUM_SENSOR_VOLTAGE - MINIMUM_SENSOR_VOLTAGE);
+}
+
+// 折れ線 points (n 点) のペダル位置 pedal のトルク[%]
+static constexpr float interpolate(const TORQUE_MAP_POINT *points, unsigned char n, float pedal)
+{
+    return pedal <= points[0].pedal || n == 1 ? points[0].torque
+           : pedal <= points[1].pedal        ? points[0].torque + (points[1].torque - points[0].torque) * (pedal - points[0].pedal) / (points[1].pedal - points[0].pedal)
+                                             : interpolate(points + 1, n - 1, pedal);
+}
+
+// 表の i 番目 (センサ値 i << TORQUE_MAP_SHIFT) のトルク [1/FIXED_TORQUE_RESOLUTION Nm] の Q8
+static constexpr unsigned short tableEntry(const TORQUE_MAP_POINT *points, unsigned char n, unsigned short i)
+{
+    return (unsigned short)(TORQUE_FULL_Q8 * interpolate(points, n, pedalOf((float)((unsigned long)i << TORQUE_MAP_SHIFT))) / 100.0f + 0.5f);
+}
+
+// 0, 1, ..., TORQUE_MAP_SIZE - 1 の並び (テンプレートの再帰で作る)
+template <unsigned short... I>
+struct TorqueIndex
+{
+};
+
+template <unsigned short N, unsigned short... I>
+struct MakeTorqueIndex : MakeTorqueIndex<N - 1, N - 1, I...>
+{
+};
+
+template <unsigned short... I>
+struct MakeTorqueIndex<0, I...>
+{
+    typedef TorqueIndex<I...> type;
+};
+
+struct TORQUE_MAP_TABLE
+{
+    unsigned short row[TORQUE_MAP_NUM][TORQUE_MAP_SIZE]; // TORQUE_MAP_* の番号の順
+};
+
+// 0 ~ TORQUE_MAP_SIZE - 1 の全ての点を展開して表を作る
+template <unsigned short... I>
+static constexpr TORQUE_MAP_TABLE makeTable(TorqueIndex<I...>)
+{
+    return TORQUE_MAP_TABLE{{{tableEntry(LINEAR_POINTS, TORQUE_MAP_COUNT(LINEAR_POINTS), I)...},
+                             {tableEntry(RAIN_POINTS, TORQUE_MAP_COUNT(RAIN_POINTS), I)...},
+                             {tableEntry(ENDURANCE_POINTS, TORQUE_MAP_COUNT(ENDURANCE_POINTS), I)...},
+                             {tableEntry(ACCEL_POINTS, TORQUE_MAP_COUNT(ACCEL_POINTS), I)...}}};
+}
+
+// constexpr なので全ての値がコンパイル時に決まり, そのまま Flash に置かれる
+static constexpr TORQUE_MAP_TABLE TABLE PROGMEM = makeTable(MakeTorqueIndex<TORQUE_MAP_SIZE>::type());
+
+short TorqueMap::lookup(unsigned char map, unsigned short value)
+{
+    if (map >= TORQUE_MAP_NUM)
+    {
+        return 0;
+    }
+    if (value > ACCEL_VALUE_MAX)
+    {
+        value = ACCEL_VALUE_MAX;
+    }
+
+    const unsigned short *row = TABLE.row[map];
+    const unsigned char i = value >> TORQUE_MAP_SHIFT;
+    const unsigned char f = value & ((1 << TORQUE_MAP_SHIFT) - 1);
+    const long a = pgm_read_word(&row[i]);
+    const long b = pgm_read_word(&row[i + 1]);
+
+    // Q8 の2点を補間して 1/FIXED_TORQUE_RESOLUTION Nm に四捨五入する
+    return (short)(((a << TORQUE_MAP_SHIFT) + (b - a) * f + (1L << (TORQUE_MAP_SHIFT + 7))) >> (TORQUE_MAP_SHIFT + 8));
+}
+
+float TorqueMap::calc(unsigned char map, unsigned short value)
+{
+    if (map >= TORQUE_MAP_NUM)
+    {
+        return 0;
+    }
+
+    const float full = MAXIMUM_TORQUE * (MAXIMUM_SENSOR_VOLTAGE - MINIMUM_SENSOR_VOLTAGE);
+
+    return full * interpolate(MAP_POINTS[map], MAP_COUNTS[map], pedalOf(value)) / 100.0f;
+}
@@ -0,0 +1,51 @@
+#ifndef _TORQUE_MAP_H_
+#define _TORQUE_MAP_H_
+
+#include "Accel_dfs.hpp"
+#include "TorqueMap_dfs.hpp"
+
+/**
+ * センサ値 → トルク [1/FIXED_TORQUE_RESOLUTION Nm] の表引き
+ *
+ * TorqueMap_dfs.hpp の折れ線から, センサ値を 2^TORQUE_MAP_SHIFT 刻みにした
+ * TORQUE_MAP_SIZE 点の表をコンパイル時に作って PROGMEM に置く
+ * 表引きはセンサ値の上位 8bit で隣り合う2点を選び, 下位 bit で直線補間する (折れ線の探索はしない)
+ * 表の値は Q8 (1/256) で持つので, 補間の誤差は1刻みの中の折れ目の近くだけになる
+ */
+#define TORQUE_MAP_SHIFT (ADC_FILTER_EXTRA_BITS + 2)   // 表の1刻みのセンサ値 (2^TORQUE_MAP_SHIFT)
+#define TORQUE_MAP_SIZE ((ACCEL_VALUE_MAX >> TORQUE_MAP_SHIFT) + 2)
+
+struct TORQUE_MAP_POINT
+{
+    float pedal;  // [%]
+    float torque; // [%]
+};
+
+class TorqueMap
+{
+public:
+    /**
+     * @fn      lookup
+     *
+     * @brief   表を引いてトルクを求める (整数演算だけ)
+     *
+     * @param   map - TORQUE_MAP_*
+     * @param   value - センサ値 (0~ACCEL_VALUE_MAX)
+     *
+     * @return  トルク [1/FIXED_TORQUE_RESOLUTION Nm] (四捨五入)
+     *          Inverter に渡すときに符号を反転するので, 切り捨てだと float の経路
+     *          (EV-ECU1 の Normal Value への変換で負の方向に丸める) と最大 2 LSB ずれる
+     */
+    static short lookup(unsigned char map, unsigned short value);
+
+    /**
+     * @fn      calc
+     *
+     * @brief   折れ線を float で直接計算する (表を作る計算と同じ, 比較用)
+     *
+     * @return  トルク [Nm]
+     */
+    static float calc(unsigned char map, unsigned short value);
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _TORQUE_MAP_DFS_H_
+#define _TORQUE_MAP_DFS_H_
+
+/**
+ * ペダル→トルクのマップ
+ * 折れ線の点 {ペダル位置[%], トルク[%]} をペダル位置の小さい順に並べる (点は TORQUE_MAP_POINT_MAX まで)
+ *  ペダル位置 0% : MINIMUM_SENSOR_VOLTAGE, 100% : MAXIMUM_SENSOR_VOLTAGE
+ *  トルク 100% : MAXIMUM_TORQUE * (MAXIMUM_SENSOR_VOLTAGE - MINIMUM_SENSOR_VOLTAGE) [Nm] (以前の直線の最大)
+ * 最初の点より前は最初の点, 最後の点より後は最後の点のトルクになる
+ * 点を変えるとコンパイル時に表が作り直される
+ */
+#define TORQUE_MAP_LINEAR_POINTS {0, 0}, {100, 100}                                  // 以前の calcTorque と同じ直線
+#define TORQUE_MAP_RAIN_POINTS {0, 0}, {30, 8}, {70, 40}, {100, 60}                  // 踏み始めを穏やかに, 最大も抑える
+#define TORQUE_MAP_ENDURANCE_POINTS {0, 0}, {20, 10}, {80, 70}, {100, 80}            // 最大を抑えて電力を節約
+#define TORQUE_MAP_ACCEL_POINTS {0, 0}, {10, 15}, {50, 75}, {80, 100}, {100, 100}    // 踏み始めから強く
+
+// マップの番号 (Accel::setTorqueMap)
+#define TORQUE_MAP_LINEAR (0)
+#define TORQUE_MAP_RAIN (1)
+#define TORQUE_MAP_ENDURANCE (2)
+#define TORQUE_MAP_ACCEL (3)
+#define TORQUE_MAP_NUM (4)
+
+#define TORQUE_MAP_DEFAULT (TORQUE_MAP_LINEAR) // 起動時のマップ
+
+#define TORQUE_MAP_POINT_MAX (8)
+
+#endif
@@ -0,0 +1,17 @@
+#include "AdcFilter.hpp"
+
+static_assert(ADC_FILTER_EXTRA_BITS <= 3, "ADC_FILTER_EXTRA_BITS must be 0 to 3 (the sum is 16bit)");
+
+AdcFilter::AdcFilter()
+{
+    reset();
+}
+
+void AdcFilter::reset(void)
+{
+    sum = 0;
+    count = 0;
+    primed = 0;
+    state = 0;
+    value = 0;
+}
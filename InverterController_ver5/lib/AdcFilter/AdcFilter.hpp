@@ -0,0 +1,68 @@
+#ifndef _ADC_FILTER_H_
+#define _ADC_FILTER_H_
+
+#include "AdcFilter_dfs.hpp"
+
+/**
+ * 10bit の ADC 変換値を ADC_FILTER_OVERSAMPLE 回ずつまとめて間引き (ブロック平均),
+ * ADC_FILTER_EXTRA_BITS だけ分解能を増やす
+ * 間引いた値には1次IIRフィルタをかける (ADC_FILTER_IIR_SHIFT)
+ * 整数演算だけなので ADC 変換完了割り込みの中で呼べる
+ */
+class AdcFilter
+{
+private:
+    unsigned short sum;     // 間引き中の変換値の合計
+    unsigned char count;    // 間引き中の変換値の数
+    unsigned char primed;   // IIR の初期値を入れたか
+    unsigned long state;    // IIR の状態 (出力 << ADC_FILTER_IIR_SHIFT)
+    unsigned short value;   // 最後の出力
+
+public:
+    AdcFilter();
+
+    /**
+     * @fn      add
+     *
+     * @brief   変換値を1つ加える
+     *
+     * @param   sample - 10bit の変換値 (0~1023)
+     *
+     * @return  新しい出力ができた(1), まだ(0)
+     */
+    inline unsigned char add(unsigned short sample)
+    {
+        sum += sample;
+        if (++count < ADC_FILTER_OVERSAMPLE)
+        {
+            return 0;
+        }
+
+        const unsigned short decimated = sum >> ADC_FILTER_EXTRA_BITS;
+        sum = 0;
+        count = 0;
+
+#if ADC_FILTER_IIR_SHIFT > 0
+        // 最初の出力で状態を埋めて, 0 からの立ち上がりを出さない
+        if (!primed)
+        {
+            state = (unsigned long)decimated << ADC_FILTER_IIR_SHIFT;
+            primed = 1;
+        }
+        state -= state >> ADC_FILTER_IIR_SHIFT;
+        state += decimated;
+        value = state >> ADC_FILTER_IIR_SHIFT;
+#else
+        value = decimated;
+#endif
+
+        return 1;
+    }
+
+    // 最後の出力 (0~ADC_FILTER_MAX)
+    inline unsigned short get(void) { return value; }
+
+    void reset(void);
+};
+
+#endif
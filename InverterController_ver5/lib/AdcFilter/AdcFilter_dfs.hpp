@@ -0,0 +1,29 @@
+#ifndef _ADC_FILTER_DFS_H_
+#define _ADC_FILTER_DFS_H_
+
+/**
+ * オーバーサンプリングで増やす bit 数 (0~3)
+ * 4^ADC_FILTER_EXTRA_BITS 回の変換値を足して 2^ADC_FILTER_EXTRA_BITS で割る
+ *  0 : 間引きなし (10bit)
+ *  2 : 16回で1つ (12bit, 0~4092)
+ * 1LSB 程度以上のノイズが乗っていないと分解能は増えない
+ */
+#define ADC_FILTER_EXTRA_BITS (2)
+
+/**
+ * 間引いた後の1次IIRフィルタ y += (x - y) / 2^ADC_FILTER_IIR_SHIFT (0 で使わない)
+ * ノイズは更に減るが, 遅れが約 (2^ADC_FILTER_IIR_SHIFT - 1) 出力分増える
+ *
+ * 遅れの予算はアクセル→トルクの経路で TASK_PEDAL_PERIOD (5 ms) 程度とし, 1 にしている
+ * ノイズ 2 LSB のときの InverterHost の env:filter の値 (有効ビット, ステップの50%までの遅れ)
+ *  1 : 9.8 bit, 3.8 ms  <- 今の設定
+ *  3 : 10.7 bit, 14.3 ms (遅れが予算の約3倍)
+ * 目標の 11~12 bit には届かない. 平均でノイズを 1/15 にするには約 225 回の変換が要るが,
+ * 5 ms の間にできる変換は 1チャンネルあたり 32 回 (52 us x 3チャンネル) で, 1/5.7 にしかならない
+ */
+#define ADC_FILTER_IIR_SHIFT (1)
+
+#define ADC_FILTER_OVERSAMPLE (1 << (2 * ADC_FILTER_EXTRA_BITS)) // 1つの出力に使う変換の回数
+#define ADC_FILTER_MAX (1023 << ADC_FILTER_EXTRA_BITS)           // 出力の最大値
+
+#endif
@@ -0,0 +1,205 @@
+#include "AdcScan.hpp"
+#include "Probe.hpp"
+
+AdcScan ADCScan;
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+
+// ADPS2:0 の設定値
+static constexpr unsigned char prescalerBits(unsigned short div)
+{
+    return div >= 128 ? 0x07 : div >= 64 ? 0x06 : div >= 32 ? 0x05 : div >= 16 ? 0x04 : 0x03;
+}
+
+static constexpr unsigned char ADC_SCAN_ADPS = prescalerBits(ADC_SCAN_AVR_PRESCALER);
+
+// A0 などのピン番号から ADC のチャンネル番号に変換する
+static unsigned char toChannel(unsigned char pin)
+{
+    return pin >= A0 ? pin - A0 : pin;
+}
+
+ISR(ADC_vect)
+{
+    ADCScan.onComplete();
+}
+#endif
+
+AdcScan::AdcScan()
+    : pins{0}, channelCount(0), samples{{0}}, front(0), index(0), scanCount(0), running(0)
+{
+}
+
+unsigned char AdcScan::addChannel(unsigned char pin)
+{
+    if (running || channelCount >= ADC_SCAN_MAX)
+    {
+        return ADC_SCAN_NO_CHANNEL;
+    }
+
+    pins[channelCount] = pin;
+
+    return channelCount++;
+}
+
+void AdcScan::startConversion(void)
+{
+#if defined(__AVR__)
+    const unsigned char ch = toChannel(pins[index]);
+
+    // 基準電圧は AVcc (analogReference(DEFAULT) と同じ)
+    ADMUX = (1 << REFS0) | (ch & 0x07);
+#if defined(MUX5)
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((ch >> 3) & 0x01) << MUX5);
+#endif
+    ADCSRA |= (1 << ADSC);
+#endif
+}
+
+void AdcScan::begin(void)
+{
+    if (channelCount == 0)
+    {
+        return;
+    }
+
+    front = 0;
+    index = 0;
+    scanCount = 0;
+    for (unsigned char i = 0; i < channelCount; i++)
+    {
+        samples[0][i] = 0;
+        samples[1][i] = 0;
+        filters[i].reset();
+    }
+
+#if defined(__AVR__)
+    // アナログ入力にしたピンのデジタル入力バッファを切る (ノイズと消費電流の対策)
+    for (unsigned char i = 0; i < channelCount; i++)
+    {
+        const unsigned char ch = toChannel(pins[i]);
+
+        if (ch < 8)
+        {
+            DIDR0 |= 1 << ch;
+        }
+#if defined(DIDR2)
+        else
+        {
+            DIDR2 |= 1 << (ch - 8);
+        }
+#endif
+    }
+
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | ADC_SCAN_ADPS;
+    running = 1;
+    startConversion();
+#else
+    running = 1;
+#endif
+}
+
+void AdcScan::stop(void)
+{
+#if defined(__AVR__)
+    ADCSRA &= ~(1 << ADIE);
+    while (ADCSRA & (1 << ADSC))
+        ;
+    // wiring.c の init() と同じ設定 (16MHz / 128)
+    ADCSRA = (1 << ADEN) | 0x07;
+#endif
+    running = 0;
+}
+
+void AdcScan::service(void)
+{
+#if !defined(__AVR__)
+    if (!running)
+    {
+        return;
+    }
+
+    PROBE_SCOPE("AdcScan::service");
+
+    // チャンネルを交互に読んで, 同じ出力に入る変換の時刻を揃える
+    for (unsigned char n = 0; n < ADC_SCAN_R4_ROUNDS; n++)
+    {
+        const unsigned char back = front ^ 1;
+        unsigned char ready = 0;
+
+        for (unsigned char i = 0; i < channelCount; i++)
+        {
+            ready = filters[i].add(analogRead(pins[i]));
+            if (ready)
+            {
+                samples[back][i] = filters[i].get();
+            }
+        }
+
+        // 全チャンネルが同じ回数ずつ読まれるので, 最後のチャンネルが揃えば全て揃っている
+        if (ready)
+        {
+            noInterrupts();
+            front = back;
+            scanCount++;
+            interrupts();
+        }
+    }
+#endif
+}
+
+void AdcScan::onComplete(void)
+{
+#if defined(__AVR__)
+    const unsigned char back = front ^ 1;
+    const unsigned char ready = filters[index].add(ADC);
+
+    if (ready)
+    {
+        samples[back][index] = filters[index].get();
+    }
+
+    // 全チャンネルが同じ回数ずつ変換されるので, 最後のチャンネルが揃えば全て揃っている
+    if (++index >= channelCount)
+    {
+        index = 0;
+        if (ready)
+        {
+            front = back;
+            scanCount++;
+        }
+    }
+
+    startConversion();
+#endif
+}
+
+unsigned short AdcScan::read(unsigned char ch)
+{
+    if (ch >= channelCount)
+    {
+        return 0;
+    }
+
+    noInterrupts();
+    const unsigned short value = samples[front][ch];
+    interrupts();
+
+    return value;
+}
+
+unsigned short AdcScan::readAll(unsigned short *values)
+{
+    // 割り込みを止めている間に表と裏が入れ替わらないので, 全て同じ間引きの値になる
+    noInterrupts();
+    const unsigned char f = front;
+    for (unsigned char i = 0; i < channelCount; i++)
+    {
+        values[i] = samples[f][i];
+    }
+    const unsigned short count = scanCount;
+    interrupts();
+
+    return count;
+}
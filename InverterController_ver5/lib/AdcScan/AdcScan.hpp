@@ -0,0 +1,82 @@
+#ifndef _ADC_SCAN_H_
+#define _ADC_SCAN_H_
+
+#include <Arduino.h>
+#include "AdcScan_dfs.hpp"
+#include "AdcFilter.hpp"
+
+/**
+ * 登録したアナログ入力を順番に変換し続ける
+ *  AVR : ADC 変換完了割り込みで次のチャンネルの変換を開始する (loop() 側は待たない)
+ *  その他 (R4) : service() を呼んだときに analogRead で全チャンネルを ADC_SCAN_R4_ROUNDS 回ずつ読む
+ *                (待つ時間を抑えるため, loop() から何度も呼んで少しずつ溜める)
+ *
+ * 変換値はチャンネルごとの AdcFilter で間引いてから使う (AdcFilter_dfs.hpp)
+ * 間引いた結果を裏のバッファに書き, 全チャンネル揃ったら表と入れ替える
+ * read() で読む値は常に同じ1周で変換したものになる
+ * 動作中は analogRead を使わないこと (ADC の設定が変わる)
+ */
+class AdcScan
+{
+private:
+    unsigned char pins[ADC_SCAN_MAX];
+    unsigned char channelCount;
+    volatile unsigned short samples[2][ADC_SCAN_MAX];
+    volatile unsigned char front;           // 読み出す側のバッファ
+    volatile unsigned char index;           // 変換中のチャンネル
+    volatile unsigned short scanCount;      // 全チャンネルの間引きが揃った回数
+    AdcFilter filters[ADC_SCAN_MAX];
+    unsigned char running;
+
+    // index のチャンネルの変換を開始する
+    void startConversion(void);
+
+public:
+    AdcScan();
+
+    /**
+     * @fn      addChannel
+     *
+     * @brief   変換するアナログ入力を登録する (begin() の前に呼ぶ)
+     *
+     * @param   pin - A0 など
+     *
+     * @return  チャンネルの番号 (read() の引数), 一杯のときは ADC_SCAN_NO_CHANNEL
+     */
+    unsigned char addChannel(unsigned char pin);
+
+    // 変換を開始する. 最初の間引きが終わるまで read() は 0 を返す
+    void begin(void);
+
+    // 変換を止めて ADC を analogRead の設定に戻す
+    void stop(void);
+
+    /**
+     * AVR 以外で全チャンネルを ADC_SCAN_R4_ROUNDS 回ずつ読む (AVR では何もしない)
+     * 間引きが揃ったら読み出す側と入れ替える. loop() から毎回呼ぶ
+     */
+    void service(void);
+
+    // ADC 変換完了割り込みから呼ぶ
+    void onComplete(void);
+
+    // 最後に間引いた ch の値 (0~ADC_FILTER_MAX)
+    unsigned short read(unsigned char ch);
+
+    /**
+     * @fn      readAll
+     *
+     * @brief   最後に間引いた全チャンネルの値をまとめて読む
+     *
+     * @param   values - 登録したチャンネル数の要素を持つ配列
+     *
+     * @return  間引きが揃った回数 (前回と同じなら新しい値は無い)
+     */
+    unsigned short readAll(unsigned short *values);
+
+    inline unsigned char getChannelCount(void) { return channelCount; }
+};
+
+extern AdcScan ADCScan;
+
+#endif
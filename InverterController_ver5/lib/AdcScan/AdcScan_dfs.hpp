@@ -0,0 +1,30 @@
+#ifndef _ADC_SCAN_DFS_H_
+#define _ADC_SCAN_DFS_H_
+
+#define ADC_SCAN_MAX (4)              // 登録できるチャンネルの数
+#define ADC_SCAN_NO_CHANNEL (0xFF)    // addChannel が失敗したときの戻り値
+
+/**
+ * AVR の ADC クロックのプリスケーラ (16MHz / ADC_SCAN_AVR_PRESCALER)
+ *  128 : 125 kHz, 1回の変換 104 us (analogRead と同じ)
+ *   64 : 250 kHz, 1回の変換 52 us
+ *   32 : 500 kHz, 1回の変換 26 us
+ * 続けて変換するチャンネルの間の時間差は1回の変換時間になる
+ * 200 kHz を超えると10bitの精度が少し落ちる
+ * 新しい値ができる間隔は 変換時間 x チャンネル数 x ADC_FILTER_OVERSAMPLE
+ * (64, 3チャンネル, 16回で 2.5 ms. TASK_PEDAL_PERIOD より短くすること)
+ */
+#define ADC_SCAN_AVR_PRESCALER (64)
+
+/**
+ * AVR 以外 (R4) で service() を1回呼んだときに読む周回数 (1周 = 全チャンネルを1回ずつ)
+ * R4 では変換完了の割り込みを使わず, service() が analogRead で変換の完了を待つ
+ * 1回の呼び出しで止まる時間の上限は
+ *  ADC_SCAN_R4_ROUNDS x チャンネル数 x analogRead 1回の時間
+ * で, main.cpp は3チャンネルなので analogRead 3回分になる
+ * analogRead 1回の時間は実機で測っていないので, PROBE_SCOPE の "AdcScan::service" を 'q' で見て確認すること
+ * 新しい値ができるのは ADC_FILTER_OVERSAMPLE / ADC_SCAN_R4_ROUNDS 回の呼び出しごと
+ */
+#define ADC_SCAN_R4_ROUNDS (1)
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _DEBOUNCER_H_
+#define _DEBOUNCER_H_
+
+#include "Debouncer_dfs.hpp"
+
+/**
+ * 複数の入力のチャタリング対策をビット演算でまとめて行う
+ * Bits (unsigned char / unsigned short / unsigned long) の1ビットが1つの入力
+ *
+ * 各入力の過去 DEBOUNCE_SAMPLES 回の値を, 回ごとに1語ずつ縦に並べて持つ
+ * ON/OFF の判定と立ち上がり/立ち下がりの検出は入力の数によらず数命令で終わる
+ * 判定は Switch::updateState と同じ (前回までの DEBOUNCE_SAMPLES 回が全て 1 なら ON)
+ *
+ * 例) Debouncer<unsigned short> switches;
+ *     switches.update(inputPins.read());
+ *     if (switches.getFlag(1 << bit)) ...
+ */
+template <class Bits>
+class Debouncer
+{
+private:
+    Bits history[DEBOUNCE_SAMPLES]; // history[0] が最新
+    Bits state;                     // 各入力の ON/OFF
+    Bits rising;                    // 今回 ON になった入力
+    Bits falling;                   // 今回 OFF になった入力
+    Bits flags;                     // ON になったら立ち, resetFlag まで残る (Switch の swFlag)
+
+public:
+    Debouncer() : history{0}, state(0), rising(0), falling(0), flags(0) {}
+
+    /**
+     * @fn      update
+     *
+     * @brief   全ての入力の値を1回分加える (Switch::updateState と同じ周期で呼ぶ)
+     *
+     * @param   sample - 入力ごとの読み取った値 (1 : ON)
+     */
+    inline void update(Bits sample)
+    {
+        const Bits last = state;
+        Bits all = history[0];
+
+        for (unsigned char i = 1; i < DEBOUNCE_SAMPLES; i++)
+        {
+            all &= history[i];
+        }
+        for (unsigned char i = DEBOUNCE_SAMPLES - 1; i > 0; i--)
+        {
+            history[i] = history[i - 1];
+        }
+        history[0] = sample;
+
+        state = all;
+        rising = state & ~last;
+        falling = last & ~state;
+        flags |= rising;
+    }
+
+    inline Bits getState(void) { return state; }
+    inline Bits getRising(void) { return rising; }
+    inline Bits getFalling(void) { return falling; }
+    inline Bits getFlags(void) { return flags; }
+
+    // mask のどれかのフラグが立っているか (Switch::getSWFlag)
+    inline unsigned char getFlag(Bits mask) { return (flags & mask) != 0; }
+
+    inline void resetFlag(Bits mask) { flags &= ~mask; }
+    inline void setFlag(Bits mask) { flags |= mask; }
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _DEBOUNCER_DFS_H_
+#define _DEBOUNCER_DFS_H_
+
+/**
+ * 何回続けて 1 を読んだら ON とみなすか (Switch の chatt[3] と同じ 3)
+ * OFF は1回 0 を読めばすぐに OFF になる
+ */
+#define DEBOUNCE_SAMPLES (3)
+
+#endif
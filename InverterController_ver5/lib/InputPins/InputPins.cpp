@@ -0,0 +1,81 @@
+#include "InputPins.hpp"
+
+InputPins::InputPins()
+    : pinCount(0), invert(0)
+#if defined(__AVR__)
+    , ports{nullptr}, portCount(0), portIndex{0}, masks{0}
+#else
+    , pins{0}
+#endif
+{
+}
+
+unsigned char InputPins::add(unsigned char pin, unsigned char polarity)
+{
+    if (pinCount >= INPUT_PINS_MAX)
+    {
+        return INPUT_PINS_NO_BIT;
+    }
+
+#if defined(__AVR__)
+    volatile unsigned char *port = portInputRegister(digitalPinToPort(pin));
+    unsigned char p = 0;
+
+    while (p < portCount && ports[p] != port)
+    {
+        p++;
+    }
+    if (p == portCount)
+    {
+        if (portCount >= INPUT_PINS_PORT_MAX)
+        {
+            return INPUT_PINS_NO_BIT;
+        }
+        ports[portCount++] = port;
+    }
+
+    portIndex[pinCount] = p;
+    masks[pinCount] = digitalPinToBitMask(pin);
+#else
+    pins[pinCount] = pin;
+#endif
+
+    if (polarity == INPUT_ACTIVE_LOW)
+    {
+        invert |= 1U << pinCount;
+    }
+
+    return pinCount++;
+}
+
+unsigned short InputPins::read(void)
+{
+    unsigned short bits = 0;
+
+#if defined(__AVR__)
+    unsigned char values[INPUT_PINS_PORT_MAX];
+
+    // 同じポートのピンは同じ時刻の値になる
+    for (unsigned char p = 0; p < portCount; p++)
+    {
+        values[p] = *ports[p];
+    }
+    for (unsigned char i = 0; i < pinCount; i++)
+    {
+        if (values[portIndex[i]] & masks[i])
+        {
+            bits |= 1U << i;
+        }
+    }
+#else
+    for (unsigned char i = 0; i < pinCount; i++)
+    {
+        if (digitalRead(pins[i]))
+        {
+            bits |= 1U << i;
+        }
+    }
+#endif
+
+    return bits ^ invert;
+}
@@ -0,0 +1,47 @@
+#ifndef _INPUT_PINS_H_
+#define _INPUT_PINS_H_
+
+#include <Arduino.h>
+#include "InputPins_dfs.hpp"
+
+/**
+ * 複数のデジタル入力をまとめて読み, 登録した順に 1 ビットずつ詰めて返す (Debouncer に渡す)
+ *  AVR : 登録したピンのあるポートの PINx を1回ずつ読んでビットを取り出す
+ *  その他 (R4, ホストPC) : digitalRead で1本ずつ読む
+ */
+class InputPins
+{
+private:
+    unsigned char pinCount;
+    unsigned short invert;                                  // INPUT_ACTIVE_LOW のピンのビット
+#if defined(__AVR__)
+    volatile unsigned char *ports[INPUT_PINS_PORT_MAX];     // 読むポートの PINx
+    unsigned char portCount;
+    unsigned char portIndex[INPUT_PINS_MAX];                // ピンのある ports の番号
+    unsigned char masks[INPUT_PINS_MAX];                    // ピンのポートの中のビット
+#else
+    unsigned char pins[INPUT_PINS_MAX];
+#endif
+
+public:
+    InputPins();
+
+    /**
+     * @fn      add
+     *
+     * @brief   入力ピンを登録する (pinMode は呼ぶ側で行う)
+     *
+     * @param   pin - ピン番号
+     * @param   polarity - INPUT_ACTIVE_HIGH or INPUT_ACTIVE_LOW
+     *
+     * @return  read() の戻り値の中のビットの番号, 一杯のときは INPUT_PINS_NO_BIT
+     */
+    unsigned char add(unsigned char pin, unsigned char polarity = INPUT_ACTIVE_HIGH);
+
+    // 全ての入力を読む (ビット i が i 番目に登録したピン, 1 : ON)
+    unsigned short read(void);
+
+    inline unsigned char getCount(void) { return pinCount; }
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _INPUT_PINS_DFS_H_
+#define _INPUT_PINS_DFS_H_
+
+#define INPUT_PINS_MAX (16)       // 登録できるピンの数
+#define INPUT_PINS_PORT_MAX (4)   // 読むポートの数 (AVR)
+#define INPUT_PINS_NO_BIT (0xFF)  // add が失敗したときの戻り値
+
+// add の極性
+#define INPUT_ACTIVE_HIGH (0)
+#define INPUT_ACTIVE_LOW (1)      // 読んだ値を反転する (SHUTDOWN_DETECT など)
+
+#endif
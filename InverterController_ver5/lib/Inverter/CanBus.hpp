@@ -0,0 +1,112 @@
+#ifndef _CAN_BUS_H_
+#define _CAN_BUS_H_
+
+#include "RxBuffer.hpp"
+
+/**
+ * CANコントローラの共通インターフェース
+ * Inverter はこのクラスだけを通して送受信するので, 実装を差し替えればホストPCでも動かせる
+ *
+ * MCP2515_Bus   : CAN Bus Shield (Arduino MEGA)
+ * R4_Bus        : Arduino UNO R4 内蔵CAN
+ * Loopback_Bus  : プロセス内の仮想バス (ホストPCでのテスト用)
+ * SocketCAN_Bus : Linux SocketCAN (can0, vcan0 など)
+ */
+class CanBus
+{
+protected:
+    CAN_FRAME peeked; // peek() の既定の実装で読み出したフレーム
+
+public:
+    virtual ~CanBus() {}
+
+    /**
+     * @fn      begin
+     *
+     * @brief   CANコントローラを初期化し, ids のフレームだけを受信するようにフィルタを設定する
+     *          フィルタを設定する順番(初期化の前か後か)は実装ごとに異なる
+     *          初期化済みのときは初期化し直す(バスオフからの復帰に使う)
+     *          待ち続けずにすぐ戻ること (失敗したら呼び出し側が時間をおいて再試行する)
+     *
+     * @param   ids 受信するIDの配列
+     * @param   num IDの個数(0個のときはどのフレームも受信しない)
+     *
+     * @return  Success(0), Fail(1)
+     */
+    virtual unsigned char begin(const unsigned long *ids, unsigned char num) = 0;
+
+    /**
+     * @fn      write
+     *
+     * @brief   標準IDのフレームを送信する
+     *
+     * @return  Success(0), Fail(0以外, 値は実装ごとのエラーコード)
+     */
+    virtual int write(unsigned long id, unsigned char len, const unsigned char *buf) = 0;
+
+    /**
+     * @fn      read
+     *
+     * @brief   受信したフレームを古い順に1つ読み出す
+     *
+     * @return  読み出した(1), 受信したフレームが無い(0)
+     */
+    virtual unsigned char read(CAN_FRAME *frame) = 0;
+
+    /**
+     * @fn      peek
+     *
+     * @brief   受信したフレームを古い順に1つ, コピーせずに参照する
+     *          受信バッファを持つ実装はバッファのスロットを直接返す
+     *          返したフレームは release() を呼ぶまで書き換えられない
+     *          既定の実装は read() で peeked へコピーする
+     *
+     * @return  フレームのポインタ, 受信したフレームが無いときは nullptr
+     */
+    virtual const CAN_FRAME *peek(void) { return read(&peeked) ? &peeked : nullptr; }
+
+    /**
+     * @fn      release
+     *
+     * @brief   peek() で参照したフレームを解放する
+     */
+    virtual void release(void) {}
+
+    /**
+     * @fn      poll
+     *
+     * @brief   送信待ちのフレームをCANコントローラへ渡す (R4_Bus)
+     *          受信割り込みで読み残したフレームを読み出す (MCP2515_Bus)
+     *          loop() から毎回呼ぶこと
+     */
+    virtual void poll(void) {}
+
+    // 受信して読み出していないフレームの数
+    virtual unsigned char available(void) = 0;
+
+    // 受信バッファに溜まったフレームの数の最大値
+    virtual unsigned char getMaxCount(void) { return 0; }
+
+    // 受信バッファが一杯で捨てたフレームの数
+    virtual unsigned short getOverflowCount(void) { return 0; }
+
+    // CANコントローラの受信バッファでオーバーフローが発生した回数
+    virtual unsigned short getCtrlOverflowCount(void) { return 0; }
+
+    // CANコントローラからフレームを読み出せなかった回数
+    virtual unsigned short getReadErrorCount(void) { return 0; }
+
+    // 送信待ちのフレームの数の最大値
+    virtual unsigned char getTxMaxCount(void) { return 0; }
+
+    // 送信待ちが一杯で捨てたフレームの数
+    virtual unsigned short getTxDropCount(void) { return 0; }
+
+    // 送信を要求してからCANコントローラに渡すまでの最大[us]
+    virtual unsigned long getTxMaxLatency(void) { return 0; }
+
+    // CANコントローラがバスオフ(送信エラーが多すぎてバスから切り離された状態)か
+    virtual unsigned char isBusOff(void) { return 0; }
+};
+
+#endif
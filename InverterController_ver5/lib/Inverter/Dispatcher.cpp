@@ -0,0 +1,135 @@
+#include "Dispatcher.hpp"
+
+Dispatcher::Dispatcher()
+    : entryNum(0), unknownCount(0), invalidCount(0)
+{
+    for (int i = 0; i < DISPATCH_TABLE_SIZE; i++)
+    {
+        table[i].id = 0;
+        table[i].handler = nullptr;
+        table[i].ecu = nullptr;
+        table[i].rxCount = 0;
+    }
+}
+
+DISPATCH_ENTRY *Dispatcher::find(unsigned long id)
+{
+    unsigned char index = hash(id);
+
+    // 空きが見つかるまで線形探索, 登録数はテーブルの半分までなので数回で終わる
+    for (int i = 0; i < DISPATCH_TABLE_SIZE; i++)
+    {
+        DISPATCH_ENTRY *entry = &table[index];
+
+        if (entry->handler == nullptr || entry->id == id)
+        {
+            return entry;
+        }
+
+        index = (index + 1) & (DISPATCH_TABLE_SIZE - 1);
+    }
+
+    return nullptr;
+}
+
+unsigned char Dispatcher::add(unsigned long id, MsgHandler handler, void *ecu)
+{
+    if (handler == nullptr || entryNum >= DISPATCH_MAX_ENTRY)
+    {
+        return 1;
+    }
+
+    DISPATCH_ENTRY *entry = find(id);
+
+    if (entry == nullptr || entry->handler != nullptr)
+    {
+        return 1;
+    }
+
+    entry->id = id;
+    entry->handler = handler;
+    entry->ecu = ecu;
+    entry->rxCount = 0;
+    entryNum++;
+
+    return 0;
+}
+
+unsigned char Dispatcher::remove(unsigned long id)
+{
+    DISPATCH_ENTRY *entry = find(id);
+
+    if (entry == nullptr || entry->handler == nullptr)
+    {
+        return 1;
+    }
+
+    entry->handler = nullptr;
+    entryNum--;
+
+    // 後ろに続く登録を入れ直して, 探索が空きで途切れないようにする
+    unsigned char index = (unsigned char)((entry - table + 1) & (DISPATCH_TABLE_SIZE - 1));
+
+    while (table[index].handler != nullptr)
+    {
+        DISPATCH_ENTRY moved = table[index];
+
+        table[index].handler = nullptr;
+        entryNum--;
+        add(moved.id, moved.handler, moved.ecu);
+        find(moved.id)->rxCount = moved.rxCount;
+
+        index = (index + 1) & (DISPATCH_TABLE_SIZE - 1);
+    }
+
+    return 0;
+}
+
+unsigned char Dispatcher::dispatch(unsigned long id, const unsigned char *buf, unsigned char len)
+{
+    DISPATCH_ENTRY *entry = find(id);
+
+    if (entry == nullptr || entry->handler == nullptr)
+    {
+        unknownCount++;
+        return 1;
+    }
+
+    if (entry->handler(entry->ecu, buf, len))
+    {
+        invalidCount++;
+        return 2;
+    }
+
+    entry->rxCount++;
+
+    return 0;
+}
+
+unsigned char Dispatcher::getIDs(unsigned long *ids, unsigned char maxNum)
+{
+    unsigned char num = 0;
+
+    for (int i = 0; i < DISPATCH_TABLE_SIZE && num < maxNum; i++)
+    {
+        if (table[i].handler != nullptr)
+        {
+            ids[num] = table[i].id;
+            num++;
+        }
+    }
+
+    return num;
+}
+
+unsigned short Dispatcher::getRxCount(unsigned long id)
+{
+    DISPATCH_ENTRY *entry = find(id);
+
+    if (entry == nullptr || entry->handler == nullptr)
+    {
+        return 0;
+    }
+
+    return entry->rxCount;
+}
@@ -0,0 +1,118 @@
+#ifndef _DISPATCHER_H_
+#define _DISPATCHER_H_
+
+#define DISPATCH_TABLE_SIZE (16)  // 2のべき乗にすること
+#define DISPATCH_MAX_ENTRY (8)    // 探索回数を抑えるためテーブルの半分までしか登録しない
+#define DISPATCH_MSG_LEN (8)      // ECUのMassageの長さ, これより短いフレームは処理しない
+
+/**
+ * 受信したMassageを処理する関数
+ * ecu : 登録時に渡したECUのポインタ
+ * buf : 受信したMassage(受信バッファを直接指す)
+ * len : Massageの長さ
+ * 戻り値 : 処理した(0), 長さが足りないなどで処理しなかった(1)
+ */
+typedef unsigned char (*MsgHandler)(void *ecu, const unsigned char *buf, unsigned char len);
+
+/**
+ * setMsg(const unsigned char *buf) を持つECUクラス用のMsgHandler
+ * dispatcher.add(id, setMsgHandler<MG_ECU1::ECU>, &mgecu1) のように登録する
+ * setMsg は DISPATCH_MSG_LEN バイトをコピーするので, 短いフレームは受信バッファの
+ * 前のフレームの残りを読んでしまう. そのため DLC が足りないフレームは捨てる
+ * buf のスロットは処理の後すぐに再利用されるので, ECUは buf を保持せずにコピーすること
+ */
+template <class ECU_T>
+unsigned char setMsgHandler(void *ecu, const unsigned char *buf, unsigned char len)
+{
+    if (len < DISPATCH_MSG_LEN)
+    {
+        return 1;
+    }
+
+    static_cast<ECU_T *>(ecu)->setMsg(buf);
+    return 0;
+}
+
+struct DISPATCH_ENTRY
+{
+    unsigned long id;
+    MsgHandler handler; // nullptr のとき空き
+    void *ecu;
+    unsigned short rxCount; // 受信回数
+};
+
+/**
+ * 受信したMassageをIDごとの処理関数に振り分ける
+ * IDをハッシュしたオープンアドレス法のテーブルなので
+ * 登録するECUが増えても1フレームあたりの処理時間はほぼ一定
+ */
+class Dispatcher
+{
+private:
+    DISPATCH_ENTRY table[DISPATCH_TABLE_SIZE];
+    unsigned char entryNum;
+    unsigned short unknownCount; // 登録されていないIDのMassageを受信した回数
+    unsigned short invalidCount; // 処理関数が受け付けなかった(DLCが足りないなど)Massageの回数
+
+    static inline unsigned char hash(unsigned long id)
+    {
+        return (unsigned char)((id ^ (id >> 4)) & (DISPATCH_TABLE_SIZE - 1));
+    }
+
+    DISPATCH_ENTRY *find(unsigned long id);
+
+public:
+    Dispatcher();
+
+    /**
+     * @fn      add
+     *
+     * @brief   IDに対応する処理関数を登録する
+     *
+     * @param   id      MassageのID
+     * @param   handler 処理関数
+     * @param   ecu     処理関数に渡すECUのポインタ
+     *
+     * @return  Success(0), Fail(1) テーブルが一杯 or 登録済みのID
+     */
+    unsigned char add(unsigned long id, MsgHandler handler, void *ecu);
+
+    /**
+     * @fn      remove
+     *
+     * @brief   IDの登録を取り消す
+     *
+     * @return  Success(0), Fail(1) 登録されていないID
+     */
+    unsigned char remove(unsigned long id);
+
+    /**
+     * @fn      dispatch
+     *
+     * @brief   IDに対応する処理関数を呼び出す
+     *
+     * @return  Success(0), Fail(1) 登録されていないID, Fail(2) 処理関数が受け付けなかった
+     */
+    unsigned char dispatch(unsigned long id, const unsigned char *buf, unsigned char len);
+
+    // 指定したIDのMassageを受信した回数, 登録されていないIDの時は0
+    unsigned short getRxCount(unsigned long id);
+
+    /**
+     * @fn      getIDs
+     *
+     * @brief   登録されているIDの一覧を取得する(受信フィルタの設定用)
+     *
+     * @param   ids     IDを格納する配列
+     * @param   maxNum  配列の要素数
+     *
+     * @return  格納したIDの個数
+     */
+    unsigned char getIDs(unsigned long *ids, unsigned char maxNum);
+
+    inline unsigned short getUnknownCount(void) { return unknownCount; }
+    inline unsigned short getInvalidCount(void) { return invalidCount; }
+    inline unsigned char getEntryNum(void) { return entryNum; }
+};
+
+#endif
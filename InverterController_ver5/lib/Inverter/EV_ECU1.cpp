@@ -1,28 +1,17 @@
 #include "EV_ECU1.hpp"
-
-EV_ECU1::MSG::MSG()
-    : ecuEnable(0x0), dischargeCommand(0x0), reserve0(0x0), requestTorque(0x7D0)
-{
-}
+#include <string.h>
 
 EV_ECU1::ECU::ECU(unsigned long id)
-    : id(id)
-{
-    msg = new MSG();
-    torqueRequestPara = new Parameter(-1000, 0.5f, -1000, 1000);
-}
-
-EV_ECU1::ECU::~ECU()
+    : id(id), msg{0, 0, 0, 0, 0, 0, 0, 0}
 {
-    delete (msg);
-    delete (torqueRequestPara);
+    RequestTorque::set(msg, 0x7D0);
 }
 
 unsigned char EV_ECU1::ECU::getMsgByte(unsigned char index)
 {
     if (0 <= index && index <= 7)
     {
-        return msg->msgs[index];
+        return msg[index];
     }
 
     return 0;
@@ -30,18 +19,18 @@ unsigned char EV_ECU1::ECU::getMsgByte(unsigned char index)
 
 float EV_ECU1::ECU::getRequestTorque()
 {
-    return torqueRequestPara->calcPhysical(msg->requestTorque);
+    return RequestTorque::getPhysical(msg);
 }
 
 unsigned char EV_ECU1::ECU::setEcuEnable(unsigned char ecuEnable)
 {
     if (ecuEnable == 0 || ecuEnable == 1)
     {
-        msg->ecuEnable = ecuEnable;
+        EcuEnable::set(msg, ecuEnable);
         return 0;
     }
 
-    msg->ecuEnable = 0;
+    EcuEnable::set(msg, 0);
     return 1;
 }
 
@@ -49,22 +38,41 @@ unsigned char EV_ECU1::ECU::setDischargeCommand(unsigned char dischargeCommand)
 {
     if (dischargeCommand == 0 || dischargeCommand == 1)
     {
-        msg->dischargeCommand = dischargeCommand;
+        DischargeCommand::set(msg, dischargeCommand);
         return 0;
     }
 
-    msg->dischargeCommand = 0;
+    DischargeCommand::set(msg, 0);
     return 1;
 }
 
 unsigned char EV_ECU1::ECU::setRequestTorque(float physicalValue)
 {
-    if (torqueRequestPara->getMinPhysical() <= physicalValue && physicalValue <= torqueRequestPara->getMaxPhysical())
+    if (TorqueRequestPara::getMinPhysical() <= physicalValue && physicalValue <= TorqueRequestPara::getMaxPhysical())
     {
-        msg->requestTorque = torqueRequestPara->calcNormal(physicalValue);
+        RequestTorque::set(msg, TorqueRequestPara::calcNormal(physicalValue));
         return 0;
     }
 
-    msg->requestTorque = torqueRequestPara->calcNormal(0);
+    RequestTorque::set(msg, TorqueRequestPara::calcNormalInt(0));
     return 1;
 }
+
+unsigned char EV_ECU1::ECU::setFixedRequestTorque(long fixedValue)
+{
+    if (TorqueRequestPara::getMinFixed() <= fixedValue && fixedValue <= TorqueRequestPara::getMaxFixed())
+    {
+        RequestTorque::set(msg, TorqueRequestPara::calcNormalFixed(fixedValue));
+        return 0;
+    }
+
+    RequestTorque::set(msg, TorqueRequestPara::calcNormalInt(0));
+    return 1;
+}
+
+unsigned char EV_ECU1::ECU::setMsg(const unsigned char *buf)
+{
+    memcpy(msg, buf, sizeof(msg));
+
+    return 0;
+}
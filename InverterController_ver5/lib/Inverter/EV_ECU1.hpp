@@ -2,47 +2,45 @@
 #define _EV_ECU1_H_
 
 #include "Parameter.hpp"
+#include "Signal.hpp"
 
 namespace EV_ECU1
 {
-    union MSG // CAN Massage
-    {
-        unsigned char msgs[8];
-        struct
-        {
-            unsigned char ecuEnable : 1;        // MG-ECU実行要求
-            unsigned char dischargeCommand : 1; // 平滑コンデンサ放電要求
-            unsigned char reserve0 : 6;
-            unsigned short requestTorque : 12; // HV-ECU要求トルク Range 0~4000
-        };
-
-        MSG();
-    };
+    typedef Parameter<-1000, 1, 2, -1000, 1000> TorqueRequestPara; // HV-ECU要求トルク
+
+    // CAN Massage のシグナル <開始ビット, ビット長, バイトオーダー, 変換>
+    typedef Signal<0, 1> EcuEnable;                                       // MG-ECU実行要求
+    typedef Signal<1, 1> DischargeCommand;                                // 平滑コンデンサ放電要求
+    typedef Signal<8, 12, SIGNAL_INTEL, TorqueRequestPara> RequestTorque; // HV-ECU要求トルク Range 0~4000
 
     class ECU
     {
     private:
         const unsigned long id;
-        union MSG *msg;
-        Parameter *torqueRequestPara;    // HV-ECU要求トルク
+        unsigned char msg[8]; // CAN Massage
 
     public:
         ECU(unsigned long id);
-        ~ECU();
 
         unsigned long getID() { return id; };
 
         // Massage取得, 指定したインデックスが0~7以外の時は0を返す
         unsigned char getMsgByte(unsigned char index);
 
-        inline unsigned char getEcuEnable() { return msg->ecuEnable; };
-        inline unsigned char getDischargeCommand() { return msg->dischargeCommand; };
+        // Massageの先頭ポインタ(8byte)
+        inline const unsigned char *getMsgBuf() { return msg; };
+
+        inline unsigned char getEcuEnable() { return EcuEnable::get(msg); };
+        inline unsigned char getDischargeCommand() { return DischargeCommand::get(msg); };
 
         // 戻り値はPhysical Value
         float getRequestTorque();
 
         // 戻り値はNormal Value
-        inline unsigned short getNormalRequestTorque() { return msg->requestTorque; };
+        inline unsigned short getNormalRequestTorque() { return RequestTorque::get(msg); };
+
+        // 戻り値は0.5 Nm単位のPhysical Value
+        inline long getFixedRequestTorque() { return RequestTorque::getFixed(msg); };
 
         /**
          * ecuEnable = 0 or 1
@@ -62,6 +60,16 @@ namespace EV_ECU1
          * 範囲外の値が引数に渡されたときは要求トルクを 0 Nm にする
          */
         unsigned char setRequestTorque(float physicalValue);
+
+        /**
+         * 要求トルクを0.5 Nm単位でセット
+         * -2000 <= fixedValue <= 2000
+         * 範囲外の値が引数に渡されたときは要求トルクを 0 Nm にする
+         */
+        unsigned char setFixedRequestTorque(long fixedValue);
+
+        // Massage(8byte)を丸ごと書き換える (ホストPCでのテレメトリの変換用)
+        unsigned char setMsg(const unsigned char *buf);
     };
 }
 
@@ -1,4 +1,8 @@
 #include "Inverter.hpp"
+#include "Probe.hpp"
+#include "MCP2515_Bus.hpp"
+#include "R4_Bus.hpp"
+#include "Loopback_Bus.hpp"
 
 /*
 #include <SPI.h>
@@ -20,163 +24,230 @@ mcp2515_can CAN(SPI_CS_PIN); // Set CS pin
 #endif
 */
 
-#ifndef ARDUINO_UNO_R4
-mcp2515_can CAN(SPI_CS_PIN); // Set CS pin
+static_assert(FIXED_TORQUE_RESOLUTION == 2, "fixed torque must match the 0.5 Nm resolution of EV-ECU1");
+
+/**
+ * 使用しているマイコンのCANコントローラ
+ * ホストPCでは相手のいない Loopback_Bus (送信したフレームが自分に戻る)
+ */
+#if defined(ARDUINO_UNO_R4)
+static R4_Bus defaultBus;
+#elif defined(ARDUINO)
+static MCP2515_Bus defaultBus(SPI_CS_PIN, CAN_INT_PIN);
+#else
+static Loopback_Bus defaultBus;
 #endif
 
 Inverter::Inverter()
+    : Inverter(&defaultBus)
 {
-    evecu1 = new EV_ECU1::ECU(EV_ECU1_ID);
-    mgecu1 = new MG_ECU1::ECU(MG_ECU1_ID);
-    mgecu2 = new MG_ECU2::ECU(MG_ECU2_ID);
 }
 
-Inverter::~Inverter()
+Inverter::Inverter(CanBus *bus)
+    : evecu1(EV_ECU1_ID), mgecu1(MG_ECU1_ID), mgecu2(MG_ECU2_ID), bus(bus), txScheduler(TX_PERIOD),
+      canState(CAN_STATE_INIT), canStateTime(0), lastBusCheckTime(0), txErrorCount(0), reinitCount(0),
+      busOffCount(0), initFailCount(0), initMaxTime(0),
+      lastEcuEnable(0), lastDischargeCommand(0), lastRequestTorque(0)
 {
-    delete (evecu1);
-    delete (mgecu1);
-    delete (mgecu2);
+    dispatcher.add(mgecu1.getID(), setMsgHandler<MG_ECU1::ECU>, &mgecu1);
+    dispatcher.add(mgecu2.getID(), setMsgHandler<MG_ECU2::ECU>, &mgecu2);
+    periodMonitor.add(mgecu1.getID(), MG_ECU1_TIMEOUT);
+    periodMonitor.add(mgecu2.getID(), MG_ECU2_TIMEOUT);
 }
 
 void Inverter::init(void)
 {
-    Serial.begin(115200);
+    Serial.begin(SERIAL_BAUD);
     /*
     while (!Serial)
     {
     }
     */
 
-#ifdef ARDUINO_UNO_R4
-    if (!CAN.begin(CanBitRate::BR_500k))
+    canState = CAN_STATE_INIT;
+    serviceCan(millis());
+}
+
+unsigned char Inverter::serviceCan(unsigned long now)
+{
+    switch (canState)
     {
-        Serial.println("CAN.begin(...) failed.");
-        for (;;)
+    case CAN_STATE_READY:
+        bus->poll();
+
+        // Serial に書くとテレメトリのフレームに混ざるので, 回数だけ数えてテレメトリで送る
+        if (txErrorCount >= CAN_REINIT_TX_ERROR)
         {
+            canState = CAN_STATE_INIT;
+            reinitCount++;
         }
+        else if (now - lastBusCheckTime >= CAN_BUS_CHECK_PERIOD)
+        {
+            lastBusCheckTime = now;
+
+            if (bus->isBusOff())
+            {
+                canState = CAN_STATE_INIT;
+                reinitCount++;
+                busOffCount++;
+            }
+        }
+        break;
+
+    case CAN_STATE_RETRY:
+        if (now - canStateTime >= CAN_INIT_RETRY_PERIOD)
+        {
+            beginCan(now);
+        }
+        break;
+
+    default:
+        beginCan(now);
+        break;
     }
-#else
-    while (CAN_OK != CAN.begin(CAN_500KBPS))
+
+    return canState == CAN_STATE_READY;
+}
+
+void Inverter::beginCan(unsigned long now)
+{
+    unsigned long ids[DISPATCH_MAX_ENTRY];
+    unsigned char num = dispatcher.getIDs(ids, DISPATCH_MAX_ENTRY);
+
+    canStateTime = now;
+
+    const unsigned long start = micros();
+    const unsigned char result = bus->begin(ids, num);
+    const unsigned long elapsed = micros() - start;
+
+    if (elapsed > initMaxTime)
     {
-        Serial.println("CAN init fail, retry...");
-        delay(100);
+        initMaxTime = elapsed;
     }
-    Serial.println("CAN init OK!");
-#endif
+
+    if (result)
+    {
+        initFailCount++;
+        canState = CAN_STATE_RETRY;
+        return;
+    }
+
+    canState = CAN_STATE_READY;
+    lastBusCheckTime = now;
+    txErrorCount = 0;
+
+    // 初期化し直した後は, 初期化中の空白を受信間隔に含めない
+    periodMonitor.start(micros());
 }
 
 void Inverter::runInverter(unsigned char *flags, unsigned short batVol, float torque)
 {
-    unsigned char *airFlag = flags;
-    unsigned char *torqueControlFlag = flags + 1;
-    const unsigned char shutdownFlag = *(flags + 2);
-    const unsigned char driveFlag = shutdownFlag ? 0 : *(flags + 3);
-    const unsigned char ws = mgecu1->getWorkingStatus();
-    const unsigned short idcv = mgecu1->getInputDCVoltage();
-    const float ms = fabs(mgecu1->getMotorSpeed());
+    // EV-ECU1 の Normal Value への変換と同じく 0.5 Nm 単位に切り捨てる
+    runInverterFixed(flags, batVol, (short)floorf(torque * FIXED_TORQUE_RESOLUTION));
+}
+
+/**
+ * runInverter の状態遷移表 [Working Status][イベント] -> アクション
+ * Working Status は3bitなので未定義の値(0b100~0b110)も含めて8行ある
+ */
+static const unsigned char ACTION_TABLE[8][INVERTER_EVENT_NUM] = {
+    // INVERTER_EVENT_IDLE       INVERTER_EVENT_DRIVE       INVERTER_EVENT_SHUTDOWN
+    {INVERTER_ACTION_NONE,      INVERTER_ACTION_NONE,      INVERTER_ACTION_SHUTDOWN},         // WORKING_INIT
+    {INVERTER_ACTION_PRECHARGE, INVERTER_ACTION_PRECHARGE, INVERTER_ACTION_SHUTDOWN},         // WORKING_PRECHARGE
+    {INVERTER_ACTION_STANDBY,   INVERTER_ACTION_STANDBY,   INVERTER_ACTION_SHUTDOWN_STANDBY}, // WORKING_STANDBY
+    {INVERTER_ACTION_NONE,      INVERTER_ACTION_TORQUE,    INVERTER_ACTION_SHUTDOWN},         // WORKING_TORQUE_CONTROL
+    {INVERTER_ACTION_NONE,      INVERTER_ACTION_NONE,      INVERTER_ACTION_SHUTDOWN},         // 0b100
+    {INVERTER_ACTION_NONE,      INVERTER_ACTION_NONE,      INVERTER_ACTION_SHUTDOWN},         // 0b101
+    {INVERTER_ACTION_NONE,      INVERTER_ACTION_NONE,      INVERTER_ACTION_SHUTDOWN},         // 0b110
+    {INVERTER_ACTION_DISCHARGE, INVERTER_ACTION_DISCHARGE, INVERTER_ACTION_SHUTDOWN},         // WORKING_RAPID_DISCHARGE
+};
+
+void Inverter::runInverterFixed(unsigned char *flags, unsigned short batVol, short torque)
+{
+    PROBE_SCOPE("Inverter::runInverterFixed");
+
+    const unsigned char state = mgecu1.getWorkingStatus();
+    const unsigned char event = flags[2]   ? INVERTER_EVENT_SHUTDOWN
+                                : flags[3] ? INVERTER_EVENT_DRIVE
+                                           : INVERTER_EVENT_IDLE;
+    const unsigned char action = ACTION_TABLE[state][event];
+    unsigned char output = (flags[0] ? INVERTER_FLAG_AIR : 0) | (flags[1] ? INVERTER_FLAG_TORQUE_CONTROL : 0);
 
     setBatVol(batVol);
 
-    // if shutdown button is pushed
-    if (shutdownFlag)
-    {
-        *airFlag = 0;
-        *torqueControlFlag = 0;
-        evecu1->setRequestTorque(0);
-        evecu1->setEcuEnable(0);
-        switch (ws)
-        {
-        case WORKING_RAPID_DISCHARGE:
-            if (!evecu1->getDischargeCommand())
-            {
-                // evecu1->setDischargeCommand(1);
-            }
-            break;
+    output = runAction(action, output, torque);
 
-        case WORKING_STANDBY:
-            if (evecu1->getDischargeCommand())
-            {
-                evecu1->setDischargeCommand(0);
-            }
-            break;
-        }
-    }
-    else
-    {
-        switch (ws)
-        {
-        case WORKING_PRECHARGE:
-            // 最低入力電圧チェック & バッテリー電圧チェック
-            if (MINIMUM_INPUT_VOLTAGE <= idcv && batteryVoltage != 0)
-            {
-                // プリチャージ完了チェック
-                if ((batteryVoltage - idcv) < (batteryVoltage / 10))
-                {
-                    // MG-ECU実行要求からAIR ON
-                    if (!evecu1->setEcuEnable(1))
-                    {
-                        *airFlag = 1;
-                    }
-                }
-            }
-            break;
+    flags[0] = (output & INVERTER_FLAG_AIR) != 0;
+    flags[1] = (output & INVERTER_FLAG_TORQUE_CONTROL) != 0;
 
-        case WORKING_TORQUE_CONTROL:
-            // Ready to Drive
-            if (driveFlag)
-            {
-                if (*torqueControlFlag)
-                {
-                    torqueRequest(torque);
-                }
-                else
-                {
-                    *torqueControlFlag = 1;
-                }
-            }
-            break;
+    stateTrace.record(micros(), state, event, action,
+                      output | (evecu1.getEcuEnable() ? INVERTER_FLAG_ECU_ENABLE : 0) |
+                          (evecu1.getDischargeCommand() ? INVERTER_FLAG_DISCHARGE : 0));
+}
 
-        case WORKING_RAPID_DISCHARGE:
-            if (!evecu1->getDischargeCommand())
-            {
-                if (*airFlag || *torqueControlFlag)
-                {
-                    *airFlag = 0;
-                    *torqueControlFlag = 0;
-                }
-                else
-                {
-                    // evecu1->setDischargeCommand(1);
-                }
-            }
-            break;
+unsigned char Inverter::runAction(unsigned char action, unsigned char flags, short torque)
+{
+    switch (action)
+    {
+    case INVERTER_ACTION_SHUTDOWN:
+        evecu1.setFixedRequestTorque(0);
+        evecu1.setEcuEnable(0);
+        return 0;
+        break;
 
-        case WORKING_STANDBY:
-            if (*airFlag || *torqueControlFlag)
-            {
-                *airFlag = 0;
-                torqueControlFlag = 0;
-            }
+    case INVERTER_ACTION_SHUTDOWN_STANDBY:
+        evecu1.setFixedRequestTorque(0);
+        evecu1.setEcuEnable(0);
+        evecu1.setDischargeCommand(0);
+        return 0;
+        break;
 
-            if (evecu1->getEcuEnable())
-            {
-                evecu1->setEcuEnable(0);
-            }
+    case INVERTER_ACTION_PRECHARGE:
+    {
+        const unsigned short idcv = mgecu1.getInputDCVoltage();
 
-            if (evecu1->getDischargeCommand())
+        // 最低入力電圧チェック & バッテリー電圧チェック & プリチャージ完了チェック
+        if (MINIMUM_INPUT_VOLTAGE <= idcv && batteryVoltage != 0 &&
+            (batteryVoltage - idcv) < (batteryVoltage / 10))
+        {
+            // MG-ECU実行要求からAIR ON
+            if (!evecu1.setEcuEnable(1))
             {
-                evecu1->setDischargeCommand(0);
+                flags |= INVERTER_FLAG_AIR;
             }
+        }
+        return flags;
+        break;
+    }
 
-            if (evecu1->getRequestTorque() != 0.0f)
-            {
-                evecu1->setRequestTorque(0.0f);
-            }
-            break;
+    case INVERTER_ACTION_TORQUE:
+        // Ready to Drive
+        if (flags & INVERTER_FLAG_TORQUE_CONTROL)
+        {
+            fixedTorqueRequest(torque);
+        }
+        return flags | INVERTER_FLAG_TORQUE_CONTROL;
+        break;
 
-        default:
-            break;
+    case INVERTER_ACTION_DISCHARGE:
+        // 放電要求を出すまでは AIR OFF (放電要求は setRapidDischargeRequestON で出す)
+        if (!evecu1.getDischargeCommand())
+        {
+            return 0;
         }
+        return flags;
+        break;
+
+    case INVERTER_ACTION_STANDBY:
+        evecu1.setEcuEnable(0);
+        evecu1.setDischargeCommand(0);
+        evecu1.setFixedRequestTorque(0);
+        return 0;
+        break;
+
+    default:
+        return flags;
+        break;
     }
 }
 
@@ -194,8 +265,8 @@ unsigned char Inverter::setBatVol(unsigned short batVol)
 
 unsigned char Inverter::setMgecuRequestON(unsigned short batVol)
 {
-    unsigned char ws = mgecu1->getWorkingStatus();
-    unsigned short idcv = mgecu1->getInputDCVoltage();
+    unsigned char ws = mgecu1.getWorkingStatus();
+    unsigned short idcv = mgecu1.getInputDCVoltage();
 
     setBatVol(batVol);
 
@@ -210,7 +281,7 @@ unsigned char Inverter::setMgecuRequestON(unsigned short batVol)
             // プリチャージ完了条件
             if ((batteryVoltage - idcv) < (batteryVoltage / 10))
             {
-                return evecu1->setEcuEnable(1);
+                return evecu1.setEcuEnable(1);
             }
         }
         break;
@@ -224,8 +295,8 @@ unsigned char Inverter::setMgecuRequestON(unsigned short batVol)
 
 unsigned char Inverter::setMgecuRequestOFF()
 {
-    unsigned char ws = mgecu1->getWorkingStatus();
-    float ms = fabs(mgecu1->getMotorSpeed());
+    unsigned char ws = mgecu1.getWorkingStatus();
+    long ms = labs(mgecu1.getIntMotorSpeed());
 
     switch (ws)
     {
@@ -233,7 +304,7 @@ unsigned char Inverter::setMgecuRequestOFF()
         // torque control終了条件
         if (ms < ECU_DISABLE_MOTOR_SPEED)
         {
-            return evecu1->setEcuEnable(0);
+            return evecu1.setEcuEnable(0);
         }
         break;
 
@@ -246,11 +317,11 @@ unsigned char Inverter::setMgecuRequestOFF()
 
 unsigned char Inverter::setRapidDischargeRequestON()
 {
-    unsigned char ws = mgecu1->getWorkingStatus();
+    unsigned char ws = mgecu1.getWorkingStatus();
 
     if (ws == WORKING_RAPID_DISCHARGE)
     {
-        return evecu1->setDischargeCommand(1);
+        return evecu1.setDischargeCommand(1);
     }
 
     return 1;
@@ -258,56 +329,114 @@ unsigned char Inverter::setRapidDischargeRequestON()
 
 unsigned char Inverter::setRapidDischargeRequestOFF()
 {
-    return evecu1->setDischargeCommand(0);
+    return evecu1.setDischargeCommand(0);
+}
+
+unsigned char Inverter::fixedTorqueRequest(short torque)
+{
+    unsigned char ws = mgecu1.getWorkingStatus();
+
+    if (ws == WORKING_TORQUE_CONTROL)
+    {
+        long mamt = mgecu2.getFixedMaxAvailableMotorTorque();
+
+        if (mamt < torque)
+        {
+            return evecu1.setFixedRequestTorque(mamt);
+        }
+
+        long magt = mgecu2.getFixedMaxAvailableGenerateTorque();
+
+        if (torque < magt)
+        {
+            return evecu1.setFixedRequestTorque(magt);
+        }
+
+        return evecu1.setFixedRequestTorque(torque);
+    }
+
+    evecu1.setFixedRequestTorque(0);
+    return 1;
 }
 
 unsigned char Inverter::torqueRequest(float torque)
 {
-    unsigned char ws = mgecu1->getWorkingStatus();
+    unsigned char ws = mgecu1.getWorkingStatus();
 
     if (ws == WORKING_TORQUE_CONTROL)
     {
-        float mamt = mgecu2->getMaxAvailableMotorTorque();
+        float mamt = mgecu2.getMaxAvailableMotorTorque();
 
         if (mamt < torque)
         {
-            return evecu1->setRequestTorque(mamt);
+            return evecu1.setRequestTorque(mamt);
         }
 
-        float magt = mgecu2->getMaxAvailableGenerateTorque();
+        float magt = mgecu2.getMaxAvailableGenerateTorque();
 
         if (torque < magt)
         {
-            return evecu1->setRequestTorque(magt);
+            return evecu1.setRequestTorque(magt);
         }
 
-        return evecu1->setRequestTorque(torque);
+        return evecu1.setRequestTorque(torque);
     }
 
-    evecu1->setRequestTorque(0);
+    evecu1.setRequestTorque(0);
     return 1;
 }
 
+unsigned char Inverter::isTxDue(unsigned long now)
+{
+    unsigned char ecuEnable = evecu1.getEcuEnable();
+    unsigned char dischargeCommand = evecu1.getDischargeCommand();
+    long requestTorque = evecu1.getFixedRequestTorque();
+
+    // 安全に関わる項目の変化は周期を待たずに送信する
+    unsigned char changed = ecuEnable != lastEcuEnable || dischargeCommand != lastDischargeCommand || labs(requestTorque - lastRequestTorque) >= TX_TORQUE_STEP;
+
+    if (txScheduler.isDue(now, changed))
+    {
+        lastEcuEnable = ecuEnable;
+        lastDischargeCommand = dischargeCommand;
+        lastRequestTorque = requestTorque;
+        return 1;
+    }
+
+    return 0;
+}
+
 int Inverter::sendMsgToInverter(unsigned char printFlag)
 {
-    unsigned char buf[8];
+    PROBE_SCOPE("Inverter::sendMsgToInverter");
 
-    for (int i = 0; i < 8; i++)
+    const unsigned char *buf = evecu1.getMsgBuf();
+
+    if (canState != CAN_STATE_READY)
     {
-        buf[i] = evecu1->getMsgByte(i);
+        return CAN_NOT_READY;
     }
 
-#ifdef ARDUINO_UNO_R4
-    CanMsg const msg(CanStandardId(evecu1->getID()), sizeof(buf), buf);
+    int result = bus->write(evecu1.getID(), 8, buf);
 
-    int const rc = CAN.write(msg);
+    if (result != 0)
+    {
+        if (txErrorCount < CAN_REINIT_TX_ERROR)
+        {
+            txErrorCount++;
+        }
+    }
+    else
+    {
+        txErrorCount = 0;
+    }
 
     if (printFlag)
     {
-        if (rc < 0)
+        if (result != 0)
         {
-            Serial.print("CAN.write(...) failed with error code : ");
-            Serial.println(rc);
+            Serial.print("CAN write failed with error code : ");
+            Serial.println(result);
             Serial.println();
         }
         else
@@ -320,169 +449,176 @@ int Inverter::sendMsgToInverter(unsigned char printFlag)
         }
     }
 
-    return rc;
-#else
-    unsigned char result = CAN.sendMsgBuf(evecu1->getID(), 0, 8, buf);
+    return result;
+}
 
-    if (printFlag)
-    {
-        switch (result)
-        {
-        case CAN_OK:
-            Serial.println("send massage to inverter");
-            Serial.println("----------Massage----------");
-            checkBuf(buf);
-            Serial.println("---------------------------");
-            Serial.println();
-            break;
+unsigned char Inverter::readMsgFromInverter(unsigned char printFlag)
+{
+    PROBE_SCOPE("Inverter::readMsgFromInverter");
 
-        case CAN_GETTXBFTIMEOUT:
-            Serial.println("get TXBF time out");
-            break;
+    unsigned char count = 0;
 
-        case CAN_SENDMSGTIMEOUT:
-            Serial.println("send MSG time out");
-            break;
+    const CAN_FRAME *frame;
 
-        default:
-            Serial.println("send MSG fail");
-            break;
-        }
+    if (canState != CAN_STATE_READY)
+    {
+        return 0;
     }
 
-    return result;
-#endif
-}
-
-unsigned long Inverter::readMsgFromInverter(unsigned char printFlag)
-{
-#ifdef ARDUINO_UNO_R4
-    if (CAN.available())
+    // 受信バッファのスロットを直接渡し, ECU::setMsg でのコピーだけにする
+    while (count < RX_BUFFER_SIZE && (frame = bus->peek()) != nullptr)
     {
-        CanMsg const msg = CAN.read();
+        // 捨てたMassageは受信周期に数えない (短いフレームが続いてもタイムアウトで分かるように)
+        if (dispatchMsg(frame->id, frame->buf, frame->len, printFlag) == 0)
+        {
+            periodMonitor.update(frame->id, frame->timestamp);
+        }
+        bus->release();
+        count++;
+    }
 
-        unsigned long id = msg.id;
-        unsigned char buf[8];
+    if (printFlag && count == 0)
+    {
+        Serial.println("no massage");
+    }
 
-        memcpy(buf, msg.data, msg.data_length);
+    txScheduler.countRxFrames(count);
 
-        if (id == mgecu1->getID())
-        {
-            if (printFlag)
-            {
-                Serial.println("set massage from MG-ECU1");
-                Serial.print("ID = ");
-                Serial.println(id, HEX);
-                Serial.println("----------buf----------");
-                checkBuf(buf);
-                Serial.println("-----------------------");
-                Serial.println();
-            }
+    return count;
+}
 
-            mgecu1->setMsg(buf);
-            return id;
-        }
-        else if (id == mgecu2->getID())
-        {
-            if (printFlag)
-            {
-                Serial.println("set massage from MG-ECU2");
-                Serial.print("ID = ");
-                Serial.println(id, HEX);
-                Serial.println("----------buf----------");
-                checkBuf(buf);
-                Serial.println("-----------------------");
-                Serial.println();
-            }
+unsigned char Inverter::dispatchMsg(unsigned long id, const unsigned char *buf, unsigned char len, unsigned char printFlag)
+{
+    const unsigned char result = dispatcher.dispatch(id, buf, len);
 
-            mgecu2->setMsg(buf);
-            return id;
-        }
-        else
-        {
-            if (printFlag)
-            {
-                Serial.println("received ID is unknown");
-            }
-            return id;
-        }
-    }
-    else
+    if (result)
     {
         if (printFlag)
         {
-            Serial.println("read massage fail");
+            Serial.print(result == 1 ? "received ID is unknown : " : "received massage is too short : ");
+            Serial.println(id, HEX);
         }
-        return 0;
+        return result;
     }
-#else
-    if (CAN_MSGAVAIL == CAN.checkReceive())
+
+    if (printFlag)
     {
-        unsigned char len = 0;
-        unsigned char buf[8];
-        unsigned char result = CAN.readMsgBuf(&len, buf);
-        unsigned long id = CAN.getCanId();
+        Serial.println("set massage");
+        Serial.print("ID = ");
+        Serial.println(id, HEX);
+        Serial.println("----------buf----------");
+        checkBuf(buf);
+        Serial.println("-----------------------");
+        Serial.println();
+    }
 
-        if (result == CAN_OK)
-        {
-            if (id == mgecu1->getID())
-            {
-                if (printFlag)
-                {
-                    Serial.println("set massage from MG-ECU1");
-                    Serial.print("ID = ");
-                    Serial.println(id, HEX);
-                    Serial.println("----------buf----------");
-                    checkBuf(buf);
-                    Serial.println("-----------------------");
-                    Serial.println();
-                }
-
-                mgecu1->setMsg(buf);
-                return id;
-            }
-            else if (id == mgecu2->getID())
-            {
-                if (printFlag)
-                {
-                    Serial.println("set massage from MG-ECU2");
-                    Serial.print("ID = ");
-                    Serial.println(id, HEX);
-                    Serial.println("----------buf----------");
-                    checkBuf(buf);
-                    Serial.println("-----------------------");
-                    Serial.println();
-                }
-
-                mgecu2->setMsg(buf);
-                return id;
-            }
+    return 0;
+}
 
-            if (printFlag)
-            {
-                Serial.println("received ID is unknown");
-            }
-            return 0;
-        }
-        else if (result == CAN_NOMSG)
-        {
-            if (printFlag)
-            {
-                Serial.println("no massage");
-            }
-            return 0;
-        }
+unsigned char Inverter::addMsgHandler(unsigned long id, MsgHandler handler, void *ecu, unsigned long timeout)
+{
+    if (dispatcher.add(id, handler, ecu))
+    {
+        return 1;
     }
 
-    if (printFlag)
+    // 受信周期を監視できないIDは受信フィルタにも入れない
+    if (periodMonitor.add(id, timeout))
     {
-        Serial.println("read massage fail");
+        dispatcher.remove(id);
+        return 1;
     }
+
     return 0;
-#endif
 }
 
-void Inverter::checkBuf(unsigned char *buf)
+void Inverter::printStateTrace(void)
+{
+    static const char *const ACTION_NAMES[] = {"NONE", "SHUTDOWN", "SHUTDOWN_STANDBY", "PRECHARGE", "TORQUE", "DISCHARGE", "STANDBY"};
+
+    Serial.println("----------STATE TRACE----------");
+    Serial.print("recorded ");
+    Serial.println(stateTrace.getTotalCount());
+    Serial.println("time[us] ws event action air tc enable discharge");
+
+    for (unsigned char i = 0; i < stateTrace.getCount(); i++)
+    {
+        const STATE_TRACE_ENTRY *entry = stateTrace.get(i);
+
+        Serial.print(entry->time);
+        Serial.print(" ");
+        Serial.print(entry->state, BIN);
+        Serial.print(" ");
+        Serial.print(entry->event == INVERTER_EVENT_SHUTDOWN ? "SHUTDOWN" : (entry->event == INVERTER_EVENT_DRIVE ? "DRIVE" : "IDLE"));
+        Serial.print(" ");
+        Serial.print(ACTION_NAMES[entry->action]);
+        Serial.print(" ");
+        Serial.print((entry->output & INVERTER_FLAG_AIR) ? 1 : 0);
+        Serial.print(" ");
+        Serial.print((entry->output & INVERTER_FLAG_TORQUE_CONTROL) ? 1 : 0);
+        Serial.print(" ");
+        Serial.print((entry->output & INVERTER_FLAG_ECU_ENABLE) ? 1 : 0);
+        Serial.print(" ");
+        Serial.println((entry->output & INVERTER_FLAG_DISCHARGE) ? 1 : 0);
+    }
+
+    Serial.println("-------------------------------");
+    Serial.println();
+}
+
+void Inverter::printCanStatus(void)
+{
+    Serial.println("----------CAN STATUS----------");
+    Serial.print("state ");
+    Serial.print(canState);
+    Serial.print(", reinit ");
+    Serial.print(reinitCount);
+    Serial.print(", bus off ");
+    Serial.print(busOffCount);
+    Serial.print(", init fail ");
+    Serial.print(initFailCount);
+    Serial.print(", init max [us] ");
+    Serial.println(initMaxTime);
+    Serial.print("rx max buffered ");
+    Serial.print(getRxMaxCount());
+    Serial.print(", overflow ");
+    Serial.print(getRxOverflowCount());
+    Serial.print(", ctrl overflow ");
+    Serial.print(getCtrlOverflowCount());
+    Serial.print(", ctrl read error ");
+    Serial.print(getCtrlReadErrorCount());
+    Serial.print(", unknown id ");
+    Serial.println(getUnknownCount());
+    Serial.print("tx max queued ");
+    Serial.print(getTxMaxCount());
+    Serial.print(", drop ");
+    Serial.print(getTxDropCount());
+    Serial.print(", max latency[us] ");
+    Serial.println(getTxMaxLatency());
+    Serial.println("------------------------------");
+}
+
+unsigned char Inverter::command(int c)
+{
+    switch (c)
+    {
+    case INVERTER_CMD_TRACE:
+        printStateTrace();
+        return 1;
+        break;
+
+    case INVERTER_CMD_CAN:
+        printCanStatus();
+        return 1;
+        break;
+
+    default:
+        return 0;
+        break;
+    }
+}
+
+void Inverter::checkBuf(const unsigned char *buf)
 {
     for (int i = 0; i < 8; i++)
     {
@@ -500,40 +636,59 @@ void Inverter::checkBuf(unsigned char *buf)
     }
 }
 
+unsigned char Inverter::getMsg(unsigned long id, unsigned char *buf)
+{
+    const unsigned char *msg;
+
+    switch (id)
+    {
+    case EV_ECU1_ID:
+        msg = evecu1.getMsgBuf();
+        break;
+
+    case MG_ECU1_ID:
+        msg = mgecu1.getMsgBuf();
+        break;
+
+    case MG_ECU2_ID:
+        msg = mgecu2.getMsgBuf();
+        break;
+
+    default:
+        return 1;
+        break;
+    }
+
+    memcpy(buf, msg, 8);
+    return 0;
+}
+
 void Inverter::checkMsgBit(unsigned long id)
 {
     unsigned char buf[8];
 
+    if (getMsg(id, buf))
+    {
+        Serial.print(id);
+        Serial.println(" is invalid ID");
+        return;
+    }
+
     switch (id)
     {
     case EV_ECU1_ID:
-        for (int i = 0; i < 8; i++)
-        {
-            buf[i] = evecu1->getMsgByte(i);
-        }
         Serial.println("----------EVECU1Massage----------");
         break;
 
     case MG_ECU1_ID:
-        for (int i = 0; i < 8; i++)
-        {
-            buf[i] = mgecu1->getMsgByte(i);
-        }
         Serial.println("----------MGECU1Massage----------");
         break;
 
     case MG_ECU2_ID:
-        for (int i = 0; i < 8; i++)
-        {
-            buf[i] = mgecu2->getMsgByte(i);
-        }
         Serial.println("----------MGECU2Massage----------");
         break;
 
     default:
-        Serial.print(id);
-        Serial.println(" is invalid ID");
-        return;
         break;
     }
 
@@ -551,13 +706,13 @@ void Inverter::checkMsg(unsigned long id)
         Serial.println("----------EVECU1----------");
 
         Serial.print("ecuEnable = ");
-        Serial.println(evecu1->getEcuEnable(), BIN);
+        Serial.println(evecu1.getEcuEnable(), BIN);
         Serial.print("dischargeCommand = ");
-        Serial.println(evecu1->getDischargeCommand(), BIN);
+        Serial.println(evecu1.getDischargeCommand(), BIN);
         Serial.print("requestTorque = ");
-        Serial.println(evecu1->getNormalRequestTorque(), BIN);
+        Serial.println(evecu1.getNormalRequestTorque(), BIN);
 
-        if (evecu1->getEcuEnable())
+        if (evecu1.getEcuEnable())
         {
             Serial.println("MG-ECU Enable");
         }
@@ -566,7 +721,7 @@ void Inverter::checkMsg(unsigned long id)
             Serial.println("MG-ECU Disable");
         }
 
-        if (evecu1->getDischargeCommand())
+        if (evecu1.getDischargeCommand())
         {
             Serial.println("Rapid Discharge Command Active");
         }
@@ -576,7 +731,7 @@ void Inverter::checkMsg(unsigned long id)
         }
 
         Serial.print("Torque Request ");
-        Serial.println(evecu1->getRequestTorque());
+        Serial.println(evecu1.getRequestTorque());
 
         Serial.println("--------------------------");
         Serial.println();
@@ -586,21 +741,21 @@ void Inverter::checkMsg(unsigned long id)
         Serial.println("----------MGECU1----------");
 
         Serial.print("shutdownEnable = ");
-        Serial.println(mgecu1->getShutdownEnable(), BIN);
+        Serial.println(mgecu1.getShutdownEnable(), BIN);
         Serial.print("PWM = ");
-        Serial.println(mgecu1->getPWM(), BIN);
+        Serial.println(mgecu1.getPWM(), BIN);
         Serial.print("WorkingStatus = ");
-        Serial.println(mgecu1->getWorkingStatus(), BIN);
+        Serial.println(mgecu1.getWorkingStatus(), BIN);
         Serial.print("motorSpeed = ");
-        Serial.println(mgecu1->getNormalMotorSpeed(), BIN);
+        Serial.println(mgecu1.getNormalMotorSpeed(), BIN);
         Serial.print("motorPhaseCurrent = ");
-        Serial.println(mgecu1->getNormalMotorPhaseCurrent(), BIN);
+        Serial.println(mgecu1.getNormalMotorPhaseCurrent(), BIN);
         Serial.print("inputDCVoltage = ");
-        Serial.println(mgecu1->getInputDCVoltage(), BIN);
+        Serial.println(mgecu1.getInputDCVoltage(), BIN);
         Serial.print("failureStatus = ");
-        Serial.println(mgecu1->getFailureStatus(), BIN);
+        Serial.println(mgecu1.getFailureStatus(), BIN);
 
-        if (mgecu1->getShutdownEnable())
+        if (mgecu1.getShutdownEnable())
         {
             Serial.println("Shutdown Enable");
         }
@@ -610,7 +765,7 @@ void Inverter::checkMsg(unsigned long id)
         }
 
         Serial.print("PWM ");
-        switch (mgecu1->getPWM())
+        switch (mgecu1.getPWM())
         {
         case PWM_SHORT_CIRCUIT:
             Serial.println("Short Circuit");
@@ -630,7 +785,7 @@ void Inverter::checkMsg(unsigned long id)
         }
 
         Serial.print("Working Status ");
-        switch (mgecu1->getWorkingStatus())
+        switch (mgecu1.getWorkingStatus())
         {
         case WORKING_INIT:
             Serial.println("init");
@@ -658,16 +813,16 @@ void Inverter::checkMsg(unsigned long id)
         }
 
         Serial.print("Motor Speed ");
-        Serial.println(mgecu1->getMotorSpeed());
+        Serial.println(mgecu1.getMotorSpeed());
 
         Serial.print("Motor Phase Current ");
-        Serial.println(mgecu1->getMotorPhaseCurrent());
+        Serial.println(mgecu1.getMotorPhaseCurrent());
 
         Serial.print("Input DC Voltage ");
-        Serial.println(mgecu1->getInputDCVoltage());
+        Serial.println(mgecu1.getInputDCVoltage());
 
         Serial.print("Failure Status ");
-        switch (mgecu1->getFailureStatus())
+        switch (mgecu1.getFailureStatus())
         {
         case FAILURE_NO_ERROR:
             Serial.println("No Error");
@@ -701,25 +856,25 @@ void Inverter::checkMsg(unsigned long id)
         Serial.println("----------MGECU2----------");
 
         Serial.print("inverterTemp = ");
-        Serial.println(mgecu2->getNormalInverterTemp(), BIN);
+        Serial.println(mgecu2.getNormalInverterTemp(), BIN);
         Serial.print("maxMotorTorque = ");
-        Serial.println(mgecu2->getNormalMaxAvailableMotorTorque(), BIN);
+        Serial.println(mgecu2.getNormalMaxAvailableMotorTorque(), BIN);
         Serial.print("maxGenerateTorque = ");
-        Serial.println(mgecu2->getNormalMaxAvailableGenerateTorque(), BIN);
+        Serial.println(mgecu2.getNormalMaxAvailableGenerateTorque(), BIN);
         Serial.print("motorTemp = ");
-        Serial.println(mgecu2->getNormalMotorTemp(), BIN);
+        Serial.println(mgecu2.getNormalMotorTemp(), BIN);
 
         Serial.print("Inverter Temperature ");
-        Serial.println(mgecu2->getInverterTemp());
+        Serial.println(mgecu2.getInverterTemp());
 
         Serial.print("Maximum Available Motoring Torque ");
-        Serial.println(mgecu2->getMaxAvailableMotorTorque());
+        Serial.println(mgecu2.getMaxAvailableMotorTorque());
 
         Serial.print("Maximum Available Generating Torque ");
-        Serial.println(mgecu2->getMaxAvailableGenerateTorque());
+        Serial.println(mgecu2.getMaxAvailableGenerateTorque());
 
         Serial.print("Motor Temperature ");
-        Serial.println(mgecu2->getMotorTemp());
+        Serial.println(mgecu2.getMotorTemp());
 
         Serial.println("--------------------------");
         Serial.println();
@@ -728,4 +883,4 @@ void Inverter::checkMsg(unsigned long id)
     default:
         break;
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -5,37 +5,116 @@
 #include "MG_ECU1.hpp"
 #include "MG_ECU2.hpp"
 #include "Inverter_dfs.hpp"
+#include "Dispatcher.hpp"
+#include "TxScheduler.hpp"
+#include "CanBus.hpp"
+#include "PeriodMonitor.hpp"
+#include "StateTrace.hpp"
 
-#ifdef ARDUINO_UNO_R4
-#include <Arduino_CAN.h>
-#else
-#include <SPI.h>
-#include "mcp2515_can.h"
-#endif
+#include <Arduino.h>
 
 class Inverter
 {
 private:
-    EV_ECU1::ECU *evecu1;
-    MG_ECU1::ECU *mgecu1;
-    MG_ECU2::ECU *mgecu2;
+    EV_ECU1::ECU evecu1;
+    MG_ECU1::ECU mgecu1;
+    MG_ECU2::ECU mgecu2;
     unsigned short batteryVoltage;
+    CanBus *bus;
+    Dispatcher dispatcher;
+    TxScheduler txScheduler;
+    PeriodMonitor periodMonitor;
+    StateTrace stateTrace;
+
+    // CANコントローラの初期化状態 (CAN_STATE_*)
+    unsigned char canState;
+    unsigned long canStateTime;     // 状態が変わった時刻[ms]
+    unsigned long lastBusCheckTime; // 最後にバスオフを確認した時刻[ms]
+    unsigned char txErrorCount;     // 連続した送信失敗の回数
+    unsigned short reinitCount;     // 再初期化した回数
+    unsigned short busOffCount;     // バスオフから再初期化した回数
+    unsigned short initFailCount;   // 初期化に失敗した回数
+    unsigned long initMaxTime;      // CanBus::begin にかかった時間の最大値[us]
+
+    // CANコントローラを初期化する. 失敗したときは CAN_INIT_RETRY_PERIOD 後に再試行する
+    void beginCan(unsigned long now);
+
+    // 最後に送信したEV-ECU1のMassage(変化の検出用)
+    unsigned char lastEcuEnable;
+    unsigned char lastDischargeCommand;
+    long lastRequestTorque;
+
+    /**
+     * runInverter の状態遷移表のアクションを実行する
+     * flags : INVERTER_FLAG_AIR | INVERTER_FLAG_TORQUE_CONTROL
+     * 戻り値 : 実行後の flags
+     */
+    unsigned char runAction(unsigned char action, unsigned char flags, short torque);
+
+    // 受信したMassageをIDに対応するECUへ振り分ける, 戻り値は Dispatcher::dispatch と同じ
+    unsigned char dispatchMsg(unsigned long id, const unsigned char *buf, unsigned char len, unsigned char printFlag);
 
 public:
+    // 使用しているマイコンのCANコントローラで通信する (MEGA : MCP2515, R4 : 内蔵CAN)
     Inverter();
-    ~Inverter();
 
-    // CAN通信初期化処理
+    // 指定した CanBus で通信する (ホストPCでの Loopback_Bus, SocketCAN_Bus など)
+    Inverter(CanBus *bus);
+
+    /**
+     * CAN通信初期化処理
+     * 登録されているIDだけを受信するようにCANコントローラのフィルタを設定する
+     * 初期化を1回だけ試し, 失敗しても待たずに戻る (続きは serviceCan で再試行する)
+     */
     void init(void);
 
+    /**
+     * CANコントローラの初期化/再初期化を進める
+     * loop() の先頭で毎回呼ぶこと. 待ち続けることはない
+     * 初期化に失敗したときは CAN_INIT_RETRY_PERIOD ごとに再試行し,
+     * バスオフ, または CAN_REINIT_TX_ERROR 回連続の送信失敗で初期化し直す
+     * 送受信可能なときは送信待ちのMassageをCANコントローラへ渡す (CanBus::poll)
+     * now : millis()
+     * 戻り値 : 送受信可能(1) or 初期化中(0)
+     */
+    unsigned char serviceCan(unsigned long now);
+
+    // CANコントローラの初期化状態 (CAN_STATE_*)
+    inline unsigned char getCanState(void) { return canState; }
+
+    // バスオフ, 送信失敗から再初期化した回数
+    inline unsigned short getCanReinitCount(void) { return reinitCount; }
+
+    // バスオフから再初期化した回数 (送信失敗からの回数は getCanReinitCount との差)
+    inline unsigned short getCanBusOffCount(void) { return busOffCount; }
+
+    // CANコントローラの初期化に失敗した回数
+    inline unsigned short getCanInitFailCount(void) { return initFailCount; }
+
+    /**
+     * CanBus::begin にかかった時間の最大値[us]
+     * MCP2515_Bus はライブラリの中で待つので, その間 loop() が止まる時間の目安になる
+     */
+    inline unsigned long getCanInitMaxTime(void) { return initMaxTime; }
+
     /**
      * flags[0] = airFlag
      * flags[1] = torqueControlFlag
      * flags[2] = shutdownFlag
      * flags[3] = driveFlag
+     * MG-ECU1 の Working Status と flags から決まるイベントで状態遷移表を引き,
+     * アクションを1つ実行する (Inverter.cpp の ACTION_TABLE)
+     * Working Status, イベント, 出力が変わったときは stateTrace に記録する
     */
     void runInverter(unsigned char* flags, unsigned short batVol, float torque);
 
+    /**
+     * runInverter の固定小数点版
+     * torque : 1/FIXED_TORQUE_RESOLUTION Nm 単位 (0.5 Nm)
+     * runInverter(float) も torque を 0.5 Nm 単位に切り捨ててからこちらを呼ぶ
+    */
+    void runInverterFixed(unsigned char* flags, unsigned short batVol, short torque);
+
     /**
      * バッテリー電圧をセット
      * 280 <= batVol <= 400
@@ -74,24 +153,124 @@ public:
     */
     unsigned char torqueRequest(float torque);
 
+    /**
+     * トルク指令(固定小数点)
+     * torque : 1/FIXED_TORQUE_RESOLUTION Nm 単位 (0.5 Nm)
+     * MG-ECU2 の制限トルクとの比較も整数で行う
+    */
+    unsigned char fixedTorqueRequest(short torque);
+
     /**
      * EV-ECUへMassage送信
      * printFlag = 1 のとき, Buf をシリアルモニタに表示
-     * 戻り値 : 0(成功) or 1(失敗)
+     * 戻り値 : 0(成功) or 0以外(失敗, CanBus のエラーコード, 初期化中は CAN_NOT_READY)
      */
     int sendMsgToInverter(unsigned char printFlag);
 
     /**
-     * 受信したMassageを読み取る
+     * EV-ECU1のMassageを送信するタイミングか判定する
+     * TX_PERIOD ごと, または ecuEnable, dischargeCommand の変化,
+     * TX_TORQUE_STEP 以上の要求トルクの変化があったときに 1 を返す
+     * 1 が返ったら必ず sendMsgToInverter を呼ぶこと
+     * now : MsTimer2/AGTimerR4 で数えた時刻[ms]
+     */
+    unsigned char isTxDue(unsigned long now);
+
+    inline TxScheduler *getTxScheduler(void) { return &txScheduler; }
+
+    /**
+     * 受信周期のタイムアウトを判定する
+     * readMsgFromInverter の後に毎回呼ぶこと
+     * now : micros()
+     * 戻り値 : タイムアウト中のIDの数 (MG-ECU1 : MG_ECU1_TIMEOUT, MG-ECU2 : MG_ECU2_TIMEOUT)
+     */
+    inline unsigned char checkRxTimeout(unsigned long now) { return periodMonitor.check(now); }
+
+    // IDごとの受信間隔の統計
+    inline PeriodMonitor *getPeriodMonitor(void) { return &periodMonitor; }
+
+    // runInverter の状態遷移の記録
+    inline StateTrace *getStateTrace(void) { return &stateTrace; }
+
+    /**
+     * 状態遷移の記録を古い順にシリアルモニタに表示する
+     */
+    void printStateTrace(void);
+
+    /**
+     * シリアルから受け取ったコマンドを処理する
+     * INVERTER_CMD_TRACE : printStateTrace()
+     * INVERTER_CMD_CAN   : printCanStatus()
+     * 戻り値 : 処理した(1) or Inverter のコマンドではない(0)
+     */
+    unsigned char command(int c);
+
+    /**
+     * 受信したMassageをまとめて読み取る
+     * 溜まっているMassageを古い順に全て(最大 RX_BUFFER_SIZE 個)読み取り, IDに対応するECUへ振り分ける
      * printFlag = 1 のときID, Buf をシリアルモニタに表示
-     * 戻り値は受信したMassageのID(失敗時は0を返す)
+     * 初期化中は何も読まずに 0 を返す
+     * 戻り値は読み取ったMassageの数
      */
-    unsigned long readMsgFromInverter(unsigned char printFlag);
+    unsigned char readMsgFromInverter(unsigned char printFlag);
+
+    /**
+     * 受信したMassageの処理関数を登録する
+     * MG-ECU1, MG-ECU2 はコンストラクタで登録済み
+     * 受信フィルタは init() で設定するので, init() より前に登録すること
+     * timeout : 受信周期のタイムアウト[us] (0 のときは受信間隔の統計だけ取る)
+     * 戻り値 : 0(成功) or 1(失敗)
+     */
+    unsigned char addMsgHandler(unsigned long id, MsgHandler handler, void *ecu, unsigned long timeout = 0);
+
+    // 指定したIDのMassageを受信した回数
+    inline unsigned short getReceivedCount(unsigned long id) { return dispatcher.getRxCount(id); }
+
+    // 登録されていないIDのMassageを受信した回数(受信フィルタを通り抜けてソフトウェアで捨てた数)
+    inline unsigned short getUnknownCount(void) { return dispatcher.getUnknownCount(); }
+
+    // DLCが足りないなどで処理せずに捨てたMassageの数
+    inline unsigned short getInvalidCount(void) { return dispatcher.getInvalidCount(); }
+
+    // 受信バッファに溜まっているMassageの数
+    inline unsigned char getRxCount(void) { return bus->available(); }
+
+    // 受信バッファに溜まったMassageの数の最大値
+    inline unsigned char getRxMaxCount(void) { return bus->getMaxCount(); }
+
+    // 受信バッファが一杯で捨てたMassageの数
+    inline unsigned short getRxOverflowCount(void) { return bus->getOverflowCount(); }
+
+    // CANコントローラの受信バッファでオーバーフローが発生した回数
+    inline unsigned short getCtrlOverflowCount(void) { return bus->getCtrlOverflowCount(); }
+
+    // CANコントローラからMassageを読み出せなかった回数
+    inline unsigned short getCtrlReadErrorCount(void) { return bus->getReadErrorCount(); }
+
+    // 送信待ちのMassageの数の最大値 (R4_Bus 以外は 0)
+    inline unsigned char getTxMaxCount(void) { return bus->getTxMaxCount(); }
+
+    // 送信待ちが一杯で捨てたMassageの数
+    inline unsigned short getTxDropCount(void) { return bus->getTxDropCount(); }
+
+    // 送信を要求してからCANコントローラに渡すまでの最大[us]
+    inline unsigned long getTxMaxLatency(void) { return bus->getTxMaxLatency(); }
+
+    /**
+     * CANの送受信の統計をシリアルモニタに表示する
+     */
+    void printCanStatus(void);
 
     /**
      * シリアルモニタにbufのビットを全て表示する
      */
-    void checkBuf(unsigned char *buf);
+    void checkBuf(const unsigned char *buf);
+
+    /**
+     * 指定したIDのECUのMassage(8byte)を buf にコピーする
+     * 戻り値 : 0(成功) or 1(不正なID, buf は変更しない)
+     */
+    unsigned char getMsg(unsigned long id, unsigned char *buf);
 
     /**
      * 指定したIDのECUのMassageのビットをシリアルモニタに表示
@@ -112,4 +291,4 @@ inline uint32_t CanStandardId(uint32_t const id)
 }
 */
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
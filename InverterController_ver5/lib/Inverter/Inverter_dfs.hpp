@@ -15,10 +15,69 @@ const int SPI_CS_PIN = 9;
 const int CAN_INT_PIN = 2;
 #endif
 
+/**
+ * Configuration when using Arduino UNO R4
+ * 標準IDの受信に使うメールボックスの数(受信フィルタの数)
+*/
+#define R4_STANDARD_FILTER_NUM (8)
+
+// シリアルモニタの通信速度 (テレメトリを落とさないように 1 Mbaud, platformio.ini の monitor_speed と合わせる)
+#define SERIAL_BAUD (1000000)
+
 #define MINIMUM_BATTERY_VOLTAGE (250)
 #define MAXIMUM_BATTERY_VOLTAGE (400)
 #define MINIMUM_INPUT_VOLTAGE (50)
 
+// 固定小数点トルクの分解能 1/FIXED_TORQUE_RESOLUTION Nm (EV-ECU1 要求トルクの分解能 0.5 Nm)
+#ifndef FIXED_TORQUE_RESOLUTION
+#define FIXED_TORQUE_RESOLUTION (2)
+#endif
+
+// EV-ECU1 送信スケジュール
+#define TX_PERIOD (10)      // 送信周期[ms]
+#define TX_TORQUE_STEP (20) // 周期を待たずに送信する要求トルクの変化量[0.5 Nm]
+
+// CANコントローラの初期化/再初期化 (Inverter::serviceCan)
+#define CAN_STATE_INIT (0)          // 初期化待ち
+#define CAN_STATE_RETRY (1)         // 初期化に失敗, CAN_INIT_RETRY_PERIOD 後に再試行
+#define CAN_STATE_READY (2)         // 送受信可能
+#define CAN_INIT_RETRY_PERIOD (100) // 初期化の再試行間隔[ms]
+#define CAN_BUS_CHECK_PERIOD (100)  // バスオフを確認する間隔[ms]
+#define CAN_REINIT_TX_ERROR (3)     // 再初期化する連続送信失敗回数
+#define CAN_NOT_READY (-1)          // 初期化が終わっていないときの sendMsgToInverter の戻り値
+#define CAN_TX_QUEUE_FULL (-2)      // 送信待ちが一杯でフレームを捨てたときの CanBus::write の戻り値
+#define CAN_TX_OVERWRITTEN (-3)     // 同じIDの前のフレームが送れないまま置き換えたときの CanBus::write の戻り値
+#define CAN_TX_TIMEOUT (-4)         // 送信待ちのフレームが TX_PERIOD より長く待っているときの CanBus::write の戻り値
+
+// 受信周期の監視 (PeriodMonitor)
+#define MG_ECU1_TIMEOUT (50000UL)  // MG-ECU1 のタイムアウト[us] (送信周期 10ms)
+#define MG_ECU2_TIMEOUT (500000UL) // MG-ECU2 のタイムアウト[us] (送信周期 100ms)
+
+// runInverter のフラグ, 状態遷移の記録の出力
+#define INVERTER_FLAG_AIR (0x01)
+#define INVERTER_FLAG_TORQUE_CONTROL (0x02)
+#define INVERTER_FLAG_ECU_ENABLE (0x04) // 記録のみ (EV-ECU1 MG-ECU実行要求)
+#define INVERTER_FLAG_DISCHARGE (0x08)  // 記録のみ (EV-ECU1 平滑コンデンサ放電要求)
+
+// runInverter の状態遷移表のイベント
+#define INVERTER_EVENT_IDLE (0)     // シャットダウンでも Ready to Drive でもない
+#define INVERTER_EVENT_DRIVE (1)    // Ready to Drive
+#define INVERTER_EVENT_SHUTDOWN (2) // シャットダウン
+#define INVERTER_EVENT_NUM (3)
+
+// runInverter の状態遷移表のアクション
+#define INVERTER_ACTION_NONE (0)
+#define INVERTER_ACTION_SHUTDOWN (1)         // AIR OFF, 要求トルク 0, MG-ECU実行要求 OFF
+#define INVERTER_ACTION_SHUTDOWN_STANDBY (2) // SHUTDOWN に加えて放電要求 OFF
+#define INVERTER_ACTION_PRECHARGE (3)        // プリチャージ完了で MG-ECU実行要求 ON, AIR ON
+#define INVERTER_ACTION_TORQUE (4)           // トルク制御開始, トルク指令
+#define INVERTER_ACTION_DISCHARGE (5)        // 急速放電中は AIR OFF
+#define INVERTER_ACTION_STANDBY (6)          // AIR OFF, 全ての要求を OFF
+
+#define INVERTER_TRACE_SIZE (16) // 状態遷移を記録する数 (2のべき乗にすること)
+#define INVERTER_CMD_TRACE ('i') // 状態遷移の記録をシリアルモニタに表示するコマンド
+#define INVERTER_CMD_CAN ('c')   // CANの送受信の統計をシリアルモニタに表示するコマンド
+
 // ID
 #define EV_ECU1_ID (0x301)
 #define MG_ECU1_ID (0x311)
@@ -0,0 +1,93 @@
+#include "Loopback_Bus.hpp"
+#include <Arduino.h>
+#include <string.h>
+
+Loopback_Bus::Loopback_Bus()
+    : peer(nullptr), filterNum(0), beginFlag(0), busOffFlag(0)
+{
+}
+
+void Loopback_Bus::connect(Loopback_Bus *peer)
+{
+    this->peer = peer;
+    peer->peer = this;
+}
+
+unsigned char Loopback_Bus::begin(const unsigned long *ids, unsigned char num)
+{
+    if (num > LOOPBACK_FILTER_NUM || busOffFlag)
+    {
+        return 1;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        filterIDs[i] = ids[i];
+    }
+    filterNum = num;
+    beginFlag = 1;
+
+    return 0;
+}
+
+unsigned char Loopback_Bus::accept(unsigned long id)
+{
+    for (int i = 0; i < filterNum; i++)
+    {
+        if (filterIDs[i] == id)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+unsigned char Loopback_Bus::deliver(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    // 初期化されていないノードはACKを返さないので送信失敗になる
+    if (!beginFlag)
+    {
+        return 1;
+    }
+
+    // ハードウェアのフィルタと同じく, 受信しないIDは受信バッファに入れない
+    if (!accept(id))
+    {
+        return 0;
+    }
+
+    CAN_FRAME *frame = rxBuffer.reserve();
+
+    frame->id = id;
+    frame->len = len;
+    memcpy(frame->buf, buf, len);
+    frame->timestamp = micros();
+    rxBuffer.commit(frame);
+
+    return 0;
+}
+
+int Loopback_Bus::write(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    if (len > 8 || busOffFlag)
+    {
+        return 1;
+    }
+
+    return (peer != nullptr ? peer : this)->deliver(id, len, buf);
+}
+
+unsigned char Loopback_Bus::read(CAN_FRAME *frame)
+{
+    CAN_FRAME *front = rxBuffer.front();
+
+    if (front == nullptr)
+    {
+        return 0;
+    }
+
+    *frame = *front;
+    rxBuffer.pop();
+    return 1;
+}
@@ -0,0 +1,51 @@
+#ifndef _LOOPBACK_BUS_H_
+#define _LOOPBACK_BUS_H_
+
+#include "CanBus.hpp"
+
+#define LOOPBACK_FILTER_NUM (8) // 受信するIDの最大数
+
+/**
+ * プロセス内の仮想CANバス
+ * connect() した相手へ送信したフレームがそのまま相手の受信バッファに入る
+ * 相手がいないときは自分の受信バッファに戻る
+ * ホストPCで Inverter とシミュレータを同じプロセスで動かすときに使う
+ */
+class Loopback_Bus : public CanBus
+{
+private:
+    RxBuffer rxBuffer;
+    Loopback_Bus *peer;
+    unsigned long filterIDs[LOOPBACK_FILTER_NUM];
+    unsigned char filterNum;
+    unsigned char beginFlag;
+    unsigned char busOffFlag;
+
+    unsigned char accept(unsigned long id);
+    unsigned char deliver(unsigned long id, unsigned char len, const unsigned char *buf);
+
+public:
+    Loopback_Bus();
+
+    // 2つのバスを接続する
+    void connect(Loopback_Bus *peer);
+
+    /**
+     * バスオフを模擬する (ホストPCで再初期化を試すため)
+     * バスオフの間は送信に失敗し, begin() も失敗する
+     */
+    inline void setBusOff(unsigned char busOff) { busOffFlag = busOff; }
+
+    unsigned char begin(const unsigned long *ids, unsigned char num) override;
+    int write(unsigned long id, unsigned char len, const unsigned char *buf) override;
+    unsigned char read(CAN_FRAME *frame) override;
+    inline const CAN_FRAME *peek(void) override { return rxBuffer.front(); }
+    inline void release(void) override { rxBuffer.pop(); }
+
+    inline unsigned char available(void) override { return rxBuffer.getCount(); }
+    inline unsigned char getMaxCount(void) override { return rxBuffer.getMaxCount(); }
+    inline unsigned short getOverflowCount(void) override { return rxBuffer.getOverflowCount(); }
+    inline unsigned char isBusOff(void) override { return busOffFlag; }
+};
+
+#endif
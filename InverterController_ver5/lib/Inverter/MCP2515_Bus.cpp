@@ -0,0 +1,140 @@
+#include "MCP2515_Bus.hpp"
+
+#if defined(ARDUINO) && !defined(ARDUINO_UNO_R4)
+
+#include "CANFilter.hpp"
+
+MCP2515_Bus *MCP2515_Bus::instance = nullptr;
+
+MCP2515_Bus::MCP2515_Bus(const int csPin, const int intPin)
+    : can(csPin), intPin(intPin), lastOverflow(0)
+{
+}
+
+unsigned char MCP2515_Bus::begin(const unsigned long *ids, unsigned char num)
+{
+    if (CAN_OK != can.begin(CAN_500KBPS))
+    {
+        return 1;
+    }
+
+    // MCP2515 は初期化でフィルタがリセットされるので begin() の後に設定する
+    setFilter(ids, num);
+
+    if (instance == nullptr)
+    {
+        instance = this;
+
+        // 受信割り込み中のSPI通信と loop() 側のSPI通信が衝突しないようにする
+        SPI.usingInterrupt(digitalPinToInterrupt(intPin));
+        pinMode(intPin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(intPin), receiveISR, FALLING);
+    }
+
+    // 割り込み設定前に受信したフレームを読み出す(INTがLowのままだと立ち下がりが来ない)
+    noInterrupts();
+    receive();
+    interrupts();
+
+    return 0;
+}
+
+void MCP2515_Bus::setFilter(const unsigned long *ids, unsigned char num)
+{
+    CAN_FILTER filter;
+
+    calcAcceptanceFilter(ids, num, &filter);
+
+    for (int i = 0; i < CAN_FILTER_MASK_NUM; i++)
+    {
+        can.init_Mask(i, 0, filter.mask[i]);
+    }
+
+    for (int i = 0; i < CAN_FILTER_FILT_NUM; i++)
+    {
+        can.init_Filt(i, 0, filter.filt[i]);
+    }
+}
+
+void MCP2515_Bus::receiveISR(void)
+{
+    instance->receive();
+}
+
+/**
+ * CAN_INT_PIN の立ち下がりで呼ばれる受信割り込み
+ * MCP2515の受信バッファ(2個)をリングバッファへ読み出す
+ * SPIの異常で読み出しに失敗し続けても割り込みから抜けられるように, 読む回数は受信バッファの数までにする
+ * 読み残したフレームは poll() で読み出す
+ */
+void MCP2515_Bus::receive(void)
+{
+    unsigned char eflg = 0;
+
+    for (unsigned char i = 0; i < MCP2515_RX_BUF_NUM && CAN_MSGAVAIL == can.checkReceive(); i++)
+    {
+        CAN_FRAME *frame = rxBuffer.reserve();
+
+        if (CAN_OK != can.readMsgBufID(&frame->id, &frame->len, frame->buf))
+        {
+            rxBuffer.countReadError();
+            break;
+        }
+
+        frame->timestamp = micros();
+        rxBuffer.commit(frame);
+    }
+
+    // EFLGのオーバーフロービットはクリアされるまで保持されるので立ち上がりだけ数える
+    can.checkError(&eflg);
+    unsigned char overflow = eflg & (MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR);
+    if (overflow && !lastOverflow)
+    {
+        rxBuffer.countCtrlOverflow();
+    }
+    lastOverflow = overflow;
+}
+
+void MCP2515_Bus::poll(void)
+{
+    if (instance != this || digitalRead(intPin) != LOW)
+    {
+        return;
+    }
+
+    // 受信割り込みと同時にリングバッファへ書き込まないようにする
+    noInterrupts();
+    receive();
+    interrupts();
+}
+
+unsigned char MCP2515_Bus::isBusOff(void)
+{
+    unsigned char eflg = 0;
+
+    // 受信割り込みのSPI通信とは SPI.usingInterrupt で排他される
+    can.checkError(&eflg);
+
+    return (eflg & MCP_EFLG_TXBO) != 0;
+}
+
+int MCP2515_Bus::write(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    return can.sendMsgBuf(id, 0, len, buf);
+}
+
+unsigned char MCP2515_Bus::read(CAN_FRAME *frame)
+{
+    CAN_FRAME *front = rxBuffer.front();
+
+    if (front == nullptr)
+    {
+        return 0;
+    }
+
+    *frame = *front;
+    rxBuffer.pop();
+    return 1;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef _MCP2515_BUS_H_
+#define _MCP2515_BUS_H_
+
+#include "CanBus.hpp"
+#include "Inverter_dfs.hpp"
+
+#if defined(ARDUINO) && !defined(ARDUINO_UNO_R4)
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "mcp2515_can.h"
+
+#define MCP2515_RX_BUF_NUM (2) // MCP2515の受信バッファの数 (RXB0, RXB1)
+
+/**
+ * CAN Bus Shield (MCP2515) の CanBus
+ * 受信はINTピンの立ち下がり割り込みでリングバッファへ読み出す
+ * 割り込みは1つなので, インスタンスは1つだけ作ること
+ *
+ * begin() は CanBus::begin の「すぐ戻る」を満たさない
+ * CAN_BUS_Shield ライブラリの begin() はMCP2515のリセット後に delay() で待ち,
+ * init_Mask/init_Filt もコンフィグモードへの切り替えを待つので, その間 loop() が止まる
+ * 待ち時間はライブラリの版で変わるので, Inverter::getCanInitMaxTime (テレメトリの canInitMax) で実測すること
+ * 再初期化は CAN_INIT_RETRY_PERIOD ごと, バスオフか連続送信失敗のときだけなので, 止まるのはその時だけ
+ */
+class MCP2515_Bus : public CanBus
+{
+private:
+    mcp2515_can can;
+    const int intPin;
+    RxBuffer rxBuffer;          // 受信割り込みで読み出したフレーム
+    unsigned char lastOverflow; // 前回の割り込みでのEFLGオーバーフロービット
+
+    static MCP2515_Bus *instance; // 受信割り込みから参照するインスタンス
+
+    static void receiveISR(void);
+    void receive(void);
+    void setFilter(const unsigned long *ids, unsigned char num);
+
+public:
+    MCP2515_Bus(const int csPin, const int intPin);
+
+    unsigned char begin(const unsigned long *ids, unsigned char num) override;
+    int write(unsigned long id, unsigned char len, const unsigned char *buf) override;
+    unsigned char read(CAN_FRAME *frame) override;
+
+    /**
+     * 受信割り込みで読み切れなかったフレームを読み出す
+     * INTがLowのままだと次の立ち下がりが来ないので, loop() 側で確認する
+     */
+    void poll(void) override;
+    inline const CAN_FRAME *peek(void) override { return rxBuffer.front(); }
+    inline void release(void) override { rxBuffer.pop(); }
+
+    inline unsigned char available(void) override { return rxBuffer.getCount(); }
+    inline unsigned char getMaxCount(void) override { return rxBuffer.getMaxCount(); }
+    inline unsigned short getOverflowCount(void) override { return rxBuffer.getOverflowCount(); }
+    inline unsigned short getCtrlOverflowCount(void) override { return rxBuffer.getCtrlOverflowCount(); }
+    inline unsigned short getReadErrorCount(void) override { return rxBuffer.getReadErrorCount(); }
+    unsigned char isBusOff(void) override;
+};
+
+#endif
+
+#endif
@@ -2,69 +2,66 @@
 #define _MG_ECU1_H_
 
 #include "Parameter.hpp"
+#include "Signal.hpp"
 
 namespace MG_ECU1
 {
-    union MSG // CAN Massage
-    {
-        unsigned char msgs[8];
-        struct
-        {
-            unsigned char shutdownEnable : 1; // MG_ECUシャットダウン許可
-            unsigned char PWM : 2;            // ゲート駆動状態
-            unsigned char workingStatus : 3;  // 制御状態
-            unsigned char reserve0 : 2;
-            unsigned short motorSpeed : 16;        // モータ回転数 Range 0~28000
-            unsigned short motorPhaseCurrent : 10; // モータ相電流 Range 0~1000
-            unsigned short inputDCVoltage : 10;    // 入力直流電圧 Range 0~500
-            unsigned long reserve1 : 19;
-            unsigned char failureStatus : 3; // 異常状態
-        };
-
-        MSG();
-    };
+    typedef Parameter<-14000, 1, 1, -14000, 14000> MotorSpeedPara; // モータ回転数
+    typedef Parameter<0, 1, 2, 0, 500> MotorPhaseCurrentPara;       // モータ相電流
+
+    // CAN Massage のシグナル <開始ビット, ビット長, バイトオーダー, 変換>
+    typedef Signal<0, 1> ShutdownEnable;                                          // MG_ECUシャットダウン許可
+    typedef Signal<1, 2> PWMState;                                                // ゲート駆動状態
+    typedef Signal<3, 3> WorkingStatus;                                           // 制御状態
+    typedef Signal<8, 16, SIGNAL_INTEL, MotorSpeedPara> MotorSpeed;               // モータ回転数 Range 0~28000
+    typedef Signal<24, 10, SIGNAL_INTEL, MotorPhaseCurrentPara> MotorPhaseCurrent; // モータ相電流 Range 0~1000
+    typedef Signal<34, 10> InputDCVoltage;                                        // 入力直流電圧 Range 0~500
+    typedef Signal<61, 3> FailureStatus;                                          // 異常状態
 
     class ECU
     {
     private:
         const unsigned long id;
-        union MSG *msg;
-        Parameter *motorSpeedPara;        // モータ回転数
-        Parameter *motorPhaseCurrentPara; // モータ相電流
+        unsigned char msg[8]; // CAN Massage
 
     public:
         ECU(unsigned long id);
-        ~ECU();
 
         unsigned long getID() { return id; };
 
         // Massage取得, 指定したインデックスが0~7以外の時は0を返す
         unsigned char getMsgByte(unsigned char index);
 
-        inline unsigned char getShutdownEnable() { return msg->shutdownEnable; };
-        inline unsigned char getPWM() { return msg->PWM; };
-        inline unsigned char getWorkingStatus() { return msg->workingStatus; };
+        // Massageの先頭ポインタ(8byte)
+        inline const unsigned char *getMsgBuf() { return msg; };
+
+        inline unsigned char getShutdownEnable() { return ShutdownEnable::get(msg); };
+        inline unsigned char getPWM() { return PWMState::get(msg); };
+        inline unsigned char getWorkingStatus() { return WorkingStatus::get(msg); };
 
         // 戻り値はPhysical Value
         float getMotorSpeed();
 
+        // 戻り値はPhysical Value(整数)
+        inline long getIntMotorSpeed() { return MotorSpeed::getPhysicalInt(msg); };
+
         // 戻り値はNormal Value
-        inline unsigned short getNormalMotorSpeed() { return msg->motorSpeed; };
+        inline unsigned short getNormalMotorSpeed() { return MotorSpeed::get(msg); };
 
         // 戻り値はPhysical Value
         float getMotorPhaseCurrent();
 
         // 戻り値はNormal Value
-        inline unsigned short getNormalMotorPhaseCurrent() { return msg->motorPhaseCurrent; };
+        inline unsigned short getNormalMotorPhaseCurrent() { return MotorPhaseCurrent::get(msg); };
 
         // 戻り値はPhysical Value
-        inline unsigned short getInputDCVoltage() { return msg->inputDCVoltage; };
+        inline unsigned short getInputDCVoltage() { return InputDCVoltage::get(msg); };
 
         // 戻り値はPhysical Value
-        inline unsigned char getFailureStatus() { return msg->failureStatus; };
+        inline unsigned char getFailureStatus() { return FailureStatus::get(msg); };
 
         // 受信した Message を配列 buf に渡して変数 msg に保存
-        unsigned char setMsg(unsigned char *buf);
+        unsigned char setMsg(const unsigned char *buf);
     };
 }
 
@@ -1,32 +1,19 @@
 #include "MG_ECU2.hpp"
-
-MG_ECU2::MSG::MSG()
-    : inverterTemp(0x3C), maxAvailableMotorTorque(0x0), maxAvailableGenerateTorque(0x7D0), motorTemp(0x3C){}
+#include <string.h>
 
 MG_ECU2::ECU::ECU(unsigned long id)
-    : id(id)
-{
-    msg = new MSG();
-    inverterTemperaturePara = new Parameter(-40, 1, -40, 210);
-    maximumAvailableMotoringTorquePara = new Parameter(0, 0.5f, 0, 1000);
-    maximumAvailableGeneratingTorquePara = new Parameter(-1000, 0.5f, -1000, 0);
-    motorTemperaturePara = new Parameter(-40, 1, -40, 210);
-}
-
-MG_ECU2::ECU::~ECU()
+    : id(id), msg{0, 0, 0, 0, 0, 0, 0, 0}
 {
-    delete (msg);
-    delete (inverterTemperaturePara);
-    delete (maximumAvailableMotoringTorquePara);
-    delete (maximumAvailableGeneratingTorquePara);
-    delete (motorTemperaturePara);
+    InverterTemp::set(msg, 0x3C);
+    MaxAvailableGenerateTorque::set(msg, 0x7D0);
+    MotorTemp::set(msg, 0x3C);
 }
 
 unsigned char MG_ECU2::ECU::getMsgByte(unsigned char index)
 {
     if (0 <= index && index <= 7)
     {
-        return msg->msgs[index];
+        return msg[index];
     }
 
     return 0;
@@ -34,30 +21,27 @@ unsigned char MG_ECU2::ECU::getMsgByte(unsigned char index)
 
 float MG_ECU2::ECU::getInverterTemp()
 {
-    return inverterTemperaturePara->calcPhysical(msg->inverterTemp);
+    return InverterTemp::getPhysical(msg);
 }
 
 float MG_ECU2::ECU::getMaxAvailableMotorTorque()
 {
-    return maximumAvailableMotoringTorquePara->calcPhysical(msg->maxAvailableMotorTorque);
+    return MaxAvailableMotorTorque::getPhysical(msg);
 }
 
 float MG_ECU2::ECU::getMaxAvailableGenerateTorque()
 {
-    return maximumAvailableGeneratingTorquePara->calcPhysical(msg->maxAvailableGenerateTorque);
+    return MaxAvailableGenerateTorque::getPhysical(msg);
 }
 
 float MG_ECU2::ECU::getMotorTemp()
 {
-    return motorTemperaturePara->calcPhysical(msg->motorTemp);
+    return MotorTemp::getPhysical(msg);
 }
 
-unsigned char MG_ECU2::ECU::setMsg(unsigned char *buf)
+unsigned char MG_ECU2::ECU::setMsg(const unsigned char *buf)
 {
-    for (int i = 0; i < 8; i++)
-    {
-        msg->msgs[i] = *(buf + i);
-    }
+    memcpy(msg, buf, sizeof(msg));
 
     return 0;
 }
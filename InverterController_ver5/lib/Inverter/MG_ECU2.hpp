@@ -2,68 +2,70 @@
 #define _MG_ECU2_H_
 
 #include "Parameter.hpp"
+#include "Signal.hpp"
 
 namespace MG_ECU2
 {
-    union MSG // Can Massage
-    {
-        unsigned char msgs[8];
-        struct
-        {
-            unsigned char inverterTemp : 8;                 // インバータ温度
-            unsigned short maxAvailableMotorTorque : 12;    // モータ上限制限トルク
-            unsigned short maxAvailableGenerateTorque : 12; // モータ下限制限トルク
-            unsigned char motorTemp : 8;                    // モータ温度
-        };
-
-        MSG();
-    };
+    typedef Parameter<-40, 1, 1, -40, 210> InverterTemperaturePara;            // インバータ温度
+    typedef Parameter<0, 1, 2, 0, 1000> MaxAvailableMotoringTorquePara;        // モータ上限制限トルク
+    typedef Parameter<-1000, 1, 2, -1000, 0> MaxAvailableGeneratingTorquePara; // モータ下限制限トルク
+    typedef Parameter<-40, 1, 1, -40, 210> MotorTemperaturePara;               // モータ温度
+
+    // CAN Massage のシグナル <開始ビット, ビット長, バイトオーダー, 変換>
+    typedef Signal<0, 8, SIGNAL_INTEL, InverterTemperaturePara> InverterTemp;                        // インバータ温度
+    typedef Signal<8, 12, SIGNAL_INTEL, MaxAvailableMotoringTorquePara> MaxAvailableMotorTorque;     // モータ上限制限トルク
+    typedef Signal<20, 12, SIGNAL_INTEL, MaxAvailableGeneratingTorquePara> MaxAvailableGenerateTorque; // モータ下限制限トルク
+    typedef Signal<32, 8, SIGNAL_INTEL, MotorTemperaturePara> MotorTemp;                             // モータ温度
 
     class ECU
     {
     private:
         const unsigned long id;
-        union MSG *msg;
-        Parameter *inverterTemperaturePara;              // インバータ温度
-        Parameter *maximumAvailableMotoringTorquePara;   // モータ上限制限トルク
-        Parameter *maximumAvailableGeneratingTorquePara; // モータ下限制限トルク
-        Parameter *motorTemperaturePara;                 // モータ温度
+        unsigned char msg[8]; // CAN Massage
 
     public:
         ECU(unsigned long id);
-        ~ECU();
 
         unsigned long getID() { return id; };
 
         // Massage取得, 指定したインデックスが0~7以外の時は0を返す
         unsigned char getMsgByte(unsigned char index);
 
+        // Massageの先頭ポインタ(8byte)
+        inline const unsigned char *getMsgBuf() { return msg; };
+
         // 戻り値はPhysical Value
         float getInverterTemp();
 
         // 戻り値はNormal Value
-        inline unsigned char getNormalInverterTemp() { return msg->inverterTemp; };
+        inline unsigned char getNormalInverterTemp() { return InverterTemp::get(msg); };
 
         // 戻り値はPhysical Value
         float getMaxAvailableMotorTorque();
 
         // 戻り値はNormal Value
-        inline unsigned short getNormalMaxAvailableMotorTorque() { return msg->maxAvailableMotorTorque; };
+        inline unsigned short getNormalMaxAvailableMotorTorque() { return MaxAvailableMotorTorque::get(msg); };
+
+        // 戻り値は0.5 Nm単位のPhysical Value
+        inline long getFixedMaxAvailableMotorTorque() { return MaxAvailableMotorTorque::getFixed(msg); };
 
         // 戻り値はPhysical Value
         float getMaxAvailableGenerateTorque();
 
         // 戻り値はNormal Value
-        inline unsigned short getNormalMaxAvailableGenerateTorque() { return msg->maxAvailableGenerateTorque; };
+        inline unsigned short getNormalMaxAvailableGenerateTorque() { return MaxAvailableGenerateTorque::get(msg); };
+
+        // 戻り値は0.5 Nm単位のPhysical Value
+        inline long getFixedMaxAvailableGenerateTorque() { return MaxAvailableGenerateTorque::getFixed(msg); };
 
         // 戻り値はPhysical Value
         float getMotorTemp();
 
         // 戻り値はNormal Value
-        inline unsigned char getNormalMotorTemp() { return msg->motorTemp; };
+        inline unsigned char getNormalMotorTemp() { return MotorTemp::get(msg); };
 
         // 受信した Message を配列 buf に渡して変数 msg に保存
-        unsigned char setMsg(unsigned char *buf);
+        unsigned char setMsg(const unsigned char *buf);
     };
 }
 
@@ -0,0 +1,154 @@
+#include "PeriodMonitor.hpp"
+
+PeriodMonitor::PeriodMonitor()
+    : entryNum(0)
+{
+}
+
+PERIOD_STAT *PeriodMonitor::find(unsigned long id)
+{
+    for (int i = 0; i < entryNum; i++)
+    {
+        if (stats[i].id == id)
+        {
+            return &stats[i];
+        }
+    }
+
+    return nullptr;
+}
+
+unsigned char PeriodMonitor::add(unsigned long id, unsigned long timeout)
+{
+    if (entryNum >= PERIOD_MONITOR_MAX_ENTRY || find(id) != nullptr)
+    {
+        return 1;
+    }
+
+    PERIOD_STAT *stat = &stats[entryNum++];
+
+    stat->id = id;
+    stat->timeout = timeout;
+    stat->lastTime = 0;
+    stat->received = 0;
+    stat->timeoutFlag = 0;
+    stat->timeoutCount = 0;
+    stat->last = 0;
+    stat->min = 0xFFFFFFFF;
+    stat->max = 0;
+    stat->sum = 0;
+    stat->count = 0;
+
+    return 0;
+}
+
+void PeriodMonitor::start(unsigned long now)
+{
+    for (int i = 0; i < entryNum; i++)
+    {
+        stats[i].lastTime = now;
+        stats[i].received = 0;
+    }
+}
+
+void PeriodMonitor::reset(void)
+{
+    for (int i = 0; i < entryNum; i++)
+    {
+        stats[i].last = 0;
+        stats[i].min = 0xFFFFFFFF;
+        stats[i].max = 0;
+        stats[i].sum = 0;
+        stats[i].count = 0;
+    }
+}
+
+void PeriodMonitor::update(unsigned long id, unsigned long timestamp)
+{
+    PERIOD_STAT *stat = find(id);
+
+    if (stat == nullptr)
+    {
+        return;
+    }
+
+    // 最初のフレームは間隔が無いので時刻だけ記録する
+    if (stat->received)
+    {
+        unsigned long period = timestamp - stat->lastTime;
+
+        stat->last = period;
+
+        if (period < stat->min)
+        {
+            stat->min = period;
+        }
+
+        if (stat->max < period)
+        {
+            stat->max = period;
+        }
+
+        // sum が溢れる前に sum と count を半分にする (平均は変わらない)
+        if (stat->sum & 0x80000000)
+        {
+            stat->sum >>= 1;
+            stat->count >>= 1;
+        }
+        stat->sum += period;
+        stat->count++;
+    }
+
+    stat->lastTime = timestamp;
+    stat->received = 1;
+    stat->timeoutFlag = 0;
+}
+
+unsigned char PeriodMonitor::check(unsigned long now)
+{
+    unsigned char num = 0;
+
+    for (int i = 0; i < entryNum; i++)
+    {
+        PERIOD_STAT *stat = &stats[i];
+
+        if (stat->timeout == 0)
+        {
+            continue;
+        }
+
+        // micros() の桁あふれをまたいでも差は正しい
+        // 読み出し中の割り込みで now より後の時刻が入っても負の経過時間として扱う
+        if ((long)(now - stat->lastTime) > (long)stat->timeout)
+        {
+            if (!stat->timeoutFlag)
+            {
+                stat->timeoutFlag = 1;
+                stat->timeoutCount++;
+            }
+        }
+
+        num += stat->timeoutFlag;
+    }
+
+    return num;
+}
+
+unsigned long PeriodMonitor::getMean(unsigned long id)
+{
+    const PERIOD_STAT *stat = find(id);
+
+    if (stat == nullptr || stat->count == 0)
+    {
+        return 0;
+    }
+
+    return stat->sum / stat->count;
+}
+
+unsigned char PeriodMonitor::isTimeout(unsigned long id)
+{
+    const PERIOD_STAT *stat = find(id);
+
+    return stat != nullptr && stat->timeoutFlag;
+}
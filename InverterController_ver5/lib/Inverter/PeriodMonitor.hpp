@@ -0,0 +1,97 @@
+#ifndef _PERIOD_MONITOR_H_
+#define _PERIOD_MONITOR_H_
+
+#define PERIOD_MONITOR_MAX_ENTRY (8) // 監視するIDの最大数
+
+// IDごとの受信間隔の統計
+struct PERIOD_STAT
+{
+    unsigned long id;
+    unsigned long timeout;      // タイムアウト時間[us] (0 のときは統計だけ取る)
+    unsigned long lastTime;     // 最後に受信した時刻[us]
+    unsigned long last;         // 直前の受信間隔[us]
+    unsigned long min;          // 受信間隔の最小値[us]
+    unsigned long max;          // 受信間隔の最大値[us]
+    unsigned long sum;          // 平均の計算用
+    unsigned short count;
+    unsigned short timeoutCount; // タイムアウトした回数
+    unsigned char received;     // start() の後に1回以上受信した
+    unsigned char timeoutFlag;  // タイムアウト中
+};
+
+/**
+ * IDごとの受信周期を監視する
+ * 時刻は受信割り込みで micros() を記録した CAN_FRAME::timestamp を使うので,
+ * 受信間隔は loop() の速さに左右されない
+ *
+ * update() は受信したフレームを読み出したとき, check() は受信バッファを読み切った後に呼ぶ
+ */
+class PeriodMonitor
+{
+private:
+    PERIOD_STAT stats[PERIOD_MONITOR_MAX_ENTRY];
+    unsigned char entryNum;
+
+    PERIOD_STAT *find(unsigned long id);
+
+public:
+    PeriodMonitor();
+
+    /**
+     * @fn      add
+     *
+     * @brief   監視するIDを登録する
+     *
+     * @param   id      MassageのID
+     * @param   timeout この時間[us]受信しないとタイムアウトにする (0 のときは統計だけ取る)
+     *
+     * @return  Success(0), Fail(1) 一杯 or 登録済みのID
+     */
+    unsigned char add(unsigned long id, unsigned long timeout);
+
+    /**
+     * @fn      start
+     *
+     * @brief   監視を始める (CANコントローラの初期化後に呼ぶ)
+     *          まだ受信していないIDは now からの経過時間でタイムアウトを判定する
+     */
+    void start(unsigned long now);
+
+    /**
+     * @fn      update
+     *
+     * @brief   受信したフレームの時刻を記録する. 登録されていないIDは無視する
+     *
+     * @param   timestamp 受信割り込みで記録した時刻[us]
+     */
+    void update(unsigned long id, unsigned long timestamp);
+
+    /**
+     * @fn      check
+     *
+     * @brief   タイムアウトを判定する
+     *
+     * @param   now 現在時刻[us] (受信バッファを読み切った後の micros())
+     *
+     * @return  タイムアウト中のIDの数
+     */
+    unsigned char check(unsigned long now);
+
+    // 統計をリセットする (登録とタイムアウトの状態はそのまま)
+    void reset(void);
+
+    /**
+     * @fn      getStat
+     *
+     * @return  IDの統計, 登録されていないIDの時は nullptr
+     */
+    inline const PERIOD_STAT *getStat(unsigned long id) { return find(id); }
+
+    // 受信間隔の平均[us], 登録されていない or 2回以上受信していない時は 0
+    unsigned long getMean(unsigned long id);
+
+    // タイムアウト中(1), 受信中 or 登録されていないID(0)
+    unsigned char isTimeout(unsigned long id);
+};
+
+#endif
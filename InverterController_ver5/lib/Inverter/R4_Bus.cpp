@@ -0,0 +1,148 @@
+#include "R4_Bus.hpp"
+
+#ifdef ARDUINO_UNO_R4
+
+#include "CANFilter.hpp"
+
+R4_Bus::R4_Bus()
+    : beginFlag(0)
+{
+}
+
+unsigned char R4_Bus::begin(const unsigned long *ids, unsigned char num)
+{
+    // 再初期化のときは一度止めてから初期化し直す
+    if (beginFlag)
+    {
+        CAN.end();
+        beginFlag = 0;
+    }
+
+    // 初期化し直す前の送信待ちは捨てる
+    txQueue.clear();
+
+    // R4 は begin() で受信メールボックスを設定するので先にフィルタを設定する
+    setFilter(ids, num);
+
+    if (!CAN.begin(CanBitRate::BR_500k))
+    {
+        return 1;
+    }
+
+    CAN.clearError();
+    beginFlag = 1;
+
+    return 0;
+}
+
+unsigned char R4_Bus::isBusOff(void)
+{
+    int err = 0;
+
+    return CAN.isError(err) && err == CAN_EVENT_ERR_BUS_OFF;
+}
+
+void R4_Bus::setFilter(const unsigned long *ids, unsigned char num)
+{
+    // メールボックスごとにIDを1つ割り当てて完全一致で受信する
+    // メールボックスが足りないときは共通するビットだけ比較する
+    unsigned long mask = CAN_STANDARD_ID_MASK;
+
+    if (num > R4_STANDARD_FILTER_NUM)
+    {
+        for (int i = 1; i < num; i++)
+        {
+            mask &= ~(ids[i] ^ ids[0]);
+        }
+    }
+
+    CAN.setFilterMask_Standard(mask);
+
+    for (int i = 0; i < R4_STANDARD_FILTER_NUM; i++)
+    {
+        CAN.setFilterId_Standard(i, num == 0 ? CAN_UNUSED_ID : (i < num ? ids[i] : ids[0]) & mask);
+    }
+}
+
+int R4_Bus::send(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    CanMsg const msg(CanStandardId(id), len, buf);
+
+    int const rc = CAN.write(msg);
+
+    // 成功時は書き込んだバイト数などの正の値が返るので 0 にそろえる
+    return rc < 0 ? rc : 0;
+}
+
+int R4_Bus::write(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    // 先に待っているフレームを送る
+    poll();
+
+    const unsigned long now = micros();
+
+    // 待っているフレームが無ければすぐに渡す
+    // メールボックスが一時的に埋まっているだけなら待たせて成功にする
+    if (txQueue.getCount() == 0)
+    {
+        const int rc = send(id, len, buf);
+        if (rc == 0)
+        {
+            return 0;
+        }
+
+        return txQueue.push(id, len, buf, now) ? 0 : rc;
+    }
+
+    // 追い越さないように, 待ちがあるときは後ろに並べる
+    // 前の周期のフレームが残っているときは送れていないので失敗を返す (中身は新しいものに置き換える)
+    int rc = 0;
+    if (txQueue.find(id) != nullptr)
+    {
+        rc = CAN_TX_OVERWRITTEN;
+    }
+    else if (now - txQueue.front()->time > TX_PERIOD * 1000UL)
+    {
+        rc = CAN_TX_TIMEOUT;
+    }
+
+    if (!txQueue.push(id, len, buf, now))
+    {
+        return CAN_TX_QUEUE_FULL;
+    }
+
+    return rc;
+}
+
+void R4_Bus::poll(void)
+{
+    TX_FRAME *frame;
+
+    while ((frame = txQueue.front()) != nullptr)
+    {
+        if (send(frame->id, frame->len, frame->buf) != 0)
+        {
+            break;
+        }
+        txQueue.pop(micros());
+    }
+}
+
+unsigned char R4_Bus::read(CAN_FRAME *frame)
+{
+    if (!CAN.available())
+    {
+        return 0;
+    }
+
+    CanMsg const msg = CAN.read();
+
+    // Arduino_CAN は受信時刻を残さないので, リングバッファから読み出した時刻で代用する
+    frame->id = msg.id;
+    frame->len = msg.data_length;
+    frame->timestamp = micros();
+    memcpy(frame->buf, msg.data, sizeof(frame->buf));
+    return 1;
+}
+
+#endif
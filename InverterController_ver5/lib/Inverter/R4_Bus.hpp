@@ -0,0 +1,49 @@
+#ifndef _R4_BUS_H_
+#define _R4_BUS_H_
+
+#include "CanBus.hpp"
+#include "TxQueue.hpp"
+#include "Inverter_dfs.hpp"
+
+#ifdef ARDUINO_UNO_R4
+
+#include <Arduino.h>
+#include <Arduino_CAN.h>
+
+/**
+ * Arduino UNO R4 内蔵CANの CanBus
+ * 受信したフレームは Arduino_CAN のリングバッファに溜まる
+ *
+ * 送信メールボックスが埋まっていて CAN.write が失敗したときは TxQueue で待たせ,
+ * 次の write / poll でメールボックスが空いたら送る (loop() を待たせない)
+ * 一時的に埋まっただけなら成功を返すが, 同じIDの前のフレームがまだ待っているときと
+ * TX_PERIOD より長く待っているフレームがあるときは送れていないので失敗を返す
+ * (Inverter の連続送信失敗の数に入り, 続けば再初期化される)
+ */
+class R4_Bus : public CanBus
+{
+private:
+    unsigned char beginFlag;
+    TxQueue txQueue;
+
+    int send(unsigned long id, unsigned char len, const unsigned char *buf);
+    void setFilter(const unsigned long *ids, unsigned char num);
+
+public:
+    R4_Bus();
+
+    unsigned char begin(const unsigned long *ids, unsigned char num) override;
+    int write(unsigned long id, unsigned char len, const unsigned char *buf) override;
+    unsigned char read(CAN_FRAME *frame) override;
+    void poll(void) override;
+
+    inline unsigned char available(void) override { return CAN.available(); }
+    inline unsigned char getTxMaxCount(void) override { return txQueue.getMaxCount(); }
+    inline unsigned short getTxDropCount(void) override { return txQueue.getDropCount(); }
+    inline unsigned long getTxMaxLatency(void) override { return txQueue.getMaxLatency(); }
+    unsigned char isBusOff(void) override;
+};
+
+#endif
+
+#endif
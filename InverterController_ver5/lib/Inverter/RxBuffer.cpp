@@ -0,0 +1,113 @@
+#include "RxBuffer.hpp"
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+// コンパイラによるメモリアクセスの並べ替えを防ぐ
+#define MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+RxBuffer::RxBuffer()
+    : head(0), tail(0), overflowCount(0), ctrlOverflowCount(0), readErrorCount(0), maxCount(0)
+{
+}
+
+CAN_FRAME *RxBuffer::reserve(void)
+{
+    if ((unsigned char)(head - tail) >= RX_BUFFER_SIZE)
+    {
+        overflowCount++;
+        return &scratch;
+    }
+
+    return &frames[head & (RX_BUFFER_SIZE - 1)];
+}
+
+void RxBuffer::commit(CAN_FRAME *frame)
+{
+    if (frame == &scratch)
+    {
+        return;
+    }
+
+    // フレームの中身を書き終えてから head を進める
+    MEMORY_BARRIER();
+    head++;
+
+    unsigned char count = head - tail;
+    if (maxCount < count)
+    {
+        maxCount = count;
+    }
+}
+
+CAN_FRAME *RxBuffer::front(void)
+{
+    if (head == tail)
+    {
+        return nullptr;
+    }
+
+    // head を読んでからフレームの中身を読む
+    MEMORY_BARRIER();
+    return &frames[tail & (RX_BUFFER_SIZE - 1)];
+}
+
+void RxBuffer::pop(void)
+{
+    if (head != tail)
+    {
+        // フレームを読み終えてから tail を進める
+        MEMORY_BARRIER();
+        tail++;
+    }
+}
+
+unsigned short RxBuffer::getOverflowCount(void)
+{
+    unsigned short count;
+
+    // 割り込みから呼ばれても割り込み許可状態を壊さないように読み出す
+#ifdef __AVR__
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        count = overflowCount;
+    }
+#else
+    count = overflowCount; // 32bitマイコンでは16bitの読み出しは不可分
+#endif
+    return count;
+}
+
+unsigned short RxBuffer::getCtrlOverflowCount(void)
+{
+    unsigned short count;
+
+    // 割り込みから呼ばれても割り込み許可状態を壊さないように読み出す
+#ifdef __AVR__
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        count = ctrlOverflowCount;
+    }
+#else
+    count = ctrlOverflowCount; // 32bitマイコンでは16bitの読み出しは不可分
+#endif
+    return count;
+}
+
+unsigned short RxBuffer::getReadErrorCount(void)
+{
+    unsigned short count;
+
+    // 割り込みから呼ばれても割り込み許可状態を壊さないように読み出す
+#ifdef __AVR__
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        count = readErrorCount;
+    }
+#else
+    count = readErrorCount; // 32bitマイコンでは16bitの読み出しは不可分
+#endif
+    return count;
+}
@@ -0,0 +1,73 @@
+#ifndef _RX_BUFFER_H_
+#define _RX_BUFFER_H_
+
+#define RX_BUFFER_SIZE (16) // 2のべき乗にすること
+
+// 受信したCANフレーム
+struct CAN_FRAME
+{
+    unsigned long id;
+    unsigned char len;
+    unsigned char buf[8];
+    unsigned long timestamp; // 受信した時刻[us] (受信割り込みの micros())
+};
+
+/**
+ * CAN受信用リングバッファ (Single Producer Single Consumer)
+ * 書き込み(reserve/commit)は受信割り込みから, 読み出し(front/pop)は loop() からのみ行う
+ * head は割り込み側, tail は loop() 側だけが更新するので割り込み禁止は不要
+ */
+class RxBuffer
+{
+private:
+    CAN_FRAME frames[RX_BUFFER_SIZE];
+    CAN_FRAME scratch;                      // バッファが一杯の時の読み捨て用
+    volatile unsigned char head;            // 次に書き込む位置
+    volatile unsigned char tail;            // 次に読み出す位置
+    volatile unsigned short overflowCount;  // バッファが一杯で捨てたフレーム数
+    volatile unsigned short ctrlOverflowCount; // CANコントローラ側で発生したオーバーフロー回数
+    volatile unsigned short readErrorCount; // CANコントローラからの読み出しに失敗した回数
+    volatile unsigned char maxCount;        // バッファに溜まったフレーム数の最大値
+
+public:
+    RxBuffer();
+
+    /**
+     * @fn      reserve
+     *
+     * @brief   書き込み先のフレームを確保する(割り込み側)
+     *          バッファが一杯の時は読み捨て用のフレームを返し, overflowCount を加算する
+     *
+     * @return  書き込み先のフレーム
+     */
+    CAN_FRAME *reserve(void);
+
+    // reserve で確保したフレームを確定する(割り込み側)
+    void commit(CAN_FRAME *frame);
+
+    // CANコントローラ側のオーバーフローを記録する(割り込み側)
+    inline void countCtrlOverflow(void) { ctrlOverflowCount++; }
+
+    // CANコントローラからの読み出しの失敗を記録する(割り込み側)
+    inline void countReadError(void) { readErrorCount++; }
+
+    /**
+     * @fn      front
+     *
+     * @brief   最も古いフレームを取得する(loop側)
+     *
+     * @return  フレームのポインタ, 空の時は nullptr
+     */
+    CAN_FRAME *front(void);
+
+    // front で取得したフレームを解放する(loop側)
+    void pop(void);
+
+    inline unsigned char getCount(void) { return (unsigned char)(head - tail); }
+    inline unsigned char getMaxCount(void) { return maxCount; }
+    unsigned short getOverflowCount(void);
+    unsigned short getCtrlOverflowCount(void);
+    unsigned short getReadErrorCount(void);
+};
+
+#endif
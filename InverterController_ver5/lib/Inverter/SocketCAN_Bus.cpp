@@ -0,0 +1,198 @@
+#include "SocketCAN_Bus.hpp"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <Arduino.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/can/error.h>
+
+SocketCAN_Bus::SocketCAN_Bus(const char *ifname)
+    : ifname(ifname), sock(-1), busOffFlag(0)
+{
+}
+
+SocketCAN_Bus::~SocketCAN_Bus()
+{
+    closeSocket();
+}
+
+void SocketCAN_Bus::closeSocket(void)
+{
+    if (sock >= 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+}
+
+unsigned char SocketCAN_Bus::begin(const unsigned long *ids, unsigned char num)
+{
+    closeSocket();
+
+    // フィルタに入らないIDを黙って捨てると受信できないので失敗にする
+    if (num > SOCKETCAN_FILTER_NUM)
+    {
+        return 1;
+    }
+
+    sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (sock < 0)
+    {
+        return 1;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+    {
+        closeSocket();
+        return 1;
+    }
+
+    // 標準IDのデータフレームだけを完全一致で受信する (num = 0 のときは何も受信しない)
+    struct can_filter filter[SOCKETCAN_FILTER_NUM];
+
+    for (int i = 0; i < num; i++)
+    {
+        filter[i].can_id = ids[i] & CAN_SFF_MASK;
+        filter[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+
+    if (setsockopt(sock, SOL_CAN_RAW, CAN_RAW_FILTER, num ? filter : nullptr, num * sizeof(filter[0])) < 0)
+    {
+        closeSocket();
+        return 1;
+    }
+
+    // バスオフと復帰はエラーフレームで通知される (受信フィルタとは別に設定する)
+    can_err_mask_t errMask = CAN_ERR_BUSOFF | CAN_ERR_RESTARTED;
+    if (setsockopt(sock, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errMask, sizeof(errMask)) < 0)
+    {
+        closeSocket();
+        return 1;
+    }
+    busOffFlag = 0;
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        closeSocket();
+        return 1;
+    }
+
+    const int fl = fcntl(sock, F_GETFL);
+    if (fl < 0 || fcntl(sock, F_SETFL, fl | O_NONBLOCK) < 0)
+    {
+        closeSocket();
+        return 1;
+    }
+
+    return 0;
+}
+
+int SocketCAN_Bus::write(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    struct can_frame frame;
+
+    if (sock < 0 || len > CAN_MAX_DLEN)
+    {
+        return 1;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id & CAN_SFF_MASK;
+    frame.can_dlc = len;
+    memcpy(frame.data, buf, len);
+
+    if (::write(sock, &frame, sizeof(frame)) != sizeof(frame))
+    {
+        return errno ? -errno : 1;
+    }
+
+    return 0;
+}
+
+void SocketCAN_Bus::receive(void)
+{
+    struct can_frame frame;
+
+    if (sock < 0)
+    {
+        return;
+    }
+
+    // RxBuffer が一杯のときは残りをソケットの受信キューに置いておく
+    while (rxBuffer.getCount() < RX_BUFFER_SIZE && recv(sock, &frame, sizeof(frame), 0) == sizeof(frame))
+    {
+        if (frame.can_id & CAN_ERR_FLAG)
+        {
+            busOffFlag = (frame.can_id & CAN_ERR_BUSOFF) != 0;
+            continue;
+        }
+
+        CAN_FRAME *dst = rxBuffer.reserve();
+
+        dst->id = frame.can_id & CAN_SFF_MASK;
+        dst->len = frame.can_dlc;
+        memcpy(dst->buf, frame.data, sizeof(dst->buf));
+        dst->timestamp = micros();
+        rxBuffer.commit(dst);
+    }
+}
+
+unsigned char SocketCAN_Bus::read(CAN_FRAME *frame)
+{
+    if (rxBuffer.getCount() == 0)
+    {
+        receive();
+    }
+
+    CAN_FRAME *front = rxBuffer.front();
+
+    if (front == nullptr)
+    {
+        return 0;
+    }
+
+    *frame = *front;
+    rxBuffer.pop();
+    return 1;
+}
+
+const CAN_FRAME *SocketCAN_Bus::peek(void)
+{
+    if (rxBuffer.getCount() == 0)
+    {
+        receive();
+    }
+
+    return rxBuffer.front();
+}
+
+unsigned char SocketCAN_Bus::available(void)
+{
+    receive();
+    return rxBuffer.getCount();
+}
+
+unsigned char SocketCAN_Bus::isBusOff(void)
+{
+    receive();
+    return busOffFlag;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _SOCKETCAN_BUS_H_
+#define _SOCKETCAN_BUS_H_
+
+#include "CanBus.hpp"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#define SOCKETCAN_FILTER_NUM (16) // 受信するIDの最大数 (超えると begin が失敗する)
+
+/**
+ * Linux SocketCAN の CanBus (can0, vcan0 など)
+ * 受信はソケットをノンブロッキングで読み, RxBuffer に溜めてから読み出す
+ *
+ * vcan0 の作り方
+ *  $ sudo modprobe vcan
+ *  $ sudo ip link add dev vcan0 type vcan
+ *  $ sudo ip link set up vcan0
+ */
+class SocketCAN_Bus : public CanBus
+{
+private:
+    const char *ifname;
+    int sock;
+    RxBuffer rxBuffer;
+    unsigned char busOffFlag; // エラーフレームで通知されたバスオフ
+
+    void closeSocket(void);
+
+    // ソケットに届いているフレームを全て RxBuffer へ移す
+    void receive(void);
+
+public:
+    SocketCAN_Bus(const char *ifname);
+    ~SocketCAN_Bus();
+
+    unsigned char begin(const unsigned long *ids, unsigned char num) override;
+    int write(unsigned long id, unsigned char len, const unsigned char *buf) override;
+    unsigned char read(CAN_FRAME *frame) override;
+    const CAN_FRAME *peek(void) override;
+    inline void release(void) override { rxBuffer.pop(); }
+    unsigned char available(void) override;
+    unsigned char isBusOff(void) override;
+
+    inline unsigned char getMaxCount(void) override { return rxBuffer.getMaxCount(); }
+    inline unsigned short getOverflowCount(void) override { return rxBuffer.getOverflowCount(); }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#include "StateTrace.hpp"
+
+static_assert((INVERTER_TRACE_SIZE & (INVERTER_TRACE_SIZE - 1)) == 0, "INVERTER_TRACE_SIZE must be a power of 2");
+
+StateTrace::StateTrace()
+{
+    clear();
+}
+
+unsigned char StateTrace::record(unsigned long time, unsigned char state, unsigned char event, unsigned char action, unsigned char output)
+{
+    if (count > 0)
+    {
+        const STATE_TRACE_ENTRY *last = &entries[(head - 1) & (INVERTER_TRACE_SIZE - 1)];
+
+        if (last->state == state && last->event == event && last->output == output)
+        {
+            return 0;
+        }
+    }
+
+    STATE_TRACE_ENTRY *entry = &entries[head];
+
+    entry->time = time;
+    entry->state = state;
+    entry->event = event;
+    entry->action = action;
+    entry->output = output;
+
+    head = (head + 1) & (INVERTER_TRACE_SIZE - 1);
+    if (count < INVERTER_TRACE_SIZE)
+    {
+        count++;
+    }
+    totalCount++;
+
+    return 1;
+}
+
+void StateTrace::clear(void)
+{
+    head = 0;
+    count = 0;
+    totalCount = 0;
+}
+
+const STATE_TRACE_ENTRY *StateTrace::get(unsigned char index)
+{
+    if (index >= count)
+    {
+        return nullptr;
+    }
+
+    return &entries[(head - count + index) & (INVERTER_TRACE_SIZE - 1)];
+}
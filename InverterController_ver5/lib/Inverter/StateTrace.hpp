@@ -0,0 +1,50 @@
+#ifndef _STATE_TRACE_H_
+#define _STATE_TRACE_H_
+
+#include "Inverter_dfs.hpp"
+
+// 記録した状態遷移
+struct STATE_TRACE_ENTRY
+{
+    unsigned long time;   // 記録した時刻[us] (micros())
+    unsigned char state;  // MG-ECU1 の Working Status
+    unsigned char event;  // INVERTER_EVENT_*
+    unsigned char action; // INVERTER_ACTION_*
+    unsigned char output; // アクション実行後の INVERTER_FLAG_*
+};
+
+/**
+ * runInverter の状態遷移の記録 (リングバッファ, 一杯のときは古いものから上書きする)
+ * 毎回の呼び出しを記録するとすぐに埋まるので,
+ * Working Status, イベント, 出力のどれかが直前の記録から変わったときだけ記録する
+ */
+class StateTrace
+{
+private:
+    STATE_TRACE_ENTRY entries[INVERTER_TRACE_SIZE];
+    unsigned char head;         // 次に書き込む位置
+    unsigned char count;        // 記録している数
+    unsigned short totalCount;  // これまでに記録した数(上書きされた分を含む)
+
+public:
+    StateTrace();
+
+    /**
+     * @fn      record
+     *
+     * @brief   直前の記録から変化があれば記録する
+     *
+     * @return  記録した(1), 変化が無い(0)
+     */
+    unsigned char record(unsigned long time, unsigned char state, unsigned char event, unsigned char action, unsigned char output);
+
+    void clear(void);
+
+    inline unsigned char getCount(void) { return count; }
+    inline unsigned short getTotalCount(void) { return totalCount; }
+
+    // index = 0 が最も古い記録, 範囲外の時は nullptr
+    const STATE_TRACE_ENTRY *get(unsigned char index);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "TxQueue.hpp"
+#include <string.h>
+
+static_assert((TX_QUEUE_SIZE & (TX_QUEUE_SIZE - 1)) == 0, "TX_QUEUE_SIZE must be a power of 2");
+
+TxQueue::TxQueue()
+    : head(0), count(0), maxCount(0), dropCount(0), maxLatency(0)
+{
+}
+
+TX_FRAME *TxQueue::find(unsigned long id)
+{
+    for (unsigned char i = 0; i < count; i++)
+    {
+        TX_FRAME *queued = &frames[(head + i) & (TX_QUEUE_SIZE - 1)];
+
+        if (queued->id == id)
+        {
+            return queued;
+        }
+    }
+
+    return nullptr;
+}
+
+unsigned char TxQueue::push(unsigned long id, unsigned char len, const unsigned char *buf, unsigned long time)
+{
+    TX_FRAME *frame = find(id);
+
+    if (frame == nullptr)
+    {
+        if (count >= TX_QUEUE_SIZE)
+        {
+            dropCount++;
+            return 0;
+        }
+
+        frame = &frames[(head + count) & (TX_QUEUE_SIZE - 1)];
+        frame->id = id;
+        frame->time = time;
+        count++;
+
+        if (maxCount < count)
+        {
+            maxCount = count;
+        }
+    }
+
+    frame->len = len > 8 ? 8 : len;
+    memcpy(frame->buf, buf, frame->len);
+
+    return 1;
+}
+
+TX_FRAME *TxQueue::front(void)
+{
+    return count == 0 ? nullptr : &frames[head];
+}
+
+void TxQueue::pop(unsigned long now)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const unsigned long latency = now - frames[head].time;
+    if (maxLatency < latency)
+    {
+        maxLatency = latency;
+    }
+
+    head = (head + 1) & (TX_QUEUE_SIZE - 1);
+    count--;
+}
+
+void TxQueue::clear(void)
+{
+    head = 0;
+    count = 0;
+}
@@ -0,0 +1,76 @@
+#ifndef _TX_QUEUE_H_
+#define _TX_QUEUE_H_
+
+#define TX_QUEUE_SIZE (4) // 2のべき乗にすること
+
+// 送信待ちのCANフレーム
+struct TX_FRAME
+{
+    unsigned long id;
+    unsigned char len;
+    unsigned char buf[8];
+    unsigned long time; // 送信を要求した時刻[us] (micros())
+};
+
+/**
+ * CANコントローラの送信メールボックスが空くまでフレームを待たせるキュー
+ * loop() 側からのみ使う (割り込みからは使わない)
+ *
+ * 同じIDのフレームが既に待っているときは中身だけを新しいものに置き換える
+ * (周期送信のフレームが溜まって古い指令値が後から出ていくのを防ぐ)
+ */
+class TxQueue
+{
+private:
+    TX_FRAME frames[TX_QUEUE_SIZE];
+    unsigned char head;         // 最も古いフレームの位置
+    unsigned char count;        // 待っているフレームの数
+    unsigned char maxCount;     // 待っているフレームの数の最大値
+    unsigned short dropCount;   // キューが一杯で捨てたフレームの数
+    unsigned long maxLatency;   // 送信を要求してからCANコントローラに渡すまでの最大[us]
+
+public:
+    TxQueue();
+
+    /**
+     * @fn      push
+     *
+     * @brief   フレームを送信待ちにする. 同じIDが待っていれば中身を置き換える
+     *
+     * @param   time 送信を要求した時刻[us]
+     *
+     * @return  入れた(1), 一杯で捨てた(0)
+     */
+    unsigned char push(unsigned long id, unsigned char len, const unsigned char *buf, unsigned long time);
+
+    /**
+     * @fn      front
+     *
+     * @brief   最も古いフレームを取得する
+     *
+     * @return  フレームのポインタ, 空の時は nullptr
+     */
+    TX_FRAME *front(void);
+
+    // id のフレームが待っていればそのポインタ, 無ければ nullptr
+    TX_FRAME *find(unsigned long id);
+
+    /**
+     * @fn      pop
+     *
+     * @brief   front で取得したフレームをCANコントローラに渡したので取り除く
+     *
+     * @param   now 渡した時刻[us] (待ち時間の記録に使う)
+     */
+    void pop(unsigned long now);
+
+    // 待っているフレームを全て捨てる (再初期化のとき)
+    void clear(void);
+
+    inline unsigned char getCount(void) { return count; }
+    inline unsigned char getMaxCount(void) { return maxCount; }
+    inline unsigned short getDropCount(void) { return dropCount; }
+    inline unsigned long getMaxLatency(void) { return maxLatency; }
+};
+
+#endif
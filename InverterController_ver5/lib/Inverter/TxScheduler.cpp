@@ -0,0 +1,80 @@
+#include "TxScheduler.hpp"
+
+TxScheduler::TxScheduler(unsigned short period)
+    : period(period), lastTxTime(0), firstFlag(1), minPeriod(0xFFFF), maxPeriod(0), eventCount(0), windowStart(0), windowFrames(0), busLoad(0)
+{
+}
+
+unsigned char TxScheduler::isDue(unsigned long now, unsigned char changed)
+{
+    updateBusLoad(now);
+
+    unsigned long elapsed = now - lastTxTime;
+
+    if (firstFlag)
+    {
+        firstFlag = 0;
+    }
+    else if (elapsed >= period)
+    {
+        // 周期送信の間隔を記録
+        unsigned short p = elapsed > 0xFFFF ? 0xFFFF : (unsigned short)elapsed;
+
+        if (p < minPeriod)
+        {
+            minPeriod = p;
+        }
+
+        if (maxPeriod < p)
+        {
+            maxPeriod = p;
+        }
+    }
+    else if (changed)
+    {
+        // 周期を待たずに送信し, 次の周期送信はここから数える
+        eventCount++;
+    }
+    else
+    {
+        return 0;
+    }
+
+    lastTxTime = now;
+    windowFrames++;
+
+    return 1;
+}
+
+void TxScheduler::updateBusLoad(unsigned long now)
+{
+    unsigned long elapsed = now - windowStart;
+
+    if (elapsed >= BUS_LOAD_WINDOW)
+    {
+        // 負荷率[0.1%] = 送受信したビット数 / (ビットレート x 区間の長さ) x 1000
+        busLoad = (unsigned short)(((unsigned long)windowFrames * CAN_FRAME_BITS * 1000UL) / ((unsigned long)CAN_BITRATE_KBPS * elapsed));
+        windowFrames = 0;
+        windowStart = now;
+    }
+}
+
+unsigned short TxScheduler::getJitter(void)
+{
+    if (maxPeriod == 0)
+    {
+        return 0;
+    }
+
+    unsigned short early = period > minPeriod ? period - minPeriod : 0;
+    unsigned short late = maxPeriod > period ? maxPeriod - period : 0;
+
+    return early > late ? early : late;
+}
+
+void TxScheduler::resetStats(void)
+{
+    minPeriod = 0xFFFF;
+    maxPeriod = 0;
+    eventCount = 0;
+}
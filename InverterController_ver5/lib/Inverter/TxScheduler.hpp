@@ -0,0 +1,67 @@
+#ifndef _TX_SCHEDULER_H_
+#define _TX_SCHEDULER_H_
+
+#define CAN_BITRATE_KBPS (500)      // CANバスのビットレート[kbps]
+#define CAN_FRAME_BITS (125)        // データ長8byteの標準フレーム1つのビット数(スタッフビット込みの目安)
+#define BUS_LOAD_WINDOW (1000)      // バス負荷率を計算する区間[ms]
+
+/**
+ * 周期送信 + 変化時の即時送信を行う送信スケジューラ
+ * 時刻は MsTimer2/AGTimerR4 の 1ms 割り込みで数えた tick を渡す
+ *
+ * 周期送信の間隔の最小/最大(ジッタ)と, 区間ごとのバス負荷率を記録する
+ */
+class TxScheduler
+{
+private:
+    unsigned short period;          // 送信周期[ms]
+    unsigned long lastTxTime;       // 最後に送信した時刻[ms]
+    unsigned char firstFlag;        // まだ一度も送信していない
+
+    unsigned short minPeriod;       // 周期送信の間隔の最小値[ms]
+    unsigned short maxPeriod;       // 周期送信の間隔の最大値[ms]
+    unsigned short eventCount;      // 変化による即時送信の回数
+
+    unsigned long windowStart;      // バス負荷率の計算区間の開始時刻[ms]
+    unsigned short windowFrames;    // 計算区間内に送受信したフレーム数
+    unsigned short busLoad;         // 直前の計算区間のバス負荷率[0.1%]
+
+    void updateBusLoad(unsigned long now);
+
+public:
+    TxScheduler(unsigned short period);
+
+    inline void setPeriod(unsigned short period) { this->period = period; }
+    inline unsigned short getPeriod(void) { return period; }
+
+    /**
+     * @fn      isDue
+     *
+     * @brief   送信するタイミングか判定する
+     *          1 を返したときは送信したものとして統計を更新するので, 必ず送信すること
+     *
+     * @param   now     現在時刻[ms]
+     * @param   changed 即時送信が必要な変化があったか
+     *
+     * @return  送信する(1), しない(0)
+     */
+    unsigned char isDue(unsigned long now, unsigned char changed);
+
+    // 受信したフレーム数をバス負荷率に加える
+    inline void countRxFrames(unsigned char num) { windowFrames += num; }
+
+    inline unsigned short getMinPeriod(void) { return minPeriod; }
+    inline unsigned short getMaxPeriod(void) { return maxPeriod; }
+    inline unsigned short getEventCount(void) { return eventCount; }
+
+    // 周期送信のジッタ(周期からの最大のずれ)[ms]
+    unsigned short getJitter(void);
+
+    // バス負荷率[0.1%]
+    inline unsigned short getBusLoad(void) { return busLoad; }
+
+    // ジッタの統計をリセット
+    void resetStats(void);
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "LoopProfiler.hpp"
+#include <Arduino.h>
+
+#ifdef LOOP_PROFILE
+LoopProfiler loopProfiler;
+#endif
+
+static const char *const STAGE_NAME[STAGE_NUM] = {
+    "CAN RX", "ADC", "Accel", "Inverter", "CAN TX", "GPIO", "Loop"};
+
+LoopProfiler::LoopProfiler()
+    : loopStart(0), stageStart(0)
+{
+    reset();
+}
+
+void LoopProfiler::reset(void)
+{
+    for (int i = 0; i < STAGE_NUM; i++)
+    {
+        stats[i].min = 0xFFFFFFFF;
+        stats[i].max = 0;
+        stats[i].sum = 0;
+        stats[i].count = 0;
+
+        for (int j = 0; j < PROFILE_HIST_BINS; j++)
+        {
+            stats[i].hist[j] = 0;
+        }
+    }
+}
+
+void LoopProfiler::beginLoop(void)
+{
+    loopStart = micros();
+    stageStart = loopStart;
+}
+
+void LoopProfiler::endStage(unsigned char stage)
+{
+    unsigned long now = micros();
+
+    record(stage, now - stageStart);
+    stageStart = now;
+}
+
+void LoopProfiler::endLoop(void)
+{
+    record(STAGE_LOOP, micros() - loopStart);
+}
+
+void LoopProfiler::record(unsigned char stage, unsigned long time)
+{
+    STAGE_STAT *stat = &stats[stage];
+
+    if (time < stat->min)
+    {
+        stat->min = time;
+    }
+
+    if (stat->max < time)
+    {
+        stat->max = time;
+    }
+
+    // sum が溢れる前に sum と count を半分にする (平均は変わらない)
+    if (stat->sum & 0x80000000)
+    {
+        stat->sum >>= 1;
+        stat->count >>= 1;
+    }
+    stat->sum += time;
+    stat->count++;
+
+    // log2 のビン : 最上位ビットの位置
+    unsigned char bin = 0;
+    while (time > 1 && bin < PROFILE_HIST_BINS - 1)
+    {
+        time >>= 1;
+        bin++;
+    }
+
+    if (stat->hist[bin] != 0xFFFF)
+    {
+        stat->hist[bin]++;
+    }
+}
+
+void LoopProfiler::print(void)
+{
+    Serial.println("----------Loop Profile [us]----------");
+
+    for (int i = 0; i < STAGE_NUM; i++)
+    {
+        const STAGE_STAT *stat = &stats[i];
+
+        Serial.print(STAGE_NAME[i]);
+        Serial.print(" : min ");
+        Serial.print(stat->count ? stat->min : 0);
+        Serial.print(" max ");
+        Serial.print(stat->max);
+        Serial.print(" mean ");
+        Serial.print(stat->count ? stat->sum / stat->count : 0);
+        Serial.print(" jitter ");
+        Serial.println(stat->count ? stat->max - stat->min : 0);
+
+        // 2^i us 以上のビンの回数を並べる
+        Serial.print("  hist");
+        for (int j = 0; j < PROFILE_HIST_BINS; j++)
+        {
+            Serial.print(' ');
+            Serial.print(stat->hist[j]);
+        }
+        Serial.println();
+    }
+
+    Serial.println("-------------------------------------");
+    Serial.println();
+}
+
+unsigned char LoopProfiler::command(int c)
+{
+    switch (c)
+    {
+    case PROFILE_CMD_PRINT:
+        print();
+        return 1;
+        break;
+
+    case PROFILE_CMD_RESET:
+        reset();
+        return 1;
+        break;
+
+    default:
+        return 0;
+        break;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef _LOOP_PROFILER_H_
+#define _LOOP_PROFILER_H_
+
+#include "LoopProfiler_dfs.hpp"
+
+// 計測する区間 (loop() 内の順番)
+enum ProfileStage
+{
+    STAGE_CAN_RX,   // CAN受信, MG-ECU1 の周期チェック
+    STAGE_ADC,      // アクセルセンサの analogRead
+    STAGE_ACCEL,    // アクセル開度からトルク計算
+    STAGE_INVERTER, // スイッチ読み取り, runInverter
+    STAGE_CAN_TX,   // CAN送信
+    STAGE_GPIO,     // AIR, LED の digitalWrite
+    STAGE_LOOP,     // loop() 全体
+    STAGE_NUM
+};
+
+struct STAGE_STAT
+{
+    unsigned long min; // [us]
+    unsigned long max; // [us]
+    unsigned long sum; // [us]
+    unsigned long count;
+    unsigned short hist[PROFILE_HIST_BINS]; // hist[i] : 2^i <= 処理時間 < 2^(i+1) [us] の回数 (hist[0] は 0~1 us)
+};
+
+/**
+ * loop() の区間ごとの処理時間を micros() で計測し, 最小/最大/平均と log2 ヒストグラムを溜める
+ * シリアルモニタから PROFILE_CMD_PRINT を送ると loop() を止めずに表示する
+ */
+class LoopProfiler
+{
+private:
+    STAGE_STAT stats[STAGE_NUM];
+    unsigned long loopStart;
+    unsigned long stageStart;
+
+    void record(unsigned char stage, unsigned long time);
+
+public:
+    LoopProfiler();
+
+    // loop() の先頭で呼ぶ
+    void beginLoop(void);
+
+    // 区間の終わりで呼ぶ, 前の区間の終わり(または loop() の先頭)からの時間を stage に加える
+    void endStage(unsigned char stage);
+
+    // loop() の最後で呼ぶ
+    void endLoop(void);
+
+    void reset(void);
+
+    // 全区間の統計をシリアルモニタに表示
+    void print(void);
+
+    /**
+     * シリアルモニタから受信した1文字のコマンドを処理する
+     * 戻り値 : 1(処理した) or 0(このクラスのコマンドではない)
+     */
+    unsigned char command(int c);
+
+    inline const STAGE_STAT *getStat(unsigned char stage) { return stage < STAGE_NUM ? &stats[stage] : nullptr; }
+};
+
+#ifdef LOOP_PROFILE
+extern LoopProfiler loopProfiler;
+
+#define PROFILE_BEGIN() loopProfiler.beginLoop()
+#define PROFILE_STAGE(stage) loopProfiler.endStage(stage)
+#define PROFILE_END() loopProfiler.endLoop()
+#define PROFILE_COMMAND(c) loopProfiler.command(c)
+#else
+#define PROFILE_BEGIN() do {} while (0)
+#define PROFILE_STAGE(stage) do {} while (0)
+#define PROFILE_END() do {} while (0)
+#define PROFILE_COMMAND(c) (0)
+#endif
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _LOOP_PROFILER_DFS_H_
+#define _LOOP_PROFILER_DFS_H_
+
+/**
+ * loop() の処理時間の計測
+ * コメントアウトすると計測処理とRAMが全て消える
+ */
+#define LOOP_PROFILE
+
+#define PROFILE_HIST_BINS (12) // log2 ヒストグラムのビン数 (最後のビンは 2^(PROFILE_HIST_BINS-1) us 以上全て)
+
+// シリアルコマンド
+#define PROFILE_CMD_PRINT ('p') // 統計を表示
+#define PROFILE_CMD_RESET ('r') // 統計をリセット
+
+#endif
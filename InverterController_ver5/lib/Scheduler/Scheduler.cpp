@@ -0,0 +1,207 @@
+#include "Scheduler.hpp"
+#include <Arduino.h>
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+Scheduler::Scheduler()
+    : taskCount(0)
+{
+}
+
+unsigned char Scheduler::addTask(const char *name, TaskFunc func, unsigned short period, unsigned short offset)
+{
+    if (taskCount >= SCHEDULER_TASK_MAX || func == nullptr || period == 0)
+    {
+        return SCHEDULER_NO_TASK;
+    }
+
+    TASK *task = &tasks[taskCount];
+
+    task->name = name;
+    task->func = func;
+    task->period = period;
+    task->countdown = offset + 1;
+    task->pending = 0;
+    task->releaseTime = 0;
+    task->overrunCount = 0;
+    task->execMax = 0;
+    task->execSum = 0;
+    task->runCount = 0;
+    task->latencyMax = 0;
+
+    return taskCount++;
+}
+
+void Scheduler::setPeriod(unsigned char task, unsigned short period)
+{
+    if (task >= taskCount || period == 0)
+    {
+        return;
+    }
+
+    // 割り込み側が読む値なので, 書き換えの途中で割り込まれないようにする
+    noInterrupts();
+    tasks[task].period = period;
+    if (tasks[task].countdown > period)
+    {
+        tasks[task].countdown = period;
+    }
+    interrupts();
+}
+
+void Scheduler::tick(void)
+{
+    for (unsigned char i = 0; i < taskCount; i++)
+    {
+        TASK *task = &tasks[i];
+
+        if (--task->countdown > 0)
+        {
+            continue;
+        }
+        task->countdown = task->period;
+
+        if (task->pending)
+        {
+            task->overrunCount++;
+        }
+        else
+        {
+            task->releaseTime = micros();
+            task->pending = 1;
+        }
+    }
+}
+
+unsigned char Scheduler::run(void)
+{
+    unsigned char count = 0;
+    unsigned char i = 0;
+
+    while (i < taskCount)
+    {
+        TASK *task = &tasks[i];
+
+        if (!task->pending)
+        {
+            i++;
+            continue;
+        }
+
+        // pending の間は割り込み側が releaseTime を書き換えない
+        const unsigned long start = micros();
+        const unsigned long latency = start - task->releaseTime;
+
+        task->func();
+
+        const unsigned long exec = micros() - start;
+
+        // 実行し終わってから次の周期を受け付ける (実行中に来た周期は overrun)
+        task->pending = 0;
+
+        if (task->latencyMax < latency)
+        {
+            task->latencyMax = latency;
+        }
+        if (task->execMax < exec)
+        {
+            task->execMax = exec;
+        }
+        task->execSum += exec;
+        task->runCount++;
+        count++;
+
+        // 優先順位の高いタスクが実行可能になっていれば先に実行する
+        i = 0;
+    }
+
+    return count;
+}
+
+void Scheduler::reset(void)
+{
+    for (unsigned char i = 0; i < taskCount; i++)
+    {
+        TASK *task = &tasks[i];
+
+        task->execMax = 0;
+        task->execSum = 0;
+        task->runCount = 0;
+        task->latencyMax = 0;
+
+        noInterrupts();
+        task->overrunCount = 0;
+        interrupts();
+    }
+}
+
+unsigned short Scheduler::getOverrunCount(unsigned char task)
+{
+    unsigned short count = 0;
+
+    if (task >= taskCount)
+    {
+        return 0;
+    }
+
+    // 割り込みから呼ばれても割り込み許可状態を壊さないように読み出す
+#ifdef __AVR__
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        count = tasks[task].overrunCount;
+    }
+#else
+    count = tasks[task].overrunCount; // 32bitマイコンでは16bitの読み出しは不可分
+#endif
+    return count;
+}
+
+void Scheduler::print(void)
+{
+    Serial.println();
+    Serial.println("----------SCHEDULER [us]----------");
+
+    for (unsigned char i = 0; i < taskCount; i++)
+    {
+        const TASK *task = &tasks[i];
+
+        Serial.print(task->name);
+        Serial.print(" period ");
+        Serial.print(task->period);
+        Serial.print(" ms runs ");
+        Serial.print(task->runCount);
+        Serial.print(" exec max ");
+        Serial.print(task->execMax);
+        Serial.print(" mean ");
+        Serial.print(task->runCount ? task->execSum / task->runCount : 0);
+        Serial.print(" latency max ");
+        Serial.print(task->latencyMax);
+        Serial.print(" overrun ");
+        Serial.println(getOverrunCount(i));
+    }
+
+    Serial.println("----------------------------------");
+    Serial.println();
+}
+
+unsigned char Scheduler::command(int c)
+{
+    switch (c)
+    {
+    case SCHEDULER_CMD_PRINT:
+        print();
+        return 1;
+        break;
+
+    case SCHEDULER_CMD_RESET:
+        reset();
+        return 1;
+        break;
+
+    default:
+        return 0;
+        break;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "Scheduler_dfs.hpp"
+
+typedef void (*TaskFunc)(void);
+
+struct TASK
+{
+    const char *name;
+    TaskFunc func;
+    unsigned short period;             // 実行周期[tick]
+    volatile unsigned short countdown; // 次に実行可能になるまでの tick 数 (割り込み側)
+    volatile unsigned char pending;    // 実行可能になって, まだ実行していない
+    volatile unsigned long releaseTime; // 実行可能になった時刻[us] (割り込み側)
+    volatile unsigned short overrunCount; // 前回の分を実行し終わる前に次の周期が来た回数
+
+    unsigned long execMax;    // 実行時間の最大[us]
+    unsigned long execSum;    // 実行時間の合計[us]
+    unsigned long runCount;   // 実行した回数
+    unsigned long latencyMax; // 実行可能になってから実行を始めるまでの最大[us]
+};
+
+/**
+ * 1つのタイマ割り込み (MEGA : MsTimer2 (Timer2), R4 : AGTimerR4) の tick から
+ * 周期の異なる複数のタスクを実行する協調型スケジューラ
+ *
+ * tick() は割り込みから呼び, 周期が来たタスクに印を付けるだけ
+ * タスクは loop() から呼ぶ run() の中で実行する (割り込みの中では実行しない)
+ * 登録した順が優先順位で, 1つ実行するたびに先頭から探し直す
+ * 実行中に次の周期が来た(前回の分が終わっていない)ときは overrun として数え, その周期は飛ばす
+ */
+class Scheduler
+{
+private:
+    TASK tasks[SCHEDULER_TASK_MAX];
+    unsigned char taskCount;
+
+public:
+    Scheduler();
+
+    /**
+     * @fn      addTask
+     *
+     * @brief   タスクを登録する. setup() で割り込みを開始する前に呼ぶこと
+     *
+     * @param   name   表示用の名前
+     * @param   func   実行する関数
+     * @param   period 実行周期[tick]
+     * @param   offset 最初に実行可能になるまでの tick 数 (同じ tick に重ならないようにずらす)
+     *
+     * @return  タスクの番号, 登録できなかったときは SCHEDULER_NO_TASK
+     */
+    unsigned char addTask(const char *name, TaskFunc func, unsigned short period, unsigned short offset = 0);
+
+    // 実行周期[tick]を変更する (次の周期から)
+    void setPeriod(unsigned char task, unsigned short period);
+
+    // タイマ割り込みから 1 tick ごとに呼ぶ
+    void tick(void);
+
+    /**
+     * @fn      run
+     *
+     * @brief   実行可能なタスクを優先順位の順に全て実行する (loop() から呼ぶ)
+     *
+     * @return  実行したタスクの数
+     */
+    unsigned char run(void);
+
+    void reset(void);
+
+    // タスクごとの統計をシリアルモニタに表示
+    void print(void);
+
+    /**
+     * シリアルモニタから受信した1文字のコマンドを処理する
+     * 戻り値 : 1(処理した) or 0(このクラスのコマンドではない)
+     */
+    unsigned char command(int c);
+
+    unsigned short getOverrunCount(unsigned char task);
+    inline unsigned long getExecMax(unsigned char task) { return task < taskCount ? tasks[task].execMax : 0; }
+    inline unsigned long getLatencyMax(unsigned char task) { return task < taskCount ? tasks[task].latencyMax : 0; }
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _SCHEDULER_DFS_H_
+#define _SCHEDULER_DFS_H_
+
+#define SCHEDULER_TASK_MAX (8)     // 登録できるタスクの数
+#define SCHEDULER_NO_TASK (0xFF)   // addTask が失敗したときの戻り値
+
+// シリアルコマンド
+#define SCHEDULER_CMD_PRINT ('s') // タスクごとの統計を表示
+#define SCHEDULER_CMD_RESET ('z') // 統計をリセット
+
+// InverterController のタスクの周期[ms] (テレメトリは Telemetry::getPeriod())
+#define TASK_CAN_PERIOD (1)     // CAN初期化, 受信, 受信周期の監視
+#define TASK_CONTROL_PERIOD (1) // スイッチ, runInverter, CAN送信, AIR/LED
+#define TASK_PEDAL_PERIOD (5)   // アクセルセンサの読み取り, トルク計算
+
+#endif
@@ -4,6 +4,8 @@
 /**
  * チャタリング対策入れた Switchクラス
  * INPUTはプルダウン
+ * main.cpp は Debouncer で全てのスイッチをまとめて判定する
+ * このクラスは Debouncer と結果を比べるために残している (InverterHost env:debounce)
 */
 class Switch
 {
@@ -0,0 +1,412 @@
+#include "Telemetry.hpp"
+#include <Arduino.h>
+#include "EV_ECU1.hpp"
+#include "MG_ECU1.hpp"
+#include "MG_ECU2.hpp"
+#include "Inverter_dfs.hpp"
+#include "Accel_dfs.hpp"
+
+// コンパイラによるメモリアクセスの並べ替えを防ぐ
+#define MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// テキストの行 (printTextLine の case と対応)
+enum TextLine
+{
+    LINE_TICK,
+    LINE_AIR,
+    LINE_TORQUE_CONTROL,
+    LINE_SHUTDOWN,
+    LINE_DRIVE,
+    LINE_ACCEL1,
+    LINE_ACCEL2,
+    LINE_DEVIATION,
+    LINE_TORQUE,
+    LINE_MGECU1_PERIOD,
+    LINE_RX_MAX,
+    LINE_RX_OVERFLOW,
+    LINE_CTRL_OVERFLOW,
+    LINE_RX_REJECTED,
+    LINE_TX_MAX_PERIOD,
+    LINE_TX_JITTER,
+    LINE_TX_EVENT,
+    LINE_BUS_LOAD,
+    LINE_DROP,
+    LINE_CAN_READY,
+    LINE_CAN_REINIT,
+    LINE_CAN_BUS_OFF,
+    LINE_CAN_INIT_FAIL,
+    LINE_CAN_INIT_MAX,
+    LINE_MGECU1_TIMEOUT,
+    LINE_MGECU2_TIMEOUT,
+    LINE_ECU_ENABLE,
+    LINE_DISCHARGE,
+    LINE_REQUEST_TORQUE,
+    LINE_WORKING_STATUS,
+    LINE_MOTOR_SPEED,
+    LINE_PHASE_CURRENT,
+    LINE_DC_VOLTAGE,
+    LINE_FAILURE_STATUS,
+    LINE_INVERTER_TEMP,
+    LINE_MAX_MOTOR_TORQUE,
+    LINE_MAX_GENERATE_TORQUE,
+    LINE_MOTOR_TEMP,
+    LINE_END,
+    LINE_NUM
+};
+
+Telemetry::Telemetry()
+    : head(0), tail(0), dropCount(0), mode(TELEMETRY_DEFAULT_MODE), nextMode(TELEMETRY_DEFAULT_MODE),
+      busy(0), frameLen(0), framePos(0), seq(0), textLine(0)
+{
+}
+
+TELEMETRY_STATUS *Telemetry::reserve(void)
+{
+    if ((unsigned char)(head - tail) >= TELEMETRY_QUEUE_SIZE)
+    {
+        dropCount++;
+        return nullptr;
+    }
+
+    return &queue[head & (TELEMETRY_QUEUE_SIZE - 1)];
+}
+
+void Telemetry::commit(void)
+{
+    // サンプルを書き終えてから head を進める
+    MEMORY_BARRIER();
+    head++;
+}
+
+unsigned char Telemetry::command(int c)
+{
+    switch (c)
+    {
+    case TELEMETRY_CMD_BINARY:
+        nextMode = TELEMETRY_MODE_BINARY;
+        return 1;
+        break;
+
+    case TELEMETRY_CMD_TEXT:
+        nextMode = TELEMETRY_MODE_TEXT;
+        return 1;
+        break;
+
+    default:
+        return 0;
+        break;
+    }
+}
+
+void Telemetry::service(void)
+{
+    if (!busy)
+    {
+        // 形式の切り替えはサンプルの区切りで行う
+        mode = nextMode;
+
+        if (head == tail)
+        {
+            return;
+        }
+
+        // head を読んでからサンプルを読む
+        MEMORY_BARRIER();
+        current = queue[tail & (TELEMETRY_QUEUE_SIZE - 1)];
+
+        // 読み終えてから tail を進める
+        MEMORY_BARRIER();
+        tail++;
+
+        if (mode == TELEMETRY_MODE_BINARY)
+        {
+            frameLen = encodeTelemetryFrame(TELEMETRY_TYPE_STATUS, seq++, &current, sizeof(TELEMETRY_STATUS), frame);
+            framePos = 0;
+        }
+        else
+        {
+            textLine = 0;
+        }
+        busy = 1;
+    }
+
+    busy = mode == TELEMETRY_MODE_BINARY ? sendFrame() : sendText();
+}
+
+unsigned char Telemetry::sendFrame(void)
+{
+    int space = Serial.availableForWrite();
+
+    if (space > 0)
+    {
+        unsigned char len = frameLen - framePos;
+        if (len > space)
+        {
+            len = space;
+        }
+
+        Serial.write(frame + framePos, len);
+        framePos += len;
+    }
+
+    return framePos < frameLen;
+}
+
+unsigned char Telemetry::sendText(void)
+{
+    // 1行が送信バッファに収まるときだけ書くので Serial.print でもブロックしない
+    while (textLine < LINE_NUM && Serial.availableForWrite() >= TELEMETRY_TEXT_LINE_MAX)
+    {
+        printTextLine(textLine++);
+    }
+
+    return textLine < LINE_NUM;
+}
+
+void Telemetry::printTextLine(unsigned char line)
+{
+    switch (line)
+    {
+    case LINE_TICK:
+        Serial.print("tick : ");
+        Serial.println(current.tick);
+        break;
+
+    case LINE_AIR:
+        Serial.print("airFlag : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_AIR) ? 1 : 0);
+        break;
+
+    case LINE_TORQUE_CONTROL:
+        Serial.print("torqueControlFlag : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_TORQUE_CONTROL) ? 1 : 0);
+        break;
+
+    case LINE_SHUTDOWN:
+        Serial.print("shutdownFlag : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_SHUTDOWN) ? 1 : 0);
+        break;
+
+    case LINE_DRIVE:
+        Serial.print("driveFlag : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_DRIVE) ? 1 : 0);
+        break;
+
+    case LINE_ACCEL1:
+        Serial.print("Accel1 : ");
+        Serial.println(current.accel[0]);
+        break;
+
+    case LINE_ACCEL2:
+        Serial.print("Accel2 : ");
+        Serial.println(current.accel[1]);
+        break;
+
+    case LINE_DEVIATION:
+        Serial.print("Deviation : ");
+        Serial.println(current.accelDevCount * (100 * ADC_VOLTAGE_RESOLUTION / AMOUNT_OF_MOVEMENT));
+        break;
+
+    case LINE_TORQUE:
+        Serial.print("Torque : ");
+        Serial.println(current.torque * (1.0f / FIXED_TORQUE_RESOLUTION));
+        break;
+
+    case LINE_MGECU1_PERIOD:
+        Serial.print("MGECU1 MSG Period [us] : ");
+        Serial.println(current.mgecu1Period);
+        break;
+
+    case LINE_RX_MAX:
+        Serial.print("CAN RX Max Buffered : ");
+        Serial.println(current.rxMaxCount);
+        break;
+
+    case LINE_RX_OVERFLOW:
+        Serial.print("CAN RX Overflow : ");
+        Serial.println(current.rxOverflow);
+        break;
+
+    case LINE_CTRL_OVERFLOW:
+        Serial.print("CAN Controller Overflow : ");
+        Serial.println(current.ctrlOverflow);
+        break;
+
+    case LINE_RX_REJECTED:
+        Serial.print("CAN RX Rejected : ");
+        Serial.println(current.rxRejected);
+        break;
+
+    case LINE_TX_MAX_PERIOD:
+        Serial.print("CAN TX Period max : ");
+        Serial.println(current.txMaxPeriod);
+        break;
+
+    case LINE_TX_JITTER:
+        Serial.print("CAN TX Jitter : ");
+        Serial.println(current.txJitter);
+        break;
+
+    case LINE_TX_EVENT:
+        Serial.print("CAN TX Event : ");
+        Serial.println(current.txEvent);
+        break;
+
+    case LINE_BUS_LOAD:
+        Serial.print("CAN Bus Load [0.1%] : ");
+        Serial.println(current.busLoad);
+        break;
+
+    case LINE_DROP:
+        Serial.print("Telemetry Dropped : ");
+        Serial.println(current.dropCount);
+        break;
+
+    case LINE_CAN_READY:
+        Serial.print("CAN Ready : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_CAN_READY) ? 1 : 0);
+        break;
+
+    case LINE_CAN_REINIT:
+        Serial.print("CAN Reinit : ");
+        Serial.println(current.canReinit);
+        break;
+
+    case LINE_CAN_BUS_OFF:
+        Serial.print("CAN Bus Off : ");
+        Serial.println(current.canBusOff);
+        break;
+
+    case LINE_CAN_INIT_FAIL:
+        Serial.print("CAN Init Fail : ");
+        Serial.println(current.canInitFail);
+        break;
+
+    case LINE_CAN_INIT_MAX:
+        Serial.print("CAN Init max [ms] : ");
+        Serial.println(current.canInitMax);
+        break;
+
+    case LINE_MGECU1_TIMEOUT:
+        Serial.print("MGECU1 Timeout : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_MGECU1_TIMEOUT) ? 1 : 0);
+        break;
+
+    case LINE_MGECU2_TIMEOUT:
+        Serial.print("MGECU2 Timeout : ");
+        Serial.println((current.flags & TELEMETRY_FLAG_MGECU2_TIMEOUT) ? 1 : 0);
+        break;
+
+    case LINE_ECU_ENABLE:
+        Serial.println(EV_ECU1::EcuEnable::get(current.evecu1) ? "MG-ECU Enable" : "MG-ECU Disable");
+        break;
+
+    case LINE_DISCHARGE:
+        Serial.println(EV_ECU1::DischargeCommand::get(current.evecu1) ? "Rapid Discharge Command Active" : "Rapid Discharge Command Inactive");
+        break;
+
+    case LINE_REQUEST_TORQUE:
+        Serial.print("Torque Request ");
+        Serial.println(EV_ECU1::RequestTorque::getPhysical(current.evecu1));
+        break;
+
+    case LINE_WORKING_STATUS:
+        Serial.print("Working Status ");
+        switch (MG_ECU1::WorkingStatus::get(current.mgecu1))
+        {
+        case WORKING_INIT:
+            Serial.println("init");
+            break;
+
+        case WORKING_PRECHARGE:
+            Serial.println("precharge");
+            break;
+
+        case WORKING_STANDBY:
+            Serial.println("standby");
+            break;
+
+        case WORKING_TORQUE_CONTROL:
+            Serial.println("torque control");
+            break;
+
+        case WORKING_RAPID_DISCHARGE:
+            Serial.println("rapid discharge");
+            break;
+
+        default:
+            Serial.println("error");
+            break;
+        }
+        break;
+
+    case LINE_MOTOR_SPEED:
+        Serial.print("Motor Speed ");
+        Serial.println(MG_ECU1::MotorSpeed::getPhysical(current.mgecu1));
+        break;
+
+    case LINE_PHASE_CURRENT:
+        Serial.print("Motor Phase Current ");
+        Serial.println(MG_ECU1::MotorPhaseCurrent::getPhysical(current.mgecu1));
+        break;
+
+    case LINE_DC_VOLTAGE:
+        Serial.print("Input DC Voltage ");
+        Serial.println(MG_ECU1::InputDCVoltage::get(current.mgecu1));
+        break;
+
+    case LINE_FAILURE_STATUS:
+        Serial.print("Failure Status ");
+        switch (MG_ECU1::FailureStatus::get(current.mgecu1))
+        {
+        case FAILURE_NO_ERROR:
+            Serial.println("No Error");
+            break;
+
+        case FAILURE_DERATING:
+            Serial.println("Derating");
+            break;
+
+        case FAILURE_WARNING:
+            Serial.println("Warning");
+            break;
+
+        case FAILURE_ERROR:
+            Serial.println("Error");
+            break;
+
+        case FAILURE_CRITICAL_ERROR:
+            Serial.println("Critical Error");
+            break;
+
+        default:
+            Serial.println("error");
+            break;
+        }
+        break;
+
+    case LINE_INVERTER_TEMP:
+        Serial.print("Inverter Temperature ");
+        Serial.println(MG_ECU2::InverterTemp::getPhysical(current.mgecu2));
+        break;
+
+    case LINE_MAX_MOTOR_TORQUE:
+        Serial.print("Maximum Available Motoring Torque ");
+        Serial.println(MG_ECU2::MaxAvailableMotorTorque::getPhysical(current.mgecu2));
+        break;
+
+    case LINE_MAX_GENERATE_TORQUE:
+        Serial.print("Maximum Available Generating Torque ");
+        Serial.println(MG_ECU2::MaxAvailableGenerateTorque::getPhysical(current.mgecu2));
+        break;
+
+    case LINE_MOTOR_TEMP:
+        Serial.print("Motor Temperature ");
+        Serial.println(MG_ECU2::MotorTemp::getPhysical(current.mgecu2));
+        break;
+
+    default:
+        Serial.println();
+        break;
+    }
+}
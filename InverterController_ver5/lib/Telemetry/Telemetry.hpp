@@ -0,0 +1,122 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include "TelemetryFrame.hpp"
+#include "Telemetry_dfs.hpp"
+
+#define TELEMETRY_QUEUE_SIZE (4) // 2のべき乗にすること
+
+// フレームの種類
+#define TELEMETRY_TYPE_STATUS (0x01)
+
+// TELEMETRY_STATUS::flags のビット
+#define TELEMETRY_FLAG_AIR (0x01)
+#define TELEMETRY_FLAG_TORQUE_CONTROL (0x02)
+#define TELEMETRY_FLAG_SHUTDOWN (0x04)
+#define TELEMETRY_FLAG_DRIVE (0x08)
+#define TELEMETRY_FLAG_CAN_READY (0x10) // CANコントローラが送受信可能 (CAN_STATE_READY)
+#define TELEMETRY_FLAG_MGECU1_TIMEOUT (0x20)
+#define TELEMETRY_FLAG_MGECU2_TIMEOUT (0x40)
+
+/**
+ * 周期的に送る制御状態 (リトルエンディアン, 詰めて配置)
+ * ECUのMassageは生のまま送り, ホスト側でECUクラスを使って物理値に変換する
+ */
+struct __attribute__((packed)) TELEMETRY_STATUS
+{
+    unsigned long tick;             // [ms]
+    unsigned char flags;            // TELEMETRY_FLAG_*
+    unsigned short accel[2];        // アクセルセンサ値 (AdcScan で間引いた値, 0~ACCEL_VALUE_MAX)
+    unsigned short accelDevCount;   // センサ値の差 (Accel_dfs.hpp の定数で[%]に変換)
+    short torque;                   // トルク指令[1/FIXED_TORQUE_RESOLUTION Nm]
+    unsigned short mgecu1Period;    // MG-ECU1 の直前の受信間隔[us] (65535 で止める)
+    unsigned char rxMaxCount;       // 受信バッファに溜まったフレーム数の最大値
+    unsigned short rxOverflow;      // 受信バッファが一杯で捨てたフレーム数
+    unsigned short ctrlOverflow;    // CANコントローラのオーバーフロー回数
+    unsigned short rxRejected;      // 登録されていないID, DLCが足りないフレームの数
+    unsigned short txMaxPeriod;     // 周期送信の間隔の最大値[ms]
+    unsigned short txJitter;        // 周期送信のジッタ[ms]
+    unsigned short txEvent;         // 変化による即時送信の回数
+    unsigned short busLoad;         // バス負荷率[0.1%]
+    unsigned short dropCount;       // テレメトリのキューが一杯で捨てたサンプル数
+    unsigned char canReinit;        // CANコントローラを再初期化した回数 (255 で止める)
+    unsigned char canBusOff;        // そのうちバスオフからの回数 (255 で止める)
+    unsigned char canInitFail;      // CANコントローラの初期化に失敗した回数 (255 で止める)
+    unsigned char canInitMax;       // CANコントローラの初期化にかかった時間の最大値[ms] (切り上げ, 255 で止める)
+    unsigned char evecu1[8];        // EV-ECU1 のMassage
+    unsigned char mgecu1[8];        // MG-ECU1 のMassage
+    unsigned char mgecu2[8];        // MG-ECU2 のMassage
+};
+
+static_assert(sizeof(TELEMETRY_STATUS) <= TELEMETRY_PAYLOAD_MAX, "telemetry payload is too large");
+
+/**
+ * 周期的に取った制御状態を loop() でバイナリのフレームまたはテキストにして送信する
+ *
+ * 割り込み側 : reserve() で取ったサンプルに値を書き, commit() する (Serial には触らない)
+ *              (Scheduler のタスクから呼んでもよい. 書き込み側は1か所だけにすること)
+ * loop() 側  : service() を毎回呼ぶ. Serial の送信バッファの空きの分だけ書くのでブロックしない
+ *
+ * テキストは timerCallback と Inverter::checkMsg が表示していたものと同じラベルで1行ずつ書く
+ */
+class Telemetry
+{
+private:
+    TELEMETRY_STATUS queue[TELEMETRY_QUEUE_SIZE];
+    volatile unsigned char head;        // 次に書き込む位置 (割り込み側)
+    volatile unsigned char tail;        // 次に読み出す位置 (loop側)
+    volatile unsigned short dropCount;
+
+    volatile unsigned char mode;        // 送信中のサンプルの形式
+    unsigned char nextMode;             // コマンドで指定された形式 (次のサンプルから切り替える)
+
+    TELEMETRY_STATUS current;           // 送信中のサンプル
+    unsigned char busy;
+
+    unsigned char frame[TELEMETRY_FRAME_MAX]; // 送信中のフレーム
+    unsigned char frameLen;
+    unsigned char framePos;
+    unsigned char seq;
+
+    unsigned char textLine;             // 次に書くテキストの行
+
+    unsigned char sendFrame(void);
+    unsigned char sendText(void);
+    void printTextLine(unsigned char line);
+
+public:
+    Telemetry();
+
+    /**
+     * サンプルを取る周期[ms] (形式によって変わる)
+     * command の直後に呼んで周期を変えられるように, 送信中の形式ではなくコマンドで指定された形式で決める
+     */
+    inline unsigned short getPeriod(void) { return nextMode == TELEMETRY_MODE_TEXT ? TELEMETRY_TEXT_PERIOD : TELEMETRY_BINARY_PERIOD; }
+
+    inline unsigned char getMode(void) { return mode; }
+
+    /**
+     * シリアルモニタから受信した1文字のコマンドを処理する
+     * 戻り値 : 1(処理した) or 0(このクラスのコマンドではない)
+     */
+    unsigned char command(int c);
+
+    /**
+     * @fn      reserve
+     *
+     * @brief   書き込み先のサンプルを確保する(割り込み側)
+     *
+     * @return  サンプルのポインタ, キューが一杯のときは nullptr (dropCount を加算)
+     */
+    TELEMETRY_STATUS *reserve(void);
+
+    // reserve で確保したサンプルを確定する(割り込み側)
+    void commit(void);
+
+    // キューのサンプルをフレームにして, 送信できる分だけ Serial に書く(loop側)
+    void service(void);
+
+    inline unsigned short getDropCount(void) { return dropCount; }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "TelemetryFrame.hpp"
+#include <string.h>
+
+unsigned short calcCRC16(const unsigned char *buf, unsigned char len)
+{
+    unsigned short crc = 0xFFFF;
+
+    for (int i = 0; i < len; i++)
+    {
+        crc ^= (unsigned short)buf[i] << 8;
+
+        for (int j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+unsigned char encodeTelemetryFrame(unsigned char type, unsigned char seq, const void *payload, unsigned char len, unsigned char *out)
+{
+    unsigned char raw[TELEMETRY_RAW_MAX];
+
+    if (len > TELEMETRY_PAYLOAD_MAX)
+    {
+        return 0;
+    }
+
+    raw[0] = type;
+    raw[1] = seq;
+    memcpy(raw + 2, payload, len);
+
+    unsigned short crc = calcCRC16(raw, len + 2);
+    raw[len + 2] = crc & 0xFF;
+    raw[len + 3] = crc >> 8;
+
+    // COBS : 0x00 を次の 0x00 までの距離に置き換える (254 byte 以下なので分割は不要)
+    unsigned char rawLen = len + 4;
+    unsigned char codeIndex = 1;
+    unsigned char outLen = 2;
+    unsigned char code = 1;
+
+    out[0] = TELEMETRY_DELIMITER;
+
+    for (int i = 0; i < rawLen; i++)
+    {
+        if (raw[i] == 0)
+        {
+            out[codeIndex] = code;
+            codeIndex = outLen++;
+            code = 1;
+        }
+        else
+        {
+            out[outLen++] = raw[i];
+            code++;
+        }
+    }
+    out[codeIndex] = code;
+    out[outLen++] = TELEMETRY_DELIMITER;
+
+    return outLen;
+}
+
+int decodeTelemetryFrame(const unsigned char *in, unsigned char len, unsigned char *raw)
+{
+    unsigned char rawLen = 0;
+    unsigned char i = 0;
+
+    while (i < len)
+    {
+        unsigned char code = in[i++];
+
+        if (code == 0 || i + code - 1 > len)
+        {
+            return -1;
+        }
+
+        for (int j = 1; j < code; j++)
+        {
+            if (rawLen >= TELEMETRY_RAW_MAX)
+            {
+                return -1;
+            }
+            raw[rawLen++] = in[i++];
+        }
+
+        // 最後のブロック以外は後ろに 0x00 があった
+        if (i < len)
+        {
+            if (rawLen >= TELEMETRY_RAW_MAX)
+            {
+                return -1;
+            }
+            raw[rawLen++] = 0;
+        }
+    }
+
+    if (rawLen < 4)
+    {
+        return -1;
+    }
+
+    unsigned short crc = raw[rawLen - 2] | (unsigned short)raw[rawLen - 1] << 8;
+
+    if (crc != calcCRC16(raw, rawLen - 2))
+    {
+        return -1;
+    }
+
+    return rawLen - 4;
+}
@@ -0,0 +1,45 @@
+#ifndef _TELEMETRY_FRAME_H_
+#define _TELEMETRY_FRAME_H_
+
+/**
+ * テレメトリのフレーム形式 (ファームウェアとホストのデコーダで共通)
+ *
+ *  0x00 | COBS( type(1) | seq(1) | payload(n) | CRC-16(2) ) | 0x00
+ *
+ * CRC-16 は CRC-16/CCITT-FALSE (多項式 0x1021, 初期値 0xFFFF), type から payload までを計算し下位バイトから並べる
+ * COBS でフレーム中に 0x00 が出なくなるので, 0x00 を区切りにして途中から受信しても同期できる
+ * 先頭にも区切りを置くので, 直前にテキストが出力されていても次のフレームは壊れない
+ */
+
+#define TELEMETRY_PAYLOAD_MAX (64)
+#define TELEMETRY_RAW_MAX (TELEMETRY_PAYLOAD_MAX + 4)      // type, seq, CRC を含む長さ
+#define TELEMETRY_FRAME_MAX (TELEMETRY_RAW_MAX + 3)        // COBS のオーバーヘッド(1) + 区切り(2)
+#define TELEMETRY_DELIMITER (0x00)
+
+unsigned short calcCRC16(const unsigned char *buf, unsigned char len);
+
+/**
+ * @fn      encodeTelemetryFrame
+ *
+ * @brief   payload をフレームにする (前後の区切りの 0x00 を含む)
+ *
+ * @param   out 出力先 (TELEMETRY_FRAME_MAX byte 以上)
+ *
+ * @return  フレームの長さ, payload が長すぎるときは 0
+ */
+unsigned char encodeTelemetryFrame(unsigned char type, unsigned char seq, const void *payload, unsigned char len, unsigned char *out);
+
+/**
+ * @fn      decodeTelemetryFrame
+ *
+ * @brief   区切りの 0x00 を除いたフレームを復元し CRC を確認する
+ *
+ * @param   in      受信したフレーム (区切りを含まない)
+ * @param   len     in の長さ
+ * @param   raw     復元先 (TELEMETRY_RAW_MAX byte 以上), raw[0] = type, raw[1] = seq, raw + 2 = payload
+ *
+ * @return  payload の長さ, COBS または CRC が不正なときは -1
+ */
+int decodeTelemetryFrame(const unsigned char *in, unsigned char len, unsigned char *raw);
+
+#endif
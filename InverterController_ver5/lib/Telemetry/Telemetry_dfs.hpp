@@ -0,0 +1,21 @@
+#ifndef _TELEMETRY_DFS_H_
+#define _TELEMETRY_DFS_H_
+
+// 出力形式
+#define TELEMETRY_MODE_BINARY (0) // COBS + CRC のフレーム (InverterHost env:decoder で表示)
+#define TELEMETRY_MODE_TEXT (1)   // ラベル付きのテキスト (シリアルモニタでそのまま読める)
+
+#define TELEMETRY_DEFAULT_MODE (TELEMETRY_MODE_BINARY)
+
+// サンプルを取る周期[ms]
+#define TELEMETRY_BINARY_PERIOD (10)
+#define TELEMETRY_TEXT_PERIOD (500)
+
+// テキストの1行の最大文字数(改行を含む), 送信バッファにこれだけ空きがあるときだけ1行書く
+#define TELEMETRY_TEXT_LINE_MAX (48)
+
+// シリアルコマンド
+#define TELEMETRY_CMD_BINARY ('b') // バイナリに切り替え
+#define TELEMETRY_CMD_TEXT ('t')   // テキストに切り替え
+
+#endif
@@ -1,17 +1,42 @@
 #include <Arduino.h>
 #include "Inverter.hpp"
 #include "Accel.hpp"
-#include "Switch.hpp"
+#include "Debouncer.hpp"
+#include "InputPins.hpp"
 #include "IO_dfs.hpp"
+#include "LoopProfiler.hpp"
+#include "Telemetry.hpp"
+#include "Scheduler.hpp"
+#include "Probe.hpp"
+#include "AdcScan.hpp"
 
 /**
  * CHECK LIST
  * > Argument of runInverter()
  * > Accel_dfs.hpp
  *  - MAXIMUM_TORQUE
+ * > TorqueMap_dfs.hpp
+ *  - TORQUE_MAP_*_POINTS (ペダル→トルクの折れ線), TORQUE_MAP_DEFAULT (起動時のマップ, accel->setTorqueMap() で切り替え)
  * > What MCU is used
  *  > Inverter_dfs.hpp
  *      - #define ARDUINO_UNO_R4 or #define ARDUINO_MEGA
+ * > LoopProfiler_dfs.hpp
+ *  - #define LOOP_PROFILE (loop() の処理時間計測, 'p' で表示 'r' でリセット)
+ * > Telemetry_dfs.hpp
+ *  - TELEMETRY_DEFAULT_MODE ('t' でテキスト, 'b' でバイナリに切り替え)
+ * > Inverter_dfs.hpp
+ *  - INVERTER_CMD_TRACE ('i' で runInverter の状態遷移の記録を表示)
+ *  - INVERTER_CMD_CAN ('c' でCANの送受信の統計を表示, R4 は送信待ちの最大と待ち時間も)
+ * > Scheduler_dfs.hpp
+ *  - TASK_*_PERIOD (タスクの周期, 's' でタスクごとの実行時間と overrun を表示 'z' でリセット)
+ * > Probe_dfs.hpp
+ *  - #define PROBE_ENABLE (PROBE_SCOPE の区間の処理時間を Timer4/DWT で計測, 'q' で表示 'w' でリセット)
+ * > Debouncer_dfs.hpp
+ *  - DEBOUNCE_SAMPLES (スイッチを ON とみなすまでに続けて読む回数)
+ * > AdcScan_dfs.hpp
+ *  - ADC_SCAN_AVR_PRESCALER (アクセル/ブレーキセンサを ADC 割り込みで変換する速さ)
+ * > AdcFilter_dfs.hpp
+ *  - ADC_FILTER_EXTRA_BITS, ADC_FILTER_IIR_SHIFT (センサ値の間引きとフィルタ, Accel のセンサ値の範囲が変わる)
 */
 
 #ifdef ARDUINO_UNO_R4
@@ -23,9 +48,19 @@
 Inverter *inverter = new Inverter();
 Accel *accel = new Accel();
 int val[2] = {0, 0};
+int brake = 0;
 float torque = 0;
-Switch *driveSW = new Switch();
-Switch *shutdownDetect = new Switch();
+short fixedTorque = 0; // [1/FIXED_TORQUE_RESOLUTION Nm]
+
+/**
+ * Switches are read at once by InputPins (one bit per switch)
+ * and debounced together by Debouncer (same judgement as the previous Switch class).
+ * To add a switch, call inputPins.add() in setup() and keep the returned bit as a mask.
+ */
+InputPins inputPins;
+Debouncer<unsigned short> switches;
+unsigned short shutdownDetect = 0;  // bit of SHUTDOWN_DETECT
+unsigned short driveSW = 0;         // bit of READY_TO_DRIVE_SW
 
 /**
  * flags[0] = airFlag
@@ -39,24 +74,58 @@ unsigned char setupFlag = 0;
 unsigned char airFlag = 0;
 unsigned char torqueControlFlag = 0;
 
-unsigned long deltaTime = 0;
-unsigned long lastTime = 0;
-unsigned long nowTime = 0;
-
 unsigned short accVol = 370;
 
-float deviation = 100;
-
 unsigned char CANErrorCount = 0;
 
+/**
+ * Time base counted by MsTimer2/AGTimerR4 every 1 ms.
+ * Status is sent as telemetry every TELEMETRY_BINARY_PERIOD / TELEMETRY_TEXT_PERIOD ms.
+ * Binary frames are decoded on the PC with InverterHost (env:decoder).
+ * Send 't' for labelled text and 'b' for binary (Telemetry_dfs.hpp).
+ */
+volatile unsigned long tick = 0;
+Telemetry telemetry;
+
+/**
+ * Tasks are released by the 1 ms timer tick and run from loop() in priority order
+ * (the order of addTask in setup()).
+ * Task periods are configured in "Scheduler_dfs.hpp".
+ */
+Scheduler scheduler;
+unsigned char telemetryTask = SCHEDULER_NO_TASK;
+
+/**
+ * Accel pedal sensors and brake sensor are converted one after another
+ * in the ADC complete interrupt (AdcScan), so taskPedal() does not wait for analogRead.
+ * The values read at once always come from the same scan.
+ */
+unsigned char accelChannel[2] = {ADC_SCAN_NO_CHANNEL, ADC_SCAN_NO_CHANNEL};
+unsigned char brakeChannel = ADC_SCAN_NO_CHANNEL;
+
 void timerCallback(void);
 
+unsigned long getTick(void);
+
+void taskCan(void);
+void taskPedal(void);
+void taskControl(void);
+void taskTelemetry(void);
+
 void setup()
 {
+    PROBE_BEGIN();
+
     inverter->init();
 
     pinMode(ACCEL_SENSOR1, INPUT);
     pinMode(ACCEL_SENSOR2, INPUT);
+    pinMode(BRAKE_SENSOR, INPUT);
+
+    accelChannel[0] = ADCScan.addChannel(ACCEL_SENSOR1);
+    accelChannel[1] = ADCScan.addChannel(ACCEL_SENSOR2);
+    brakeChannel = ADCScan.addChannel(BRAKE_SENSOR);
+    ADCScan.begin();
 
     pinMode(READY_TO_DRIVE_SW, INPUT);
     pinMode(READY_TO_DRIVE_LED, OUTPUT);
@@ -69,90 +138,173 @@ void setup()
 
     pinMode(SHUTDOWN_DETECT, INPUT);
 
+    /**
+     * SHUTDOWN_DETECT Port is pulldown.
+     * When Shutdown Circuit is OPEN, digitalRead(SHUTDOWN_DETECT) will return 0, so it is inverted.
+     * READY_TO_DRIVE_SW Port is pulldown.
+     * When Ready to Drive SW is pushed, digitalRead(READY_TO_DRIVE_SW) will return 1.
+    */
+    const unsigned char shutdownBit = inputPins.add(SHUTDOWN_DETECT, INPUT_ACTIVE_LOW);
+    const unsigned char driveBit = inputPins.add(READY_TO_DRIVE_SW, INPUT_ACTIVE_HIGH);
+
+    /**
+     * Shifting by INPUT_PINS_NO_BIT is undefined, and without these inputs
+     * the shutdown circuit cannot be watched. Stop here with the AIRs open.
+    */
+    if (shutdownBit == INPUT_PINS_NO_BIT || driveBit == INPUT_PINS_NO_BIT)
+    {
+        Serial.println("InputPins add failed, check INPUT_PINS_MAX and INPUT_PINS_PORT_MAX");
+        for (;;)
+        {
+        }
+    }
+
+    shutdownDetect = 1U << shutdownBit;
+    driveSW = 1U << driveBit;
+
+    scheduler.addTask("can", taskCan, TASK_CAN_PERIOD);
+    scheduler.addTask("pedal", taskPedal, TASK_PEDAL_PERIOD);
+    scheduler.addTask("control", taskControl, TASK_CONTROL_PERIOD);
+    telemetryTask = scheduler.addTask("telemetry", taskTelemetry, telemetry.getPeriod());
+
 #ifdef ARDUINO_UNO_R4
-    AGTimer.init(500000, timerCallback);
+    AGTimer.init(1000, timerCallback);
     AGTimer.start();
 #else
-    MsTimer2::set(500, timerCallback);
+    MsTimer2::set(1, timerCallback);
     MsTimer2::start();
 #endif
 }
 
 void loop()
 {
-    unsigned long id = inverter->readMsgFromInverter(0);
+    PROFILE_BEGIN();
 
     /**
-     * Measuring the period of CAN Message coming from MG_ECU1.
-     * If the period exceeds 50ms, Shutdown.
+     * Run the tasks released by the timer tick.
+     * Loops where no task was due are not counted in the loop profile.
     */
-    nowTime = millis();
-    deltaTime = nowTime - lastTime;
-
-    if (id == MG_ECU1_ID)
+    if (scheduler.run() > 0)
     {
-        lastTime = nowTime;
+        PROFILE_END();
     }
-    else if (deltaTime > 50)
+
+    /**
+     * Serial commands for loop profile, telemetry mode, task statistics, probes and Inverter state trace / CAN status.
+     * Printing is done after PROFILE_END() so it is not included in the loop time.
+    */
+    while (Serial.available() > 0)
     {
-        setupFlag = 1;
-        shutdownDetect->setFlag();
+        int c = Serial.read();
+
+        if (telemetry.command(c))
+        {
+            scheduler.setPeriod(telemetryTask, telemetry.getPeriod());
+        }
+        else if (!PROFILE_COMMAND(c) && !scheduler.command(c) && !PROBE_COMMAND(c))
+        {
+            inverter->command(c);
+        }
     }
 
     /**
-     * Transmitting CAN Massage.
-     * If the number of massage sending failures exceeds 3, shutdown.
+     * Send telemetry captured by taskTelemetry.
+     * Only as many bytes as fit in the serial TX buffer are written.
     */
-    unsigned char result = inverter->sendMsgToInverter(0);
+    telemetry.service();
 
-#ifdef ARDUINO_UNO_R4
-    if (result < 0)
-    {
-        CANErrorCount++;
-    }
-    else
-    {
-        CANErrorCount = 0;
-    }
-#else
-    if (result != 0)
-    {
-        CANErrorCount++;
-    }
-    else
-    {
-        CANErrorCount = 0;
-    }
-#endif
+    /**
+     * On R4 the ADC has no scan interrupt here, so the sensors are read with analogRead
+     * a few at a time on every loop (ADC_SCAN_R4_ROUNDS in AdcScan_dfs.hpp). Nothing on AVR.
+    */
+    ADCScan.service();
 
-    if (CANErrorCount > 3)
+    //delay(100);
+}
+
+/**
+ * CAN controller service and reception (TASK_CAN_PERIOD).
+*/
+void taskCan(void)
+{
+    /**
+     * Initialize the CAN controller in the background.
+     * Retried every CAN_INIT_RETRY_PERIOD ms until it succeeds,
+     * and re-initialized after bus-off or CAN_REINIT_TX_ERROR consecutive TX failures.
+     * The other tasks keep running while the controller is not ready
+     * (no MG_ECU1 messages arrive, so the period check below shuts down).
+    */
+    inverter->serviceCan(millis());
+
+    /**
+     * Read all CAN Messages received since the last run.
+     * Each message is passed to the ECU registered for its ID.
+    */
+    inverter->readMsgFromInverter(0);
+
+    /**
+     * Measuring the period of CAN Message coming from MG_ECU1 and MG_ECU2.
+     * Frames are time-stamped in the CAN RX interrupt, so the period does not depend on the task timing.
+     * If MG_ECU1 (MG_ECU1_TIMEOUT, 50ms) or MG_ECU2 (MG_ECU2_TIMEOUT, 500ms) does not arrive, Shutdown.
+    */
+    if (inverter->checkRxTimeout(micros()))
     {
         setupFlag = 1;
-        shutdownDetect->setFlag();
+        switches.setFlag(shutdownDetect);
     }
 
+    PROFILE_STAGE(STAGE_CAN_RX);
+}
+
+/**
+ * Accel pedal sensors and torque (TASK_PEDAL_PERIOD).
+*/
+void taskPedal(void)
+{
     /**
-     * Read accel pedal position sensors.
+     * Read accel pedal position sensors and brake sensor from the latest ADC scan.
+     * Values are oversampled and decimated to 10 + ADC_FILTER_EXTRA_BITS bits (AdcFilter_dfs.hpp).
      * The number of Accel Pedal Position Sensors is 2.
      * Set value of sensors to accel object.
      * Range of sensors is configured in "Accel_dfs.hpp".
+     * On AVR the scan runs in the ADC interrupt, on R4 ADCScan.service() in loop() reads them.
     */
-    val[0] = analogRead(ACCEL_SENSOR1);
-    val[1] = analogRead(ACCEL_SENSOR2);
-    accel->setValue(val[0], val[1]);
+    unsigned short adc[ADC_SCAN_MAX];
+
+    ADCScan.readAll(adc);
 
-    deviation = accel->getDev();
+    val[0] = adc[accelChannel[0]];
+    val[1] = adc[accelChannel[1]];
+    brake = adc[brakeChannel];
+
+    PROFILE_STAGE(STAGE_ADC);
+
+    accel->setValue(val[0], val[1]);
 
     /**
      * If Torque Control Flag is 1, calculate torque from accelerator opening.
+     * In FIXED_POINT_TORQUE mode (Accel_dfs.hpp), torque is calculated
+     * in 0.5 Nm units with integer arithmetic only.
     */
+#ifdef FIXED_POINT_TORQUE
+    fixedTorque = torqueControlFlag ? accel->getFixedTorque() : 0;
+#else
     torque = torqueControlFlag ? accel->getTorque() : 0;
+#endif
+
+    PROFILE_STAGE(STAGE_ACCEL);
+}
 
+/**
+ * Switches, Inverter sequence, CAN transmission and outputs (TASK_CONTROL_PERIOD).
+*/
+void taskControl(void)
+{
     /**
-     * SHUTDOWN_DETECT Port is pulldown.
-     * When Shutdown Circuit is OPEN, digitalRead(SHUTdOWN_DETECT) will return 0.
+     * Read all switches at once and debounce them.
+     * The flag of a switch is set when it is pushed (shutdownDetect : Shutdown Circuit is OPEN).
     */
-    shutdownDetect->updateState(~digitalRead(SHUTDOWN_DETECT));
+    switches.update(inputPins.read());
 
     /**
      * Initial value of setupFlag is 0.
@@ -162,19 +314,12 @@ void loop()
      * this programs set setupFlag to 1 and reset shutdownFlag to 0.
      * When Shutdown Circuit is CLOSED, SETUP is complete.
      */
-    if (!setupFlag && shutdownDetect->getSWFlag())
+    if (!setupFlag && switches.getFlag(shutdownDetect))
     {
-        shutdownDetect->resetFlag();
+        switches.resetFlag(shutdownDetect);
         setupFlag = 1;
     }
 
-    /**
-     * READY_TO_DRIVE_SW Port is pulldown.
-     * When Ready to Drive SW is pushed,
-     * digitalRead(READY_TO_DRIVE_SW) will return 1.
-    */
-    driveSW->updateState(digitalRead(READY_TO_DRIVE_SW));
-
     /**
      * If driveFlag is set to 1 before airFlag and torqueControlFlag,
      * driveFlag is reset.
@@ -186,9 +331,9 @@ void loop()
      * Sequence is below.
      * GLVMS -> AMS, BSPD, IMD Reset -> TSMS -> Precharge -> RtDSW
     */
-    if (driveSW->getSWFlag() && !(airFlag && torqueControlFlag))
+    if (switches.getFlag(driveSW) && !(airFlag && torqueControlFlag))
     {
-        driveSW->resetFlag();
+        switches.resetFlag(driveSW);
         /*
         if (accel->getValue(0) * 0.0049f >= MINIMUM_SENSOR_VOLTAGE && accel->getValue(1) * 0.0049f >= MINIMUM_SENSOR_VOLTAGE)
         {
@@ -199,49 +344,120 @@ void loop()
     else if (!(flags[3] && flags[0] && flags[1]))
     {
         flags[3] = 0;
-        driveSW->resetFlag();
+        switches.resetFlag(driveSW);
     }
     */
 
-    flags[2] = shutdownDetect->getSWFlag();
-    flags[3] = driveSW->getSWFlag();
+    flags[2] = switches.getFlag(shutdownDetect);
+    flags[3] = switches.getFlag(driveSW);
 
+#ifdef FIXED_POINT_TORQUE
+    inverter->runInverterFixed(flags, accVol, -fixedTorque);
+#else
     inverter->runInverter(flags, accVol, -torque);
+#endif
 
     airFlag = flags[0];
     torqueControlFlag = flags[1];
 
+    PROFILE_STAGE(STAGE_INVERTER);
+
+    /**
+     * Transmitting CAN Massage every TX_PERIOD ms (Inverter_dfs.hpp),
+     * or immediately when ecuEnable, dischargeCommand or request torque changes.
+     * If the number of massage sending failures exceeds 3, shutdown.
+    */
+    if (inverter->isTxDue(getTick()))
+    {
+        if (inverter->sendMsgToInverter(0) != 0)
+        {
+            CANErrorCount++;
+        }
+        else
+        {
+            CANErrorCount = 0;
+        }
+
+        if (CANErrorCount > 3)
+        {
+            setupFlag = 1;
+            switches.setFlag(shutdownDetect);
+        }
+    }
+
+    PROFILE_STAGE(STAGE_CAN_TX);
+
     digitalWrite(AIR_PLUS_SIG, airFlag);
 
-    digitalWrite(AIR_MINUS_SIG, !(shutdownDetect->getSWFlag()));
+    digitalWrite(AIR_MINUS_SIG, !(switches.getFlag(shutdownDetect)));
 
-    digitalWrite(READY_TO_DRIVE_LED, driveSW->getSWFlag());
+    digitalWrite(READY_TO_DRIVE_LED, switches.getFlag(driveSW));
 
-    //delay(100);
+    PROFILE_STAGE(STAGE_GPIO);
+}
+
+unsigned long getTick(void)
+{
+    noInterrupts();
+    unsigned long t = tick;
+    interrupts();
+    return t;
 }
 
 void timerCallback(void)
 {
-    Serial.print("airFlag : ");
-    Serial.println(airFlag);
-    Serial.print("torqueControlFlag : ");
-    Serial.println(torqueControlFlag);
-    Serial.print("shutdownFlag : ");
-    Serial.println(shutdownDetect->getSWFlag());
-    Serial.print("driveFlag : ");
-    Serial.println(driveSW->getSWFlag());
-    Serial.print("Accel1 : ");
-    Serial.println(accel->getValue(0));
-    Serial.print("Accel2 : ");
-    Serial.println(accel->getValue(1));
-    Serial.print("Deviation : ");
-    Serial.println(accel->getDev());
-    Serial.print("Torque : ");
-    Serial.println(torque);
-    Serial.print("MGECU1 MSG Period : ");
-    Serial.println(deltaTime);
-    Serial.print("Deviation of Accel Sensors : ");
-    Serial.println(deviation);
-    inverter->checkMsg(MG_ECU1_ID);
-    inverter->checkMsg(MG_ECU2_ID);
-}
\ No newline at end of file
+    tick++;
+    scheduler.tick();
+}
+
+/**
+ * Take a telemetry snapshot every Telemetry::getPeriod() ms.
+ * It is sent from loop() by telemetry.service() without blocking.
+*/
+void taskTelemetry(void)
+{
+    TELEMETRY_STATUS *status = telemetry.reserve();
+
+    if (status == nullptr)
+    {
+        return;
+    }
+
+    status->tick = getTick();
+    status->flags = (airFlag ? TELEMETRY_FLAG_AIR : 0) |
+                    (torqueControlFlag ? TELEMETRY_FLAG_TORQUE_CONTROL : 0) |
+                    (switches.getFlag(shutdownDetect) ? TELEMETRY_FLAG_SHUTDOWN : 0) |
+                    (switches.getFlag(driveSW) ? TELEMETRY_FLAG_DRIVE : 0) |
+                    (inverter->getCanState() == CAN_STATE_READY ? TELEMETRY_FLAG_CAN_READY : 0) |
+                    (inverter->getPeriodMonitor()->isTimeout(MG_ECU1_ID) ? TELEMETRY_FLAG_MGECU1_TIMEOUT : 0) |
+                    (inverter->getPeriodMonitor()->isTimeout(MG_ECU2_ID) ? TELEMETRY_FLAG_MGECU2_TIMEOUT : 0);
+    status->accel[0] = accel->getValue(0);
+    status->accel[1] = accel->getValue(1);
+    status->accelDevCount = accel->getDevCount();
+#ifdef FIXED_POINT_TORQUE
+    status->torque = fixedTorque;
+#else
+    status->torque = (short)(torque * FIXED_TORQUE_RESOLUTION);
+#endif
+    const PERIOD_STAT *mgecu1Stat = inverter->getPeriodMonitor()->getStat(MG_ECU1_ID);
+    status->mgecu1Period = mgecu1Stat->last > 0xFFFF ? 0xFFFF : mgecu1Stat->last;
+    status->rxMaxCount = inverter->getRxMaxCount();
+    status->rxOverflow = inverter->getRxOverflowCount();
+    status->ctrlOverflow = inverter->getCtrlOverflowCount();
+    status->rxRejected = inverter->getUnknownCount() + inverter->getInvalidCount();
+    status->txMaxPeriod = inverter->getTxScheduler()->getMaxPeriod();
+    status->txJitter = inverter->getTxScheduler()->getJitter();
+    status->txEvent = inverter->getTxScheduler()->getEventCount();
+    status->busLoad = inverter->getTxScheduler()->getBusLoad();
+    status->dropCount = telemetry.getDropCount();
+    status->canReinit = inverter->getCanReinitCount() > 0xFF ? 0xFF : inverter->getCanReinitCount();
+    status->canBusOff = inverter->getCanBusOffCount() > 0xFF ? 0xFF : inverter->getCanBusOffCount();
+    status->canInitFail = inverter->getCanInitFailCount() > 0xFF ? 0xFF : inverter->getCanInitFailCount();
+    const unsigned long canInitMax = (inverter->getCanInitMaxTime() + 999) / 1000;
+    status->canInitMax = canInitMax > 0xFF ? 0xFF : canInitMax;
+    inverter->getMsg(EV_ECU1_ID, status->evecu1);
+    inverter->getMsg(MG_ECU1_ID, status->mgecu1);
+    inverter->getMsg(MG_ECU2_ID, status->mgecu2);
+
+    telemetry.commit();
+}
@@ -0,0 +1,392 @@
+#include "CanLog.hpp"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CAN_SFF_MAX (0x7FFUL)
+#define CAN_EFF_MAX (0x1FFFFFFFUL)
+
+static int hexValue(char c)
+{
+    if ('0' <= c && c <= '9')
+    {
+        return c - '0';
+    }
+    if ('a' <= c && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if ('A' <= c && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+CanLogWriter::CanLogWriter()
+    : fp(nullptr), format(CAN_LOG_CANDUMP), ifname{0}, count(0), startTime(0)
+{
+}
+
+CanLogWriter::~CanLogWriter()
+{
+    close();
+}
+
+unsigned char CanLogWriter::open(const char *path, unsigned char format, const char *ifname)
+{
+    close();
+
+    fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (fp == nullptr)
+    {
+        return 1;
+    }
+
+    this->format = format;
+    strncpy(this->ifname, ifname, sizeof(this->ifname) - 1);
+    this->ifname[sizeof(this->ifname) - 1] = '\0';
+    count = 0;
+
+    if (format == CAN_LOG_ASC)
+    {
+        char date[64];
+        time_t now = time(nullptr);
+
+        strftime(date, sizeof(date), "%a %b %d %I:%M:%S.000 %p %Y", localtime(&now));
+        fprintf(fp, "date %s\n", date);
+        fprintf(fp, "base hex  timestamps absolute\n");
+        fprintf(fp, "no internal events logged\n");
+        fprintf(fp, "Begin Triggerblock %s\n", date);
+        fprintf(fp, "   0.000000 Start of measurement\n");
+    }
+
+    return 0;
+}
+
+unsigned char CanLogWriter::write(const CAN_LOG_RECORD *record)
+{
+    if (fp == nullptr || record->len > 8)
+    {
+        return 1;
+    }
+
+    if (format == CAN_LOG_ASC)
+    {
+        // ASC の時刻は測定開始(最初のフレーム)からの経過時間 (最初より前の時刻は 0 にする)
+        if (count == 0)
+        {
+            startTime = record->time;
+        }
+        const unsigned long long t = record->time > startTime ? record->time - startTime : 0;
+        char id[16];
+
+        snprintf(id, sizeof(id), record->extended ? "%lXx" : "%lX", record->id);
+        fprintf(fp, "%4llu.%06llu 1  %-15s %s   %c %u", t / 1000000, t % 1000000, id,
+                record->tx ? "Tx" : "Rx", record->remote ? 'r' : 'd', record->len);
+        for (int i = 0; !record->remote && i < record->len; i++)
+        {
+            fprintf(fp, " %02X", record->buf[i]);
+        }
+        fputc('\n', fp);
+    }
+    else
+    {
+        fprintf(fp, "(%llu.%06llu) %s ", record->time / 1000000, record->time % 1000000, ifname);
+        fprintf(fp, record->extended ? "%08lX#" : "%03lX#", record->id);
+        if (record->remote)
+        {
+            fputc('R', fp);
+        }
+        else
+        {
+            for (int i = 0; i < record->len; i++)
+            {
+                fprintf(fp, "%02X", record->buf[i]);
+            }
+        }
+        fputc('\n', fp);
+    }
+
+    count++;
+    return ferror(fp) ? 1 : 0;
+}
+
+void CanLogWriter::close(void)
+{
+    if (fp == nullptr)
+    {
+        return;
+    }
+
+    if (format == CAN_LOG_ASC)
+    {
+        fprintf(fp, "End TriggerBlock\n");
+    }
+
+    if (fp == stdout)
+    {
+        fflush(fp);
+    }
+    else
+    {
+        fclose(fp);
+    }
+    fp = nullptr;
+}
+
+CanLogReader::CanLogReader()
+    : fp(nullptr), decimal(0), lineCount(0), skipCount(0)
+{
+}
+
+CanLogReader::~CanLogReader()
+{
+    close();
+}
+
+unsigned char CanLogReader::open(const char *path)
+{
+    close();
+
+    fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    decimal = 0;
+    lineCount = 0;
+    skipCount = 0;
+
+    return fp == nullptr ? 1 : 0;
+}
+
+void CanLogReader::close(void)
+{
+    if (fp != nullptr && fp != stdin)
+    {
+        fclose(fp);
+    }
+    fp = nullptr;
+}
+
+/**
+ * (1697500000.123456) can0 311#0102030405060708
+ * 小数部の桁数は6桁に限らない (candump は6桁で書く)
+ */
+unsigned char CanLogReader::parseCandump(const char *line, CAN_LOG_RECORD *record)
+{
+    const char *p = line;
+    unsigned long long sec = 0, frac = 0, scale = 1000000;
+
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    if (*p++ != '(')
+    {
+        return 1;
+    }
+    while (isdigit((unsigned char)*p))
+    {
+        sec = sec * 10 + (*p++ - '0');
+    }
+    if (*p++ != '.')
+    {
+        return 1;
+    }
+    while (isdigit((unsigned char)*p))
+    {
+        if (scale > 1)
+        {
+            scale /= 10;
+            frac += (*p - '0') * scale;
+        }
+        p++;
+    }
+    if (*p++ != ')')
+    {
+        return 1;
+    }
+
+    // インターフェース名は読み飛ばす
+    while (*p == ' ')
+    {
+        p++;
+    }
+    while (*p != ' ' && *p != '\0')
+    {
+        p++;
+    }
+    while (*p == ' ')
+    {
+        p++;
+    }
+
+    // ID
+    const char *idStart = p;
+    unsigned long id = 0;
+    while (hexValue(*p) >= 0)
+    {
+        id = (id << 4) | hexValue(*p++);
+    }
+    const long idLength = p - idStart;
+
+    // CAN FD (##) は扱わない
+    if (*p++ != '#' || *p == '#' || (idLength != 3 && idLength != 8))
+    {
+        return 1;
+    }
+
+    record->time = sec * 1000000 + frac;
+    record->id = id;
+    record->extended = idLength == 8;
+    record->remote = 0;
+    record->tx = 0;
+    record->len = 0;
+
+    // エラーフレームなど, フラグの付いたIDは読み飛ばす
+    if (id > (record->extended ? CAN_EFF_MAX : CAN_SFF_MAX))
+    {
+        return 1;
+    }
+
+    if (*p == 'R' || *p == 'r')
+    {
+        record->remote = 1;
+        record->len = isdigit((unsigned char)p[1]) ? p[1] - '0' : 0;
+        return record->len > 8 ? 1 : 0;
+    }
+
+    while (hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0)
+    {
+        if (record->len >= 8)
+        {
+            return 1;
+        }
+        record->buf[record->len++] = (hexValue(p[0]) << 4) | hexValue(p[1]);
+        p += 2;
+        if (*p == '.')
+        {
+            p++;
+        }
+    }
+
+    return (*p == '\0' || isspace((unsigned char)*p)) ? 0 : 1;
+}
+
+/**
+ *    0.123456 1  311             Rx   d 8 01 02 03 04 05 06 07 08
+ *    0.123456 1  1FFFFFFFx       Rx   r 8
+ */
+unsigned char CanLogReader::parseAsc(const char *line, CAN_LOG_RECORD *record)
+{
+    char *p;
+    const int base = decimal ? 10 : 16;
+
+    double t = strtod(line, &p);
+    if (p == line || !isspace((unsigned char)*p))
+    {
+        return 1;
+    }
+
+    // チャンネル番号
+    char *q;
+    strtol(p, &q, 10);
+    if (q == p)
+    {
+        return 1;
+    }
+    p = q;
+
+    unsigned long id = strtoul(p, &q, base);
+    if (q == p)
+    {
+        return 1;
+    }
+    p = q;
+
+    record->extended = 0;
+    if (*p == 'x')
+    {
+        record->extended = 1;
+        p++;
+    }
+
+    if (id > (record->extended ? CAN_EFF_MAX : CAN_SFF_MAX))
+    {
+        return 1;
+    }
+
+    char dir[8], type;
+    int len, n;
+    if (sscanf(p, " %7s %c %d%n", dir, &type, &len, &n) != 3 || len < 0 || len > 8)
+    {
+        return 1;
+    }
+    if (strcmp(dir, "Rx") != 0 && strcmp(dir, "Tx") != 0)
+    {
+        return 1;
+    }
+    if (type != 'd' && type != 'r')
+    {
+        return 1;
+    }
+    p += n;
+
+    record->time = (unsigned long long)(t * 1000000.0 + 0.5);
+    record->id = id;
+    record->remote = type == 'r';
+    record->tx = strcmp(dir, "Tx") == 0;
+    record->len = len;
+
+    for (int i = 0; !record->remote && i < len; i++)
+    {
+        unsigned long b = strtoul(p, &q, base);
+        if (q == p || b > 0xFF)
+        {
+            return 1;
+        }
+        record->buf[i] = b;
+        p = q;
+    }
+
+    return 0;
+}
+
+unsigned char CanLogReader::read(CAN_LOG_RECORD *record)
+{
+    char line[CAN_LOG_LINE_MAX];
+
+    if (fp == nullptr)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        lineCount++;
+
+        const char *p = line;
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+
+        if (strncmp(p, "base ", 5) == 0)
+        {
+            decimal = strncmp(p + 5, "dec", 3) == 0;
+            skipCount++;
+            continue;
+        }
+
+        memset(record, 0, sizeof(*record));
+
+        if (*p == '(' ? parseCandump(p, record) == 0 : parseAsc(p, record) == 0)
+        {
+            return 1;
+        }
+
+        skipCount++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef _CAN_LOG_H_
+#define _CAN_LOG_H_
+
+#include <stdio.h>
+
+/**
+ * CANフレームのログファイルの読み書き (ホストPC用)
+ *
+ * CAN_LOG_CANDUMP : can-utils の candump -L と同じ形式 (canplayer でも再生できる)
+ *   (1697500000.123456) can0 311#0102030405060708
+ *   拡張IDは8桁, リモートフレームは 311#R
+ * CAN_LOG_ASC     : Vector ASC 形式 (base hex, timestamps absolute)
+ *      0.123456 1  311             Rx   d 8 01 02 03 04 05 06 07 08
+ *   拡張IDは末尾に x
+ *
+ * 読み込みは1行ごとに形式を判定するので, どちらのファイルもそのまま読める
+ * ヘッダやコメントなど読めない行は飛ばして数える
+ */
+
+#define CAN_LOG_CANDUMP (0)
+#define CAN_LOG_ASC (1)
+
+#define CAN_LOG_LINE_MAX (256)
+#define CAN_LOG_IFNAME_MAX (16)
+
+// ログの1フレーム
+struct CAN_LOG_RECORD
+{
+    unsigned long long time; // 時刻[us] (candump は UNIX 時間, ASC は測定開始から)
+    unsigned long id;
+    unsigned char extended; // 拡張ID(29bit)
+    unsigned char remote;   // リモートフレーム
+    unsigned char tx;       // 送信したフレーム (ASC の Tx)
+    unsigned char len;
+    unsigned char buf[8];
+};
+
+class CanLogWriter
+{
+private:
+    FILE *fp;
+    unsigned char format;
+    char ifname[CAN_LOG_IFNAME_MAX];
+    unsigned long count;
+    unsigned long long startTime; // ASC の時刻の基準 (最初のフレームの時刻)
+
+public:
+    CanLogWriter();
+    ~CanLogWriter();
+
+    /**
+     * @fn      open
+     *
+     * @brief   ログファイルを作る. format が CAN_LOG_ASC のときはヘッダを書く
+     *
+     * @param   path    ファイル名 ("-" のときは標準出力)
+     * @param   format  CAN_LOG_CANDUMP or CAN_LOG_ASC
+     * @param   ifname  candump 形式に書くインターフェース名
+     *
+     * @return  Success(0), Fail(1)
+     */
+    unsigned char open(const char *path, unsigned char format, const char *ifname);
+
+    // 1フレーム書く, 戻り値 : 0(成功) or 1(失敗)
+    unsigned char write(const CAN_LOG_RECORD *record);
+
+    // ASC のときはフッタを書いて閉じる
+    void close(void);
+
+    inline unsigned long getCount(void) { return count; }
+};
+
+class CanLogReader
+{
+private:
+    FILE *fp;
+    unsigned char decimal; // ASC の base dec
+    unsigned long lineCount;
+    unsigned long skipCount;
+
+    unsigned char parseCandump(const char *line, CAN_LOG_RECORD *record);
+    unsigned char parseAsc(const char *line, CAN_LOG_RECORD *record);
+
+public:
+    CanLogReader();
+    ~CanLogReader();
+
+    // ログファイルを開く ("-" のときは標準入力), 戻り値 : 0(成功) or 1(失敗)
+    unsigned char open(const char *path);
+
+    void close(void);
+
+    /**
+     * @fn      read
+     *
+     * @brief   次のフレームを読む. 読めない行は飛ばす
+     *
+     * @return  読んだ(1), ファイルの終わり(0)
+     */
+    unsigned char read(CAN_LOG_RECORD *record);
+
+    inline unsigned long getLineCount(void) { return lineCount; }
+
+    // 読み飛ばした行の数(ヘッダ, コメント, エラーフレームなど)
+    inline unsigned long getSkipCount(void) { return skipCount; }
+};
+
+#endif
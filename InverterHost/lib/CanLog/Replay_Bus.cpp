@@ -0,0 +1,179 @@
+#include "Replay_Bus.hpp"
+
+#include <Arduino.h>
+#include <string.h>
+#include <time.h>
+
+static unsigned long long wallMicros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+Replay_Bus::Replay_Bus(CanLogReader *reader)
+    : reader(reader), nextFlag(0), logStart(0), logTime(0), clockStart(0), wallStart(0), speed(0),
+      filterNum(0), replayCount(0), filteredCount(0), txCount(0)
+{
+}
+
+unsigned char Replay_Bus::start(double speed)
+{
+    nextFlag = reader->read(&next);
+    if (!nextFlag)
+    {
+        return 1;
+    }
+
+    hostUseVirtualClock(1);
+
+    this->speed = speed;
+    logStart = next.time;
+    logTime = next.time;
+    clockStart = micros();
+    wallStart = wallMicros();
+
+    receive();
+    return 0;
+}
+
+unsigned char Replay_Bus::step(unsigned long maxStep)
+{
+    if (!nextFlag)
+    {
+        return 0;
+    }
+
+    const unsigned long due = getDueTime();
+    const long wait = (long)(due - micros());
+
+    if (wait > 0)
+    {
+        hostAdvanceMicros((unsigned long)wait < maxStep ? wait : maxStep);
+    }
+
+    pace();
+    receive();
+
+    return 1;
+}
+
+void Replay_Bus::pace(void)
+{
+    if (speed <= 0)
+    {
+        return;
+    }
+
+    const unsigned long long target = wallStart + (unsigned long long)((micros() - clockStart) / speed);
+    const unsigned long long now = wallMicros();
+
+    if (target > now)
+    {
+        struct timespec ts;
+        ts.tv_sec = (target - now) / 1000000;
+        ts.tv_nsec = ((target - now) % 1000000) * 1000;
+        nanosleep(&ts, nullptr);
+    }
+}
+
+unsigned long Replay_Bus::getDueTime(void)
+{
+    // ログの時刻が戻ったとき(ログを連結したときなど)は直前のフレームと同じ時刻に届ける
+    const unsigned long long t = next.time > logTime ? next.time : logTime;
+
+    return clockStart + (unsigned long)(t - logStart);
+}
+
+unsigned char Replay_Bus::accept(const CAN_LOG_RECORD *record)
+{
+    if (record->extended || record->remote || record->len > 8)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < filterNum; i++)
+    {
+        if (filterIDs[i] == record->id)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void Replay_Bus::receive(void)
+{
+    const unsigned long now = micros();
+
+    while (nextFlag)
+    {
+        const unsigned long due = getDueTime();
+
+        if ((long)(now - due) < 0)
+        {
+            break;
+        }
+
+        if (accept(&next))
+        {
+            CAN_FRAME *frame = rxBuffer.reserve();
+
+            frame->id = next.id;
+            frame->len = next.len;
+            memcpy(frame->buf, next.buf, next.len);
+            frame->timestamp = due;
+            rxBuffer.commit(frame);
+            replayCount++;
+        }
+        else
+        {
+            filteredCount++;
+        }
+
+        logTime = next.time > logTime ? next.time : logTime;
+        nextFlag = reader->read(&next);
+    }
+}
+
+unsigned char Replay_Bus::begin(const unsigned long *ids, unsigned char num)
+{
+    if (num > REPLAY_FILTER_NUM)
+    {
+        return 1;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        filterIDs[i] = ids[i];
+    }
+    filterNum = num;
+
+    return 0;
+}
+
+int Replay_Bus::write(unsigned long id, unsigned char len, const unsigned char *buf)
+{
+    if (len > 8)
+    {
+        return 1;
+    }
+
+    txCount++;
+    return 0;
+}
+
+unsigned char Replay_Bus::read(CAN_FRAME *frame)
+{
+    CAN_FRAME *front = rxBuffer.front();
+
+    if (front == nullptr)
+    {
+        return 0;
+    }
+
+    *frame = *front;
+    rxBuffer.pop();
+    return 1;
+}
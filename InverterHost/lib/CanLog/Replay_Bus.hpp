@@ -0,0 +1,100 @@
+#ifndef _REPLAY_BUS_H_
+#define _REPLAY_BUS_H_
+
+#include <Arduino.h>
+#include "CanBus.hpp"
+#include "CanLog.hpp"
+
+#define REPLAY_FILTER_NUM (8) // 受信するIDの最大数
+
+/**
+ * ログファイルのフレームを受信したことにする CanBus (ホストPC用)
+ *
+ * 時間はホストの仮想時計 (hostUseVirtualClock) で進め, 各フレームはログの時刻に届く
+ * CAN_FRAME::timestamp もログの時刻 (再生を始めた micros() からの経過時間) になるので,
+ * PeriodMonitor の受信周期, タイムアウトは実機で記録したときと同じに判定される
+ *
+ * 再生の速さは実時間との比で決める (仮想時計の進み方は変わらない)
+ *  1   : 実時間
+ *  100 : 100倍速
+ *  0   : 待たずにできるだけ速く
+ *
+ * 受信バッファに入りきらないフレームは実機と同じく捨てて数える
+ * 拡張ID, リモートフレーム, 受信フィルタにないIDは受信しない
+ * 送信は成功したことにして数えるだけ
+ */
+class Replay_Bus : public CanBus
+{
+private:
+    CanLogReader *reader;
+    CAN_LOG_RECORD next;           // 次に届くフレーム
+    unsigned char nextFlag;        // next が読み込んである
+    unsigned long long logStart;   // ログの最初のフレームの時刻[us]
+    unsigned long long logTime;    // 最後に届けたフレームのログの時刻[us]
+    unsigned long clockStart;      // 再生を始めたときの micros()
+    unsigned long long wallStart;  // 再生を始めたときの実時間[us]
+    double speed;
+
+    RxBuffer rxBuffer;
+    unsigned long filterIDs[REPLAY_FILTER_NUM];
+    unsigned char filterNum;
+
+    unsigned long replayCount;   // 受信バッファに入れたフレーム数
+    unsigned long filteredCount; // 受信しなかったフレーム数
+    unsigned long txCount;
+
+    unsigned char accept(const CAN_LOG_RECORD *record);
+
+    // next が届く micros()
+    unsigned long getDueTime(void);
+
+    // 時刻が来たフレームを受信バッファへ入れる
+    void receive(void);
+
+    // 実時間が speed 倍の仮想時計に追いつくまで待つ
+    void pace(void);
+
+public:
+    Replay_Bus(CanLogReader *reader);
+
+    /**
+     * @fn      start
+     *
+     * @brief   仮想時計に切り替えて再生を始める. ログの最初のフレームは今の micros() に届く
+     *
+     * @param   speed   実時間との比 (0 のときは待たない)
+     *
+     * @return  Success(0), Fail(1, ログにフレームが無い)
+     */
+    unsigned char start(double speed);
+
+    /**
+     * @fn      step
+     *
+     * @brief   仮想時計を次のフレームの時刻まで進め(maxStep[us] より先には進めない),
+     *          時刻が来たフレームを受信バッファへ入れる
+     *          loop() の1回分として, 呼ぶたびに Inverter::readMsgFromInverter などを呼ぶこと
+     *
+     * @return  再生中(1), ログの終わり(0)
+     */
+    unsigned char step(unsigned long maxStep);
+
+    // ログの最初のフレームからの経過時間[us]
+    inline unsigned long getLogTime(void) { return micros() - clockStart; }
+
+    inline unsigned long getReplayCount(void) { return replayCount; }
+    inline unsigned long getFilteredCount(void) { return filteredCount; }
+    inline unsigned long getTxCount(void) { return txCount; }
+
+    unsigned char begin(const unsigned long *ids, unsigned char num) override;
+    int write(unsigned long id, unsigned char len, const unsigned char *buf) override;
+    unsigned char read(CAN_FRAME *frame) override;
+    inline const CAN_FRAME *peek(void) override { return rxBuffer.front(); }
+    inline void release(void) override { rxBuffer.pop(); }
+
+    inline unsigned char available(void) override { return rxBuffer.getCount(); }
+    inline unsigned char getMaxCount(void) override { return rxBuffer.getMaxCount(); }
+    inline unsigned short getOverflowCount(void) override { return rxBuffer.getOverflowCount(); }
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+HostSerial Serial;
+
+static unsigned char serialEnableFlag = 1;
+
+void hostSerialEnable(unsigned char enable)
+{
+    serialEnableFlag = enable;
+}
+
+static unsigned long long nowMicros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static const unsigned long long startMicros = nowMicros();
+static unsigned char virtualClockFlag = 0;
+static unsigned long long virtualMicros = 0;
+
+static unsigned long long elapsedMicros(void)
+{
+    return virtualClockFlag ? virtualMicros : nowMicros() - startMicros;
+}
+
+void hostUseVirtualClock(unsigned char enable)
+{
+    // 切り替えても時間が戻らないように現在の時刻から始める
+    virtualMicros = elapsedMicros();
+    virtualClockFlag = enable;
+}
+
+void hostAdvanceMicros(unsigned long us)
+{
+    virtualMicros += us;
+}
+
+unsigned long millis(void)
+{
+    return (unsigned long)(elapsedMicros() / 1000);
+}
+
+unsigned long micros(void)
+{
+    return (unsigned long)elapsedMicros();
+}
+
+void delay(unsigned long ms)
+{
+    if (virtualClockFlag)
+    {
+        virtualMicros += (unsigned long long)ms * 1000;
+        return;
+    }
+
+    usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (virtualClockFlag)
+    {
+        virtualMicros += us;
+        return;
+    }
+
+    usleep(us);
+}
+
+void HostSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+int HostSerial::available(void)
+{
+    struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+
+    if (poll(&fd, 1, 0) <= 0)
+    {
+        return 0;
+    }
+
+    int count = 0;
+    ioctl(STDIN_FILENO, FIONREAD, &count);
+    return count;
+}
+
+int HostSerial::read(void)
+{
+    unsigned char c;
+
+    if (available() <= 0 || ::read(STDIN_FILENO, &c, 1) != 1)
+    {
+        return -1;
+    }
+
+    return c;
+}
+
+size_t HostSerial::write(unsigned char c)
+{
+    return serialEnableFlag ? fwrite(&c, 1, 1, stdout) : 1;
+}
+
+size_t HostSerial::write(const unsigned char *buf, size_t len)
+{
+    return serialEnableFlag ? fwrite(buf, 1, len, stdout) : len;
+}
+
+void HostSerial::flush(void)
+{
+    fflush(stdout);
+}
+
+size_t HostSerial::printNumber(unsigned long n, int base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+    {
+        base = 10;
+    }
+
+    *str = '\0';
+    do
+    {
+        unsigned long m = n;
+        n /= base;
+        char c = m - base * n;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+
+    return print(str);
+}
+
+size_t HostSerial::print(const char *str)
+{
+    return write((const unsigned char *)str, strlen(str));
+}
+
+size_t HostSerial::print(char c)
+{
+    return write((unsigned char)c);
+}
+
+size_t HostSerial::print(unsigned char n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t HostSerial::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t HostSerial::print(unsigned int n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t HostSerial::print(long n, int base)
+{
+    // Arduino と同じく, 10進数以外は負の数も符号なしで表示する
+    if (base == 10 && n < 0)
+    {
+        return print('-') + printNumber(-(unsigned long)n, 10);
+    }
+
+    return printNumber((unsigned long)n, base);
+}
+
+size_t HostSerial::print(unsigned long n, int base)
+{
+    return printNumber(n, base);
+}
+
+size_t HostSerial::print(double n, int digits)
+{
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+
+    if (len < 0)
+    {
+        return 0;
+    }
+
+    return write((const unsigned char *)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+}
+
+size_t HostSerial::println(void)
+{
+    return print("\n");
+}
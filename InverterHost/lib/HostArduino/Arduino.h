@@ -0,0 +1,92 @@
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+/**
+ * ホストPCで Arduino 向けのライブラリを動かすための最小限の Arduino.h
+ * Serial は標準出力/標準入力, millis(), micros() はプロセス起動からの経過時間
+ * hostUseVirtualClock(1) の後は時間が hostAdvanceMicros() と delay() でしか進まないので,
+ * シミュレーションを実時間より速く回せる
+ * 割り込みは無いので noInterrupts(), interrupts() は何もしない
+ * PROGMEM は付けても何もせず, pgm_read_* は普通に読む
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DEC (10)
+#define HEX (16)
+#define OCT (8)
+#define BIN (2)
+
+#define LOW (0)
+#define HIGH (1)
+#define INPUT (0)
+#define OUTPUT (1)
+#define INPUT_PULLUP (2)
+
+typedef uint8_t byte;
+
+class HostSerial
+{
+private:
+    size_t printNumber(unsigned long n, int base);
+
+public:
+    void begin(unsigned long baud);
+    inline operator bool() { return true; }
+
+    // 標準入力に届いているバイト数(ブロックしない)
+    int available(void);
+    int read(void);
+
+    // 標準出力はブロックしても問題ないので常に空きがあるものとする
+    inline int availableForWrite(void) { return 64; }
+
+    size_t write(unsigned char c);
+    size_t write(const unsigned char *buf, size_t len);
+    void flush(void);
+
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println(void);
+    template <class T>
+    size_t println(T value) { return print(value) + println(); }
+    template <class T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+extern HostSerial Serial;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Serial の出力を止める(0)/再開する(1), 大量に繰り返すシミュレーションで使う
+void hostSerialEnable(unsigned char enable);
+
+// 仮想時計に切り替える(0 : 実時間に戻す)
+void hostUseVirtualClock(unsigned char enable);
+
+// 仮想時計を進める
+void hostAdvanceMicros(unsigned long us);
+
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// ホストPCは Flash と RAM が分かれていないので PROGMEM は普通の変数と同じ
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#define pgm_read_word(addr) (*(const unsigned short *)(addr))
+
+#endif
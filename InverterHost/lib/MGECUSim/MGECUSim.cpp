@@ -0,0 +1,253 @@
+#include "MGECUSim.hpp"
+#include <Arduino.h>
+
+#define RPM_TO_RAD_S (0.104719755f) // 2π/60
+
+/**
+ * Massage のビット配置は Inverter_CAN.ino の送信データと同じ (リトルエンディアン, LSB から詰める)
+ * ECUクラスの共用体とは独立に詰めるので, 受信側の配置の誤りも検出できる
+ */
+static void putBits(unsigned char *buf, unsigned char start, unsigned char len, unsigned long value)
+{
+    for (int i = 0; i < len; i++)
+    {
+        unsigned char bit = start + i;
+
+        if (value & (1UL << i))
+        {
+            buf[bit >> 3] |= 1 << (bit & 7);
+        }
+        else
+        {
+            buf[bit >> 3] &= ~(1 << (bit & 7));
+        }
+    }
+}
+
+static unsigned long getBits(const unsigned char *buf, unsigned char start, unsigned char len)
+{
+    unsigned long value = 0;
+
+    for (int i = 0; i < len; i++)
+    {
+        unsigned char bit = start + i;
+        value |= (unsigned long)((buf[bit >> 3] >> (bit & 7)) & 1) << i;
+    }
+
+    return value;
+}
+
+static float clampf(float value, float min, float max)
+{
+    return value < min ? min : (max < value ? max : value);
+}
+
+MGECUSim::MGECUSim(CanBus *bus, float batteryVoltage)
+    : bus(bus), ecuEnable(0), dischargeCommand(0), requestTorque(0), lastCommandTime(0), commandCount(0),
+      tractiveSystem(0), air(0), batteryVoltage(batteryVoltage),
+      workingStatus(WORKING_INIT), failureStatus(FAILURE_NO_ERROR), dcVoltage(0), torque(0), motorSpeed(0),
+      inverterTemp(SIM_AMBIENT_TEMP), motorTemp(SIM_AMBIENT_TEMP), maxMotorTorque(SIM_MOTOR_MAX_TORQUE),
+      startTime(0), lastStepTime(0), lastMgecu1Time(0), lastMgecu2Time(0), statusChangeTime(0)
+{
+}
+
+unsigned char MGECUSim::begin(void)
+{
+    const unsigned long ids[] = {EV_ECU1_ID};
+
+    if (bus->begin(ids, 1))
+    {
+        return 1;
+    }
+
+    startTime = micros();
+    lastStepTime = startTime;
+    lastMgecu1Time = startTime - SIM_MG_ECU1_PERIOD;
+    lastMgecu2Time = startTime - SIM_MG_ECU2_PERIOD;
+    statusChangeTime = startTime;
+
+    return 0;
+}
+
+void MGECUSim::step(void)
+{
+    unsigned long now = micros();
+
+    receive(now);
+
+    // 1ms より細かくは進めない (Inverter の制御周期より十分短い)
+    while (now - lastStepTime >= 1000)
+    {
+        lastStepTime += 1000;
+        updatePlant(0.001f);
+        updateStatus(lastStepTime);
+    }
+
+    if (now - lastMgecu1Time >= SIM_MG_ECU1_PERIOD)
+    {
+        lastMgecu1Time += SIM_MG_ECU1_PERIOD;
+        sendMgecu1();
+    }
+
+    if (now - lastMgecu2Time >= SIM_MG_ECU2_PERIOD)
+    {
+        lastMgecu2Time += SIM_MG_ECU2_PERIOD;
+        sendMgecu2();
+    }
+}
+
+void MGECUSim::receive(unsigned long now)
+{
+    CAN_FRAME frame;
+
+    while (bus->read(&frame))
+    {
+        if (frame.id != EV_ECU1_ID || frame.len != 8)
+        {
+            continue;
+        }
+
+        ecuEnable = getBits(frame.buf, 0, 1);
+        dischargeCommand = getBits(frame.buf, 1, 1);
+        requestTorque = getBits(frame.buf, 8, 12) * 0.5f - 1000.0f;
+        lastCommandTime = now;
+        commandCount++;
+    }
+}
+
+void MGECUSim::updateStatus(unsigned long now)
+{
+    unsigned char next = workingStatus;
+
+    switch (workingStatus)
+    {
+    case WORKING_INIT:
+        if (now - startTime >= SIM_INIT_TIME)
+        {
+            next = WORKING_PRECHARGE;
+        }
+        break;
+
+    case WORKING_PRECHARGE:
+        if (ecuEnable && dcVoltage >= MINIMUM_INPUT_VOLTAGE)
+        {
+            next = WORKING_TORQUE_CONTROL;
+        }
+        break;
+
+    case WORKING_TORQUE_CONTROL:
+        if (!ecuEnable)
+        {
+            // 回転中にゲートを止めると Critical Error
+            if (fabsf(motorSpeed) >= ECU_DISABLE_MOTOR_SPEED)
+            {
+                failureStatus = FAILURE_CRITICAL_ERROR;
+            }
+            next = WORKING_STANDBY;
+        }
+        break;
+
+    case WORKING_STANDBY:
+        if (dischargeCommand)
+        {
+            next = WORKING_RAPID_DISCHARGE;
+        }
+        else if (ecuEnable && failureStatus != FAILURE_CRITICAL_ERROR)
+        {
+            next = WORKING_TORQUE_CONTROL;
+        }
+        break;
+
+    case WORKING_RAPID_DISCHARGE:
+        if (!dischargeCommand && dcVoltage < SIM_DISCHARGED_VOLTAGE)
+        {
+            next = WORKING_PRECHARGE;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if (next != workingStatus)
+    {
+        workingStatus = next;
+        statusChangeTime = now;
+    }
+}
+
+void MGECUSim::updatePlant(float dt)
+{
+    // 平滑コンデンサ電圧
+    if (workingStatus == WORKING_RAPID_DISCHARGE && !air)
+    {
+        dcVoltage -= dcVoltage * dt / SIM_DISCHARGE_TAU;
+    }
+    else if (air)
+    {
+        dcVoltage = batteryVoltage;
+    }
+    else if (tractiveSystem)
+    {
+        dcVoltage += (batteryVoltage - dcVoltage) * dt / SIM_PRECHARGE_TAU;
+    }
+    else
+    {
+        dcVoltage -= dcVoltage * dt / SIM_BLEED_TAU;
+    }
+
+    // トルク上限 (温度によるディレーティングと出力制限)
+    float derating = 1.0f - (inverterTemp - SIM_DERATING_START_TEMP) / (SIM_DERATING_END_TEMP - SIM_DERATING_START_TEMP);
+    float omega = fabsf(motorSpeed) * RPM_TO_RAD_S;
+    maxMotorTorque = SIM_MOTOR_MAX_TORQUE * clampf(derating, 0.0f, 1.0f);
+    if (omega > 1.0f && maxMotorTorque > SIM_MOTOR_MAX_POWER / omega)
+    {
+        maxMotorTorque = SIM_MOTOR_MAX_POWER / omega;
+    }
+
+    // トルクはトルク制御中だけ発生し, 1次遅れで指令に追従する
+    float target = 0;
+    if (workingStatus == WORKING_TORQUE_CONTROL && dcVoltage >= MINIMUM_INPUT_VOLTAGE)
+    {
+        target = clampf(requestTorque, -maxMotorTorque, maxMotorTorque);
+    }
+    torque += (target - torque) * dt / SIM_TORQUE_TAU;
+
+    // 回転数
+    float speed = motorSpeed * RPM_TO_RAD_S;
+    speed += (torque - SIM_MOTOR_FRICTION * speed) * dt / SIM_MOTOR_INERTIA;
+    motorSpeed = speed / RPM_TO_RAD_S;
+
+    // 温度
+    inverterTemp += (SIM_INVERTER_HEAT * torque * torque - (inverterTemp - SIM_AMBIENT_TEMP) / SIM_COOLING_TAU) * dt;
+    motorTemp += (SIM_MOTOR_HEAT * torque * torque - (motorTemp - SIM_AMBIENT_TEMP) / SIM_COOLING_TAU) * dt;
+}
+
+void MGECUSim::sendMgecu1(void)
+{
+    unsigned char buf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    unsigned char pwm = workingStatus == WORKING_TORQUE_CONTROL ? PWM_RUN : PWM_FREE_WHEEL;
+    unsigned char shutdownEnable = workingStatus != WORKING_TORQUE_CONTROL && fabsf(motorSpeed) < ECU_DISABLE_MOTOR_SPEED;
+
+    putBits(buf, 0, 1, shutdownEnable);
+    putBits(buf, 1, 2, pwm);
+    putBits(buf, 3, 3, workingStatus);
+    putBits(buf, 8, 16, (unsigned long)(clampf(motorSpeed, -14000.0f, 14000.0f) + 14000.0f));
+    putBits(buf, 24, 10, (unsigned long)(clampf(fabsf(torque) * SIM_PHASE_CURRENT_GAIN, 0.0f, 500.0f) * 2.0f));
+    putBits(buf, 34, 10, (unsigned long)clampf(dcVoltage, 0.0f, 1023.0f));
+    putBits(buf, 61, 3, failureStatus);
+
+    bus->write(MG_ECU1_ID, 8, buf);
+}
+
+void MGECUSim::sendMgecu2(void)
+{
+    unsigned char buf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+    putBits(buf, 0, 8, (unsigned long)clampf(inverterTemp + 40.0f, 0.0f, 250.0f));
+    putBits(buf, 8, 12, (unsigned long)(maxMotorTorque * 2.0f));
+    putBits(buf, 20, 12, (unsigned long)((1000.0f - maxMotorTorque) * 2.0f));
+    putBits(buf, 32, 8, (unsigned long)clampf(motorTemp + 40.0f, 0.0f, 250.0f));
+
+    bus->write(MG_ECU2_ID, 8, buf);
+}
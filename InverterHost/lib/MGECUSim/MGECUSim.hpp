@@ -0,0 +1,95 @@
+#ifndef _MGECUSIM_H_
+#define _MGECUSIM_H_
+
+#include "CanBus.hpp"
+#include "Inverter_dfs.hpp"
+#include "MGECUSim_dfs.hpp"
+
+/**
+ * MG-ECU (インバータ) のシミュレータ
+ * EV_ECU1 を受信し, MG_ECU1, MG_ECU2 を実機と同じ周期で送信する
+ *
+ * Working Status の遷移
+ *  INIT -(SIM_INIT_TIME)-> PRECHARGE
+ *  PRECHARGE -(ecuEnable = 1, 入力電圧 >= MINIMUM_INPUT_VOLTAGE)-> TORQUE_CONTROL
+ *  TORQUE_CONTROL -(ecuEnable = 0)-> STANDBY (ECU_DISABLE_MOTOR_SPEED 以上で OFF にすると Critical Error)
+ *  STANDBY -(ecuEnable = 1)-> TORQUE_CONTROL
+ *  STANDBY -(dischargeCommand = 1)-> RAPID_DISCHARGE -(放電完了, dischargeCommand = 0)-> PRECHARGE
+ *
+ * 時間は micros() で進むので, ホストの仮想時計を使えば実時間より速く動かせる
+ */
+class MGECUSim
+{
+private:
+    CanBus *bus;
+
+    // EV_ECU1 で受信した指令
+    unsigned char ecuEnable;
+    unsigned char dischargeCommand;
+    float requestTorque;
+    unsigned long lastCommandTime;    // EV_ECU1 を最後に受信した時刻[us]
+    unsigned short commandCount;
+
+    // 外部の回路
+    unsigned char tractiveSystem;     // TSMS (プリチャージ回路に電圧がかかる)
+    unsigned char air;                // AIR (バッテリーと直結)
+    float batteryVoltage;
+
+    // 状態
+    unsigned char workingStatus;
+    unsigned char failureStatus;
+    float dcVoltage;
+    float torque;
+    float motorSpeed;                 // [rpm]
+    float inverterTemp;
+    float motorTemp;
+    float maxMotorTorque;             // 温度と回転数で決まるトルク上限[Nm]
+
+    unsigned long startTime;
+    unsigned long lastStepTime;
+    unsigned long lastMgecu1Time;
+    unsigned long lastMgecu2Time;
+    unsigned long statusChangeTime;   // Working Status が最後に変わった時刻[us]
+
+    void receive(unsigned long now);
+    void updateStatus(unsigned long now);
+    void updatePlant(float dt);
+    void sendMgecu1(void);
+    void sendMgecu2(void);
+
+public:
+    MGECUSim(CanBus *bus, float batteryVoltage);
+
+    // バスを初期化し EV_ECU1 だけを受信する, 戻り値 : 0(成功) or 1(失敗)
+    unsigned char begin(void);
+
+    // TSMS (ON にするとプリチャージ抵抗経由で平滑コンデンサが充電される)
+    inline void setTractiveSystem(unsigned char on) { tractiveSystem = on; }
+
+    // AIR の状態 (Inverter の airFlag)
+    inline void setAir(unsigned char closed) { air = closed; }
+
+    /**
+     * @fn      step
+     *
+     * @brief   前回から micros() までの時間だけモデルを進め, 周期が来ていれば MG_ECU1, MG_ECU2 を送信する
+     *          受信した EV_ECU1 は時刻順に反映する
+     */
+    void step(void);
+
+    inline unsigned char getWorkingStatus(void) { return workingStatus; }
+    inline unsigned char getFailureStatus(void) { return failureStatus; }
+    inline unsigned char getEcuEnable(void) { return ecuEnable; }
+    inline unsigned char getDischargeCommand(void) { return dischargeCommand; }
+    inline float getRequestTorque(void) { return requestTorque; }
+    inline float getDCVoltage(void) { return dcVoltage; }
+    inline float getTorque(void) { return torque; }
+    inline float getMotorSpeed(void) { return motorSpeed; }
+    inline float getInverterTemp(void) { return inverterTemp; }
+    inline float getMaxMotorTorque(void) { return maxMotorTorque; }
+    inline unsigned long getLastCommandTime(void) { return lastCommandTime; }
+    inline unsigned short getCommandCount(void) { return commandCount; }
+    inline unsigned long getStatusChangeTime(void) { return statusChangeTime; }
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _MGECUSIM_DFS_H_
+#define _MGECUSIM_DFS_H_
+
+// 送信周期[us]
+#define SIM_MG_ECU1_PERIOD (10000)
+#define SIM_MG_ECU2_PERIOD (100000)
+
+// INIT から PRECHARGE へ移るまでの時間[us]
+#define SIM_INIT_TIME (200000)
+
+// 平滑コンデンサ
+#define SIM_PRECHARGE_TAU (0.3f)  // プリチャージ抵抗経由の充電時定数[s]
+#define SIM_BLEED_TAU (30.0f)     // 放電抵抗による自然放電の時定数[s]
+#define SIM_DISCHARGE_TAU (0.05f) // 急速放電の時定数[s]
+#define SIM_DISCHARGED_VOLTAGE (10.0f) // 急速放電完了とみなす電圧[V]
+
+// モータ
+#define SIM_MOTOR_INERTIA (0.05f)       // 慣性モーメント(車両分を含む)[kg m^2]
+#define SIM_MOTOR_FRICTION (0.002f)     // 粘性摩擦[Nm/(rad/s)]
+#define SIM_TORQUE_TAU (0.005f)         // トルク応答の時定数[s]
+#define SIM_MOTOR_MAX_TORQUE (60.0f)    // モータの最大トルク[Nm]
+#define SIM_MOTOR_MAX_POWER (30000.0f)  // 最大出力[W] (高回転ではトルクを P/ω に制限)
+#define SIM_PHASE_CURRENT_GAIN (4.0f)   // 相電流 / トルク [A/Nm]
+
+// 温度 (トルクの2乗に比例して発熱, 周囲温度へ冷却)
+#define SIM_AMBIENT_TEMP (25.0f)          // [deg C]
+#define SIM_INVERTER_HEAT (0.002f)        // [deg C/(s Nm^2)]
+#define SIM_MOTOR_HEAT (0.001f)           // [deg C/(s Nm^2)]
+#define SIM_COOLING_TAU (60.0f)           // [s]
+#define SIM_DERATING_START_TEMP (80.0f)   // インバータ温度がこれを超えるとトルクを制限する[deg C]
+#define SIM_DERATING_END_TEMP (120.0f)    // この温度でトルク上限が 0 になる[deg C]
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Inverter の受信/送信経路の throughput と latency を測定する
+ *
+ * MG-ECU 側のバスから MG_ECU1 を送信し, Inverter が読み取って EV_ECU1 を送り返し,
+ * MG-ECU 側で受信するまでを1往復として測る
+ *
+ * usage : program [loop | <ifname>] [往復回数]
+ *  loop   : Loopback_Bus (プロセス内, デフォルト)
+ *  ifname : SocketCAN_Bus (vcan0 など)
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include "Inverter.hpp"
+#include "Loopback_Bus.hpp"
+#include "SocketCAN_Bus.hpp"
+
+#define DEFAULT_ROUND_TRIP (100000)
+#define RX_TIMEOUT_US (100000)
+
+static unsigned char waitFrame(CanBus *bus, CAN_FRAME *frame)
+{
+    unsigned long start = micros();
+
+    while (!bus->read(frame))
+    {
+        if (micros() - start > RX_TIMEOUT_US)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = argc > 1 ? argv[1] : "loop";
+    const long roundTrip = argc > 2 ? atol(argv[2]) : DEFAULT_ROUND_TRIP;
+
+    Loopback_Bus loopInverter;
+    Loopback_Bus loopMgecu;
+    SocketCAN_Bus canInverter(ifname);
+    SocketCAN_Bus canMgecu(ifname);
+    CanBus *inverterBus;
+    CanBus *mgecuBus;
+
+    if (strcmp(ifname, "loop") == 0)
+    {
+        loopInverter.connect(&loopMgecu);
+        inverterBus = &loopInverter;
+        mgecuBus = &loopMgecu;
+    }
+    else
+    {
+        inverterBus = &canInverter;
+        mgecuBus = &canMgecu;
+    }
+
+    // 先に MG-ECU 側でインターフェースを確認する
+    const unsigned long mgecuIDs[] = {EV_ECU1_ID};
+    if (mgecuBus->begin(mgecuIDs, 1))
+    {
+        printf("%s : begin failed\n", ifname);
+        return 1;
+    }
+
+    Inverter inverter(inverterBus);
+    inverter.init();
+
+    if (inverter.getCanState() != CAN_STATE_READY)
+    {
+        printf("%s : inverter begin failed\n", ifname);
+        return 1;
+    }
+
+    // Working Status = Standby
+    unsigned char mgecu1Buf[8] = {WORKING_STANDBY << 3, 0, 0, 0, 0, 0, 0, 0};
+    CAN_FRAME frame;
+    unsigned long minLatency = 0xFFFFFFFF;
+    unsigned long maxLatency = 0;
+    unsigned long long sumLatency = 0;
+    long lost = 0;
+
+    unsigned long start = micros();
+
+    for (long i = 0; i < roundTrip; i++)
+    {
+        unsigned long t0 = micros();
+
+        mgecu1Buf[1] = (unsigned char)i;
+        mgecuBus->write(MG_ECU1_ID, 8, mgecu1Buf);
+
+        while (inverter.readMsgFromInverter(0) == 0)
+        {
+            if (micros() - t0 > RX_TIMEOUT_US)
+            {
+                break;
+            }
+        }
+
+        inverter.sendMsgToInverter(0);
+
+        if (waitFrame(mgecuBus, &frame))
+        {
+            lost++;
+            continue;
+        }
+
+        unsigned long latency = micros() - t0;
+        sumLatency += latency;
+        minLatency = latency < minLatency ? latency : minLatency;
+        maxLatency = latency > maxLatency ? latency : maxLatency;
+    }
+
+    unsigned long elapsed = micros() - start;
+    long received = roundTrip - lost;
+
+    printf("bus            : %s\n", ifname);
+    printf("round trips    : %ld (lost %ld)\n", roundTrip, lost);
+    printf("frames/s       : %.0f\n", elapsed ? 2.0 * received * 1e6 / elapsed : 0.0);
+    printf("latency [us]   : min %lu avg %.2f max %lu\n",
+           received ? minLatency : 0, received ? (double)sumLatency / received : 0.0, maxLatency);
+    printf("MG_ECU1 rx     : %u\n", inverter.getReceivedCount(MG_ECU1_ID));
+    printf("rx max buffered: %u overflow %u\n", inverter.getRxMaxCount(), inverter.getRxOverflowCount());
+
+    return 0;
+}
@@ -0,0 +1,367 @@
+/**
+ * Signal.hpp のシグナル読み書きを確認し, 以前のビットフィールド共用体と速度を比べる
+ *
+ * 1. ランダムな Massage で, 全シグナルの get をビット単位の参照実装と比べる
+ * 2. set が他のシグナルのビットを変えないことを確認する
+ * 3. 以前の共用体 (packed, AVR と同じ配置) の読み出しを参照実装と比べる
+ *    MG_ECU1 の failureStatus は reserve1 が 19bit あるので共用体だと bit 63 以降にずれていた
+ * 4. MG_ECU1 の全シグナルの読み出し, EV_ECU1 の書き込みを共用体と Signal で時間を測る
+ *    ホストPC (x86-64, -O2) の例 : 読み出し 共用体 2.1~3.0 ns, Signal 1.9~3.1 ns
+ *                                   書き込み 共用体 2.1~2.5 ns, Signal 2.7~2.8 ns
+ *
+ * usage : program [Massage の数]
+ * 戻り値 : Signal が参照実装と一致しなければ 1
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EV_ECU1.hpp"
+#include "MG_ECU1.hpp"
+#include "MG_ECU2.hpp"
+
+#define DEFAULT_MSG_NUM (100000)
+#define BENCH_BUF_NUM (1024)
+#define BENCH_REPEAT (20000)
+
+//-------------------------------------------------------
+//  以前のビットフィールド共用体 (比較用)
+//-------------------------------------------------------
+union LEGACY_EV_ECU1
+{
+    unsigned char msgs[8];
+    struct __attribute__((packed))
+    {
+        unsigned char ecuEnable : 1;
+        unsigned char dischargeCommand : 1;
+        unsigned char reserve0 : 6;
+        unsigned short requestTorque : 12;
+        unsigned char reserve1 : 4;
+    };
+};
+
+union LEGACY_MG_ECU1
+{
+    unsigned char msgs[8];
+    struct __attribute__((packed))
+    {
+        unsigned char shutdownEnable : 1;
+        unsigned char PWM : 2;
+        unsigned char workingStatus : 3;
+        unsigned char reserve0 : 2;
+        unsigned short motorSpeed : 16;
+        unsigned short motorPhaseCurrent : 10;
+        unsigned short inputDCVoltage : 10;
+        unsigned long reserve1 : 19;
+        unsigned char failureStatus : 3;
+    };
+};
+
+union LEGACY_MG_ECU2
+{
+    unsigned char msgs[8];
+    struct __attribute__((packed))
+    {
+        unsigned char inverterTemp : 8;
+        unsigned short maxAvailableMotorTorque : 12;
+        unsigned short maxAvailableGenerateTorque : 12;
+        unsigned char motorTemp : 8;
+    };
+};
+
+union LEGACY_THM_DATA
+{
+    unsigned char data[8];
+    struct __attribute__((packed))
+    {
+        unsigned short thm1 : 10;
+        unsigned short thm2 : 10;
+        unsigned short thm3 : 10;
+        unsigned short thm4 : 10;
+        unsigned short thm5 : 10;
+        unsigned short thm6 : 10;
+        unsigned char received : 4;
+    };
+};
+
+// AMS_Temp_Master/AMS_Temp_slave のシグナルと同じ配置
+typedef Signal<0, 8> AvrTempSignal;
+typedef Signal<8, 8> MaxTempSignal;
+typedef Signal<16, 8> MinTempSignal;
+typedef Signal<0, 10> Thm1Signal;
+typedef Signal<10, 10> Thm2Signal;
+typedef Signal<20, 10> Thm3Signal;
+typedef Signal<30, 10> Thm4Signal;
+typedef Signal<40, 10> Thm5Signal;
+typedef Signal<50, 10> Thm6Signal;
+typedef Signal<60, 4> ReceivedSignal;
+
+// SIGNAL_MOTOROLA の確認用 (今のところ使っている Massage は無い)
+typedef Signal<7, 16, SIGNAL_MOTOROLA> MotorolaByteAligned;
+typedef Signal<13, 12, SIGNAL_MOTOROLA> MotorolaUnaligned;
+typedef Signal<35, 27, SIGNAL_MOTOROLA> MotorolaLong;
+
+//-------------------------------------------------------
+//  1bit ずつ読み書きする参照実装
+//-------------------------------------------------------
+static unsigned long refGet(const unsigned char *buf, unsigned char start, unsigned char length, unsigned char order)
+{
+    unsigned long value = 0;
+    unsigned char bit = start;
+
+    for (unsigned char i = 0; i < length; i++)
+    {
+        if (order == SIGNAL_INTEL)
+        {
+            value |= (unsigned long)((buf[(start + i) / 8] >> ((start + i) % 8)) & 1) << i;
+        }
+        else
+        {
+            // 最上位ビットから順に, バイトの bit0 の次は次のバイトの bit7
+            value = (value << 1) | ((buf[bit / 8] >> (bit % 8)) & 1);
+            bit = bit % 8 == 0 ? bit + 15 : bit - 1;
+        }
+    }
+
+    return value;
+}
+
+static void refSet(unsigned char *buf, unsigned char start, unsigned char length, unsigned char order, unsigned long value)
+{
+    unsigned char bit = start;
+
+    for (unsigned char i = 0; i < length; i++)
+    {
+        unsigned char pos = order == SIGNAL_INTEL ? start + i : bit;
+        unsigned char v = order == SIGNAL_INTEL ? (value >> i) & 1 : (value >> (length - 1 - i)) & 1;
+
+        buf[pos / 8] = (buf[pos / 8] & ~(1 << (pos % 8))) | (v << (pos % 8));
+        bit = bit % 8 == 0 ? bit + 15 : bit - 1;
+    }
+}
+
+//-------------------------------------------------------
+//  シグナルの一覧
+//-------------------------------------------------------
+typedef unsigned long (*GetFunc)(const unsigned char *buf);
+typedef void (*SetFunc)(unsigned char *buf, unsigned long value);
+
+template <class S>
+static unsigned long signalGet(const unsigned char *buf) { return S::get(buf); }
+
+template <class S>
+static void signalSet(unsigned char *buf, unsigned long value) { S::set(buf, value); }
+
+struct SIGNAL_ENTRY
+{
+    const char *name;
+    unsigned char start;
+    unsigned char length;
+    unsigned char order;
+    GetFunc get;
+    SetFunc set;
+    GetFunc legacy; // 共用体での読み出し (無いときは nullptr)
+};
+
+#define LEGACY_GET(type, field) [](const unsigned char *buf) -> unsigned long { type u = type(); memcpy(u.msgs, buf, 8); return u.field; }
+#define LEGACY_THM_GET(field) [](const unsigned char *buf) -> unsigned long { LEGACY_THM_DATA u = LEGACY_THM_DATA(); memcpy(u.data, buf, 8); return u.field; }
+#define ENTRY(name, start, length, order, S, legacy) {name, start, length, order, signalGet<S>, signalSet<S>, legacy}
+
+static const SIGNAL_ENTRY SIGNALS[] = {
+    ENTRY("EV_ECU1 ecuEnable", 0, 1, SIGNAL_INTEL, EV_ECU1::EcuEnable, LEGACY_GET(LEGACY_EV_ECU1, ecuEnable)),
+    ENTRY("EV_ECU1 dischargeCommand", 1, 1, SIGNAL_INTEL, EV_ECU1::DischargeCommand, LEGACY_GET(LEGACY_EV_ECU1, dischargeCommand)),
+    ENTRY("EV_ECU1 requestTorque", 8, 12, SIGNAL_INTEL, EV_ECU1::RequestTorque, LEGACY_GET(LEGACY_EV_ECU1, requestTorque)),
+    ENTRY("MG_ECU1 shutdownEnable", 0, 1, SIGNAL_INTEL, MG_ECU1::ShutdownEnable, LEGACY_GET(LEGACY_MG_ECU1, shutdownEnable)),
+    ENTRY("MG_ECU1 PWM", 1, 2, SIGNAL_INTEL, MG_ECU1::PWMState, LEGACY_GET(LEGACY_MG_ECU1, PWM)),
+    ENTRY("MG_ECU1 workingStatus", 3, 3, SIGNAL_INTEL, MG_ECU1::WorkingStatus, LEGACY_GET(LEGACY_MG_ECU1, workingStatus)),
+    ENTRY("MG_ECU1 motorSpeed", 8, 16, SIGNAL_INTEL, MG_ECU1::MotorSpeed, LEGACY_GET(LEGACY_MG_ECU1, motorSpeed)),
+    ENTRY("MG_ECU1 motorPhaseCurrent", 24, 10, SIGNAL_INTEL, MG_ECU1::MotorPhaseCurrent, LEGACY_GET(LEGACY_MG_ECU1, motorPhaseCurrent)),
+    ENTRY("MG_ECU1 inputDCVoltage", 34, 10, SIGNAL_INTEL, MG_ECU1::InputDCVoltage, LEGACY_GET(LEGACY_MG_ECU1, inputDCVoltage)),
+    ENTRY("MG_ECU1 failureStatus", 61, 3, SIGNAL_INTEL, MG_ECU1::FailureStatus, LEGACY_GET(LEGACY_MG_ECU1, failureStatus)),
+    ENTRY("MG_ECU2 inverterTemp", 0, 8, SIGNAL_INTEL, MG_ECU2::InverterTemp, LEGACY_GET(LEGACY_MG_ECU2, inverterTemp)),
+    ENTRY("MG_ECU2 maxMotorTorque", 8, 12, SIGNAL_INTEL, MG_ECU2::MaxAvailableMotorTorque, LEGACY_GET(LEGACY_MG_ECU2, maxAvailableMotorTorque)),
+    ENTRY("MG_ECU2 maxGenerateTorque", 20, 12, SIGNAL_INTEL, MG_ECU2::MaxAvailableGenerateTorque, LEGACY_GET(LEGACY_MG_ECU2, maxAvailableGenerateTorque)),
+    ENTRY("MG_ECU2 motorTemp", 32, 8, SIGNAL_INTEL, MG_ECU2::MotorTemp, LEGACY_GET(LEGACY_MG_ECU2, motorTemp)),
+    ENTRY("CAN_Temp avrTemp", 0, 8, SIGNAL_INTEL, AvrTempSignal, nullptr),
+    ENTRY("CAN_Temp maxTemp", 8, 8, SIGNAL_INTEL, MaxTempSignal, nullptr),
+    ENTRY("CAN_Temp minTemp", 16, 8, SIGNAL_INTEL, MinTempSignal, nullptr),
+    ENTRY("THM_DATA thm1", 0, 10, SIGNAL_INTEL, Thm1Signal, LEGACY_THM_GET(thm1)),
+    ENTRY("THM_DATA thm2", 10, 10, SIGNAL_INTEL, Thm2Signal, LEGACY_THM_GET(thm2)),
+    ENTRY("THM_DATA thm3", 20, 10, SIGNAL_INTEL, Thm3Signal, LEGACY_THM_GET(thm3)),
+    ENTRY("THM_DATA thm4", 30, 10, SIGNAL_INTEL, Thm4Signal, LEGACY_THM_GET(thm4)),
+    ENTRY("THM_DATA thm5", 40, 10, SIGNAL_INTEL, Thm5Signal, LEGACY_THM_GET(thm5)),
+    ENTRY("THM_DATA thm6", 50, 10, SIGNAL_INTEL, Thm6Signal, LEGACY_THM_GET(thm6)),
+    ENTRY("THM_DATA received", 60, 4, SIGNAL_INTEL, ReceivedSignal, LEGACY_THM_GET(received)),
+    ENTRY("Motorola 7|16", 7, 16, SIGNAL_MOTOROLA, MotorolaByteAligned, nullptr),
+    ENTRY("Motorola 13|12", 13, 12, SIGNAL_MOTOROLA, MotorolaUnaligned, nullptr),
+    ENTRY("Motorola 35|27", 35, 27, SIGNAL_MOTOROLA, MotorolaLong, nullptr),
+};
+
+#define SIGNAL_NUM (sizeof(SIGNALS) / sizeof(SIGNALS[0]))
+
+static void randomMsg(unsigned char *buf)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        buf[i] = rand() & 0xFF;
+    }
+}
+
+//-------------------------------------------------------
+//  速度の比較
+//-------------------------------------------------------
+static unsigned char benchBuf[BENCH_BUF_NUM][8];
+static volatile unsigned long sink;
+
+static double benchLegacyDecode(void)
+{
+    unsigned long start = micros();
+    unsigned long sum = 0;
+
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (int i = 0; i < BENCH_BUF_NUM; i++)
+        {
+            const LEGACY_MG_ECU1 *u = (const LEGACY_MG_ECU1 *)benchBuf[i];
+            sum += u->shutdownEnable + u->PWM + u->workingStatus + u->motorSpeed +
+                   u->motorPhaseCurrent + u->inputDCVoltage + u->failureStatus;
+        }
+        sink = sum;
+    }
+
+    return (double)(micros() - start) * 1000.0 / ((double)BENCH_REPEAT * BENCH_BUF_NUM);
+}
+
+static double benchSignalDecode(void)
+{
+    unsigned long start = micros();
+    unsigned long sum = 0;
+
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (int i = 0; i < BENCH_BUF_NUM; i++)
+        {
+            const unsigned char *buf = benchBuf[i];
+            sum += MG_ECU1::ShutdownEnable::get(buf) + MG_ECU1::PWMState::get(buf) + MG_ECU1::WorkingStatus::get(buf) +
+                   MG_ECU1::MotorSpeed::get(buf) + MG_ECU1::MotorPhaseCurrent::get(buf) +
+                   MG_ECU1::InputDCVoltage::get(buf) + MG_ECU1::FailureStatus::get(buf);
+        }
+        sink = sum;
+    }
+
+    return (double)(micros() - start) * 1000.0 / ((double)BENCH_REPEAT * BENCH_BUF_NUM);
+}
+
+static double benchLegacyEncode(void)
+{
+    unsigned long start = micros();
+
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (int i = 0; i < BENCH_BUF_NUM; i++)
+        {
+            LEGACY_EV_ECU1 *u = (LEGACY_EV_ECU1 *)benchBuf[i];
+            u->ecuEnable = r;
+            u->dischargeCommand = i;
+            u->requestTorque = r + i;
+        }
+        sink = benchBuf[r % BENCH_BUF_NUM][1];
+    }
+
+    return (double)(micros() - start) * 1000.0 / ((double)BENCH_REPEAT * BENCH_BUF_NUM);
+}
+
+static double benchSignalEncode(void)
+{
+    unsigned long start = micros();
+
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (int i = 0; i < BENCH_BUF_NUM; i++)
+        {
+            unsigned char *buf = benchBuf[i];
+            EV_ECU1::EcuEnable::set(buf, r);
+            EV_ECU1::DischargeCommand::set(buf, i);
+            EV_ECU1::RequestTorque::set(buf, r + i);
+        }
+        sink = benchBuf[r % BENCH_BUF_NUM][1];
+    }
+
+    return (double)(micros() - start) * 1000.0 / ((double)BENCH_REPEAT * BENCH_BUF_NUM);
+}
+
+int main(int argc, char **argv)
+{
+    const long msgNum = argc > 1 ? atol(argv[1]) : DEFAULT_MSG_NUM;
+    unsigned long signalError[SIGNAL_NUM] = {0};
+    unsigned long legacyDiff[SIGNAL_NUM] = {0};
+    unsigned char failed = 0;
+
+    srand(1);
+
+    for (long n = 0; n < msgNum; n++)
+    {
+        unsigned char buf[8];
+
+        randomMsg(buf);
+
+        for (unsigned int s = 0; s < SIGNAL_NUM; s++)
+        {
+            const SIGNAL_ENTRY *e = &SIGNALS[s];
+            const unsigned long ref = refGet(buf, e->start, e->length, e->order);
+            const unsigned long value = ((unsigned long)rand() << 16 ^ rand()) & (e->length == 32 ? 0xFFFFFFFFUL : (1UL << e->length) - 1);
+            unsigned char actual[8], expected[8];
+
+            if (e->get(buf) != ref)
+            {
+                signalError[s]++;
+            }
+
+            if (e->legacy != nullptr && e->legacy(buf) != ref)
+            {
+                legacyDiff[s]++;
+            }
+
+            // 書いたシグナル以外のビットは変わらないこと
+            memcpy(actual, buf, 8);
+            memcpy(expected, buf, 8);
+            e->set(actual, value);
+            refSet(expected, e->start, e->length, e->order, value);
+            if (memcmp(actual, expected, 8) != 0 || e->get(actual) != value)
+            {
+                signalError[s]++;
+            }
+        }
+    }
+
+    printf("%-28s %6s %6s %12s %12s\n", "signal", "start", "length", "Signal error", "union diff");
+
+    for (unsigned int s = 0; s < SIGNAL_NUM; s++)
+    {
+        const SIGNAL_ENTRY *e = &SIGNALS[s];
+
+        printf("%-28s %6d %6d %12lu ", e->name, e->start, e->length, signalError[s]);
+        if (e->legacy != nullptr)
+        {
+            printf("%12lu\n", legacyDiff[s]);
+        }
+        else
+        {
+            printf("%12s\n", "-");
+        }
+
+        failed |= signalError[s] != 0;
+    }
+
+    for (int i = 0; i < BENCH_BUF_NUM; i++)
+    {
+        randomMsg(benchBuf[i]);
+    }
+
+    printf("\ndecode MG_ECU1 (7 signals) : union %.2f ns, Signal %.2f ns\n", benchLegacyDecode(), benchSignalDecode());
+    printf("encode EV_ECU1 (3 signals) : union %.2f ns, Signal %.2f ns\n", benchLegacyEncode(), benchSignalEncode());
+
+    printf("\n%s\n", failed ? "FAILED" : "OK");
+
+    return failed;
+}
@@ -0,0 +1,194 @@
+/**
+ * Debouncer (ビット演算でまとめて判定) が入力ごとの Switch と同じ結果になることを確認し, 速度と RAM を比べる
+ *
+ * 入力ごとにチャタリングを含むランダムな波形を作り, 同じ値を Switch (入力の数だけ) と
+ * Debouncer<unsigned char / unsigned short / unsigned int> (8 / 16 / 32 入力) に入れる
+ * (AVR の 32 入力は unsigned long, ホストPCの unsigned long は 64bit なので unsigned int で試す)
+ * taskControl と同じく, フラグをランダムに resetFlag / setFlag して, 毎回全ての入力のフラグを比べる
+ * Debouncer の getRising / getFalling が getState の変化と一致することも確認する
+ *
+ * usage : program [ステップ数] [乱数シード]
+ * 戻り値 : 1つでも一致しなければ 1
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "Debouncer.hpp"
+#include "Switch.hpp"
+
+#define DEFAULT_STEP (1000000)
+#define TOGGLE_RATE (200)   // 1/TOGGLE_RATE の確率で入力の本当の値が変わる
+#define BOUNCE_STEPS (4)    // 変わった後にチャタリングが続く回数
+#define GLITCH_RATE (500)   // 1/GLITCH_RATE の確率で1回だけ反転する
+#define RESET_RATE (50)     // 1/RESET_RATE の確率でフラグをリセットする
+#define SET_RATE (2000)     // 1/SET_RATE の確率でフラグをセットする (CAN タイムアウトなど)
+#define BENCH_REPEAT (20)
+
+struct INPUT_SIGNAL
+{
+    unsigned char level;  // 本当の値
+    unsigned char bounce; // 残りのチャタリングの回数
+};
+
+static volatile unsigned long sink;
+
+static unsigned char nextSample(INPUT_SIGNAL *input)
+{
+    if (rand() % TOGGLE_RATE == 0)
+    {
+        input->level ^= 1;
+        input->bounce = BOUNCE_STEPS;
+    }
+
+    if (input->bounce > 0)
+    {
+        input->bounce--;
+        return rand() & 1;
+    }
+
+    return rand() % GLITCH_RATE == 0 ? input->level ^ 1 : input->level;
+}
+
+/**
+ * Bits の幅の入力を steps 回比べる
+ * 戻り値 : 一致しなかった回数
+ */
+template <class Bits>
+static unsigned long compare(const char *name, long steps)
+{
+    const unsigned char n = sizeof(Bits) * 8;
+    std::vector<Switch> switches(n);
+    std::vector<INPUT_SIGNAL> inputs(n, INPUT_SIGNAL{0, 0});
+    Debouncer<Bits> debouncer;
+    unsigned long mismatch = 0, rising = 0, falling = 0;
+    Bits lastState = 0;
+
+    for (long step = 0; step < steps; step++)
+    {
+        Bits sample = 0;
+
+        for (unsigned char i = 0; i < n; i++)
+        {
+            const unsigned char v = nextSample(&inputs[i]);
+
+            sample |= (Bits)v << i;
+            switches[i].updateState(v);
+        }
+        debouncer.update(sample);
+
+        // 状態の変化と立ち上がり/立ち下がりが一致するか
+        const Bits state = debouncer.getState();
+        if (debouncer.getRising() != (Bits)(state & ~lastState) || debouncer.getFalling() != (Bits)(lastState & ~state))
+        {
+            mismatch++;
+        }
+        rising += __builtin_popcountl(debouncer.getRising());
+        falling += __builtin_popcountl(debouncer.getFalling());
+        lastState = state;
+
+        for (unsigned char i = 0; i < n; i++)
+        {
+            const Bits mask = (Bits)1 << i;
+
+            if (switches[i].getSWFlag() != debouncer.getFlag(mask))
+            {
+                mismatch++;
+            }
+
+            if (rand() % RESET_RATE == 0)
+            {
+                switches[i].resetFlag();
+                debouncer.resetFlag(mask);
+            }
+            else if (rand() % SET_RATE == 0)
+            {
+                switches[i].setFlag();
+                debouncer.setFlag(mask);
+            }
+        }
+    }
+
+    printf("%-6s %2u inputs : %s (%lu rising, %lu falling edges, %lu mismatches)\n", name, n,
+           mismatch == 0 ? "OK" : "NG", rising, falling, mismatch);
+
+    return mismatch;
+}
+
+static double nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * 入力 n 本の1回分の更新の時間 [ns]
+ * 入力の値は前もって作っておき, 作る時間は含めない
+ */
+template <class Bits>
+static void bench(const char *name, long steps)
+{
+    const unsigned char n = sizeof(Bits) * 8;
+    std::vector<Bits> samples(steps);
+    std::vector<Switch> switches(n);
+    Debouncer<Bits> debouncer;
+
+    for (long i = 0; i < steps; i++)
+    {
+        samples[i] = (Bits)(((unsigned long)rand() << 16) ^ rand());
+    }
+
+    double t0 = nowNanos();
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (long i = 0; i < steps; i++)
+        {
+            for (unsigned char b = 0; b < n; b++)
+            {
+                switches[b].updateState(samples[i] >> b);
+            }
+        }
+        for (unsigned char b = 0; b < n; b++)
+        {
+            sink += switches[b].getSWFlag();
+        }
+    }
+    const double switchTime = (nowNanos() - t0) / ((double)BENCH_REPEAT * steps);
+
+    t0 = nowNanos();
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        for (long i = 0; i < steps; i++)
+        {
+            debouncer.update(samples[i]);
+        }
+        sink += debouncer.getFlags();
+    }
+    const double debouncerTime = (nowNanos() - t0) / ((double)BENCH_REPEAT * steps);
+
+    printf("%-6s %2u inputs : Switch %7.2f ns %4u bytes, Debouncer %6.2f ns %3u bytes\n", name, n,
+           switchTime, (unsigned int)(n * sizeof(Switch)), debouncerTime, (unsigned int)sizeof(Debouncer<Bits>));
+}
+
+int main(int argc, char **argv)
+{
+    const long steps = argc > 1 ? atol(argv[1]) : DEFAULT_STEP;
+    const unsigned int seed = argc > 2 ? (unsigned int)atol(argv[2]) : 1;
+    unsigned long mismatch = 0;
+
+    srand(seed);
+
+    printf("equivalence to Switch (%ld steps, seed %u)\n", steps, seed);
+    mismatch += compare<unsigned char>("8 bit", steps);
+    mismatch += compare<unsigned short>("16 bit", steps);
+    mismatch += compare<unsigned int>("32 bit", steps);
+
+    printf("\nupdate time per step (host PC), RAM\n");
+    bench<unsigned char>("8 bit", steps);
+    bench<unsigned short>("16 bit", steps);
+    bench<unsigned int>("32 bit", steps);
+
+    return mismatch == 0 ? 0 : 1;
+}
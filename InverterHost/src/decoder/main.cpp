@@ -0,0 +1,825 @@
+/**
+ * InverterController_ver5 のテレメトリを CSV に記録し, 端末に最新値とグラフを表示する
+ *
+ * バイナリフレーム (Telemetry, 'b') とラベル付きテキスト (テキストモード, 't') のどちらも読める
+ * 1サンプルを CSV の1行にし, 読めなかった項目は空欄にする
+ *
+ * usage : program [-b baud] [-o out.csv] [-m b|t] [-q] [シリアルポート | ファイル | -]
+ *  -b : シリアルポートのボーレート (デフォルト 1000000)
+ *  -o : CSV の出力先 ("-" で標準出力, このときは端末表示をしない)
+ *  -m : 開いた後にテレメトリの形式を切り替えるコマンドを送る
+ *  -q : 端末表示をしない (終了時に件数だけ表示する)
+ *  引数なし, または "-" のときは標準入力から読む
+ *  例) program -o log.csv /dev/ttyACM0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "Telemetry.hpp"
+#include "EV_ECU1.hpp"
+#include "MG_ECU1.hpp"
+#include "MG_ECU2.hpp"
+#include "Inverter_dfs.hpp"
+#include "Accel_dfs.hpp"
+
+#define DEFAULT_BAUD (1000000)
+#define READ_BUFFER_SIZE (65536)
+#define CSV_BUFFER_SIZE (1 << 20)
+#define LINE_MAX_LEN (128)
+#define VIEW_PERIOD_MS (100)
+#define HISTORY_LEN (64)
+
+// CSV の列 (FIELD_NAME と同じ順番)
+enum Field
+{
+    F_TICK,
+    F_AIR,
+    F_TORQUE_CONTROL,
+    F_SHUTDOWN,
+    F_DRIVE,
+    F_ACCEL1,
+    F_ACCEL2,
+    F_DEVIATION,
+    F_TORQUE,
+    F_MGECU1_PERIOD,
+    F_RX_MAX,
+    F_RX_OVERFLOW,
+    F_CTRL_OVERFLOW,
+    F_RX_REJECTED,
+    F_TX_MAX_PERIOD,
+    F_TX_JITTER,
+    F_TX_EVENT,
+    F_BUS_LOAD,
+    F_DROPPED,
+    F_CAN_READY,
+    F_CAN_REINIT,
+    F_CAN_BUS_OFF,
+    F_CAN_INIT_FAIL,
+    F_CAN_INIT_MAX,
+    F_MGECU1_TIMEOUT,
+    F_MGECU2_TIMEOUT,
+    F_ECU_ENABLE,
+    F_DISCHARGE,
+    F_TORQUE_REQUEST,
+    F_WORKING_STATUS,
+    F_MOTOR_SPEED,
+    F_PHASE_CURRENT,
+    F_DC_VOLTAGE,
+    F_FAILURE_STATUS,
+    F_INVERTER_TEMP,
+    F_MAX_MOTOR_TORQUE,
+    F_MAX_GENERATE_TORQUE,
+    F_MOTOR_TEMP,
+    FIELD_NUM
+};
+
+static const char *const FIELD_NAME[FIELD_NUM] = {
+    "tick", "airFlag", "torqueControlFlag", "shutdownFlag", "driveFlag",
+    "accel1", "accel2", "deviation", "torque", "mgecu1PeriodUs",
+    "rxMaxBuffered", "rxOverflow", "ctrlOverflow", "rxRejected",
+    "txMaxPeriod", "txJitter", "txEvent", "busLoad", "telemetryDropped",
+    "canReady", "canReinit", "canBusOff", "canInitFail", "canInitMaxMs", "mgecu1Timeout", "mgecu2Timeout",
+    "ecuEnable", "dischargeCommand", "torqueRequest",
+    "workingStatus", "motorSpeed", "motorPhaseCurrent", "inputDCVoltage", "failureStatus",
+    "inverterTemp", "maxMotoringTorque", "maxGeneratingTorque", "motorTemp"};
+
+/**
+ * テキストモードの行のラベル
+ * "label : value" と "label value" の両方の形式がある
+ */
+typedef struct
+{
+    const char *label;
+    unsigned char field;
+} TEXT_LABEL;
+
+static const TEXT_LABEL TEXT_LABELS[] = {
+    {"tick", F_TICK},
+    {"airFlag", F_AIR},
+    {"torqueControlFlag", F_TORQUE_CONTROL},
+    {"shutdownFlag", F_SHUTDOWN},
+    {"driveFlag", F_DRIVE},
+    {"Accel1", F_ACCEL1},
+    {"Accel2", F_ACCEL2},
+    {"Deviation", F_DEVIATION},
+    {"Torque", F_TORQUE},
+    {"MGECU1 MSG Period [us]", F_MGECU1_PERIOD},
+    {"CAN RX Max Buffered", F_RX_MAX},
+    {"CAN RX Overflow", F_RX_OVERFLOW},
+    {"CAN Controller Overflow", F_CTRL_OVERFLOW},
+    {"CAN RX Rejected", F_RX_REJECTED},
+    {"CAN TX Period max", F_TX_MAX_PERIOD},
+    {"CAN TX Jitter", F_TX_JITTER},
+    {"CAN TX Event", F_TX_EVENT},
+    {"CAN Bus Load [0.1%]", F_BUS_LOAD},
+    {"Telemetry Dropped", F_DROPPED},
+    {"CAN Ready", F_CAN_READY},
+    {"CAN Reinit", F_CAN_REINIT},
+    {"CAN Bus Off", F_CAN_BUS_OFF},
+    {"CAN Init Fail", F_CAN_INIT_FAIL},
+    {"CAN Init max [ms]", F_CAN_INIT_MAX},
+    {"MGECU1 Timeout", F_MGECU1_TIMEOUT},
+    {"MGECU2 Timeout", F_MGECU2_TIMEOUT},
+    {"Torque Request", F_TORQUE_REQUEST},
+    {"Working Status", F_WORKING_STATUS},
+    {"Motor Speed", F_MOTOR_SPEED},
+    {"Motor Phase Current", F_PHASE_CURRENT},
+    {"Input DC Voltage", F_DC_VOLTAGE},
+    {"Failure Status", F_FAILURE_STATUS},
+    {"Inverter Temperature", F_INVERTER_TEMP},
+    {"Maximum Available Motoring Torque", F_MAX_MOTOR_TORQUE},
+    {"Maximum Available Generating Torque", F_MAX_GENERATE_TORQUE},
+    {"Motor Temperature", F_MOTOR_TEMP},
+};
+
+#define TEXT_LABEL_NUM (sizeof(TEXT_LABELS) / sizeof(TEXT_LABELS[0]))
+
+// CSV の1行分
+typedef struct
+{
+    double value[FIELD_NUM];
+    unsigned char valid[FIELD_NUM];
+    char source; // 'b' : バイナリ, 't' : テキスト
+    int seq;     // バイナリフレームのシーケンス番号 (テキストは -1)
+} RECORD;
+
+typedef struct
+{
+    unsigned long frames;
+    unsigned long errors;
+    unsigned long lost;
+    unsigned long textRecords;
+    unsigned long long bytes;
+} COUNTS;
+
+static RECORD textRecord;
+static RECORD latest;
+static COUNTS counts;
+static FILE *csv = nullptr;
+static unsigned char quiet = 0;
+
+static double history[3][HISTORY_LEN];
+static unsigned char historyField[3] = {F_TORQUE, F_MOTOR_SPEED, F_DC_VOLTAGE};
+static unsigned short historyHead = 0;
+static unsigned short historyCount = 0;
+
+static const char *workingStatusName(unsigned char ws)
+{
+    switch (ws)
+    {
+    case WORKING_INIT:
+        return "init";
+    case WORKING_PRECHARGE:
+        return "precharge";
+    case WORKING_STANDBY:
+        return "standby";
+    case WORKING_TORQUE_CONTROL:
+        return "torque control";
+    case WORKING_RAPID_DISCHARGE:
+        return "rapid discharge";
+    default:
+        return "error";
+    }
+}
+
+static const char *failureStatusName(unsigned char fs)
+{
+    switch (fs)
+    {
+    case FAILURE_NO_ERROR:
+        return "No Error";
+    case FAILURE_DERATING:
+        return "Derating";
+    case FAILURE_WARNING:
+        return "Warning";
+    case FAILURE_ERROR:
+        return "Error";
+    case FAILURE_CRITICAL_ERROR:
+        return "Critical Error";
+    default:
+        return "error";
+    }
+}
+
+static unsigned long long nowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void clearRecord(RECORD *record, char source, int seq)
+{
+    memset(record->valid, 0, sizeof(record->valid));
+    record->source = source;
+    record->seq = seq;
+}
+
+static void setField(RECORD *record, unsigned char field, double value)
+{
+    record->value[field] = value;
+    record->valid[field] = 1;
+}
+
+static void writeCsvHeader(void)
+{
+    fputs("source,seq", csv);
+    for (int i = 0; i < FIELD_NUM; i++)
+    {
+        fputc(',', csv);
+        fputs(FIELD_NAME[i], csv);
+    }
+    fputc('\n', csv);
+}
+
+/**
+ * 1サンプルを CSV に書き, 端末表示用の最新値とグラフの履歴を更新する
+ */
+static void emitRecord(const RECORD *record)
+{
+    if (csv != nullptr)
+    {
+        if (record->seq >= 0)
+        {
+            fprintf(csv, "%c,%d", record->source, record->seq);
+        }
+        else
+        {
+            fprintf(csv, "%c,", record->source);
+        }
+
+        for (int i = 0; i < FIELD_NUM; i++)
+        {
+            if (record->valid[i])
+            {
+                fprintf(csv, ",%.6g", record->value[i]);
+            }
+            else
+            {
+                fputc(',', csv);
+            }
+        }
+        fputc('\n', csv);
+    }
+
+    latest.source = record->source;
+    latest.seq = record->seq;
+    for (int i = 0; i < FIELD_NUM; i++)
+    {
+        if (record->valid[i])
+        {
+            latest.value[i] = record->value[i];
+            latest.valid[i] = 1;
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        history[i][historyHead] = record->valid[historyField[i]] ? record->value[historyField[i]] : NAN;
+    }
+    historyHead = (historyHead + 1) % HISTORY_LEN;
+    if (historyCount < HISTORY_LEN)
+    {
+        historyCount++;
+    }
+}
+
+static void flushTextRecord(void)
+{
+    for (int i = 0; i < FIELD_NUM; i++)
+    {
+        if (textRecord.valid[i])
+        {
+            emitRecord(&textRecord);
+            counts.textRecords++;
+            break;
+        }
+    }
+    clearRecord(&textRecord, 't', -1);
+}
+
+static void decodeStatus(unsigned char seq, const TELEMETRY_STATUS *status)
+{
+    RECORD record;
+
+    clearRecord(&record, 'b', seq);
+    setField(&record, F_TICK, status->tick);
+    setField(&record, F_AIR, (status->flags & TELEMETRY_FLAG_AIR) != 0);
+    setField(&record, F_TORQUE_CONTROL, (status->flags & TELEMETRY_FLAG_TORQUE_CONTROL) != 0);
+    setField(&record, F_SHUTDOWN, (status->flags & TELEMETRY_FLAG_SHUTDOWN) != 0);
+    setField(&record, F_DRIVE, (status->flags & TELEMETRY_FLAG_DRIVE) != 0);
+    setField(&record, F_ACCEL1, status->accel[0]);
+    setField(&record, F_ACCEL2, status->accel[1]);
+    setField(&record, F_DEVIATION, status->accelDevCount * (100 * ADC_VOLTAGE_RESOLUTION / AMOUNT_OF_MOVEMENT));
+    setField(&record, F_TORQUE, status->torque * (1.0 / FIXED_TORQUE_RESOLUTION));
+    setField(&record, F_MGECU1_PERIOD, status->mgecu1Period);
+    setField(&record, F_RX_MAX, status->rxMaxCount);
+    setField(&record, F_RX_OVERFLOW, status->rxOverflow);
+    setField(&record, F_CTRL_OVERFLOW, status->ctrlOverflow);
+    setField(&record, F_RX_REJECTED, status->rxRejected);
+    setField(&record, F_TX_MAX_PERIOD, status->txMaxPeriod);
+    setField(&record, F_TX_JITTER, status->txJitter);
+    setField(&record, F_TX_EVENT, status->txEvent);
+    setField(&record, F_BUS_LOAD, status->busLoad);
+    setField(&record, F_DROPPED, status->dropCount);
+    setField(&record, F_CAN_READY, (status->flags & TELEMETRY_FLAG_CAN_READY) != 0);
+    setField(&record, F_CAN_REINIT, status->canReinit);
+    setField(&record, F_CAN_BUS_OFF, status->canBusOff);
+    setField(&record, F_CAN_INIT_FAIL, status->canInitFail);
+    setField(&record, F_CAN_INIT_MAX, status->canInitMax);
+    setField(&record, F_MGECU1_TIMEOUT, (status->flags & TELEMETRY_FLAG_MGECU1_TIMEOUT) != 0);
+    setField(&record, F_MGECU2_TIMEOUT, (status->flags & TELEMETRY_FLAG_MGECU2_TIMEOUT) != 0);
+    setField(&record, F_ECU_ENABLE, EV_ECU1::EcuEnable::get(status->evecu1));
+    setField(&record, F_DISCHARGE, EV_ECU1::DischargeCommand::get(status->evecu1));
+    setField(&record, F_TORQUE_REQUEST, EV_ECU1::RequestTorque::getPhysical(status->evecu1));
+    setField(&record, F_WORKING_STATUS, MG_ECU1::WorkingStatus::get(status->mgecu1));
+    setField(&record, F_MOTOR_SPEED, MG_ECU1::MotorSpeed::getPhysical(status->mgecu1));
+    setField(&record, F_PHASE_CURRENT, MG_ECU1::MotorPhaseCurrent::getPhysical(status->mgecu1));
+    setField(&record, F_DC_VOLTAGE, MG_ECU1::InputDCVoltage::get(status->mgecu1));
+    setField(&record, F_FAILURE_STATUS, MG_ECU1::FailureStatus::get(status->mgecu1));
+    setField(&record, F_INVERTER_TEMP, MG_ECU2::InverterTemp::getPhysical(status->mgecu2));
+    setField(&record, F_MAX_MOTOR_TORQUE, MG_ECU2::MaxAvailableMotorTorque::getPhysical(status->mgecu2));
+    setField(&record, F_MAX_GENERATE_TORQUE, MG_ECU2::MaxAvailableGenerateTorque::getPhysical(status->mgecu2));
+    setField(&record, F_MOTOR_TEMP, MG_ECU2::MotorTemp::getPhysical(status->mgecu2));
+
+    emitRecord(&record);
+}
+
+/**
+ * 状態名の文字列を Inverter_dfs.hpp の値に戻す
+ * @return 値, 知らない名前のときは -1
+ */
+static int parseStatusName(const char *name, const char *(*toName)(unsigned char))
+{
+    for (int code = 0; code < 8; code++)
+    {
+        const char *s = toName(code);
+        if (strcmp(s, "error") != 0 && strcmp(s, name) == 0)
+        {
+            return code;
+        }
+    }
+    return -1;
+}
+
+/**
+ * テキストモードの1行を読む
+ * @return テキストの行だった(1), 知らない行(0)
+ */
+static unsigned char parseTextLine(char *line)
+{
+    // 空行はサンプルの区切り
+    if (line[0] == '\0')
+    {
+        flushTextRecord();
+        return 1;
+    }
+
+    unsigned char field = FIELD_NUM;
+    double value = 0;
+
+    if (strcmp(line, "MG-ECU Enable") == 0 || strcmp(line, "MG-ECU Disable") == 0)
+    {
+        field = F_ECU_ENABLE;
+        value = line[7] == 'E';
+    }
+    else if (strncmp(line, "Rapid Discharge Command ", 24) == 0)
+    {
+        field = F_DISCHARGE;
+        value = strcmp(line + 24, "Active") == 0;
+    }
+    else
+    {
+        // 長いラベルを優先する ("Torque" と "Torque Request" など)
+        size_t best = 0;
+        for (size_t i = 0; i < TEXT_LABEL_NUM; i++)
+        {
+            size_t len = strlen(TEXT_LABELS[i].label);
+            if (len > best && strncmp(line, TEXT_LABELS[i].label, len) == 0 && (line[len] == ' ' || line[len] == '\0'))
+            {
+                best = len;
+                field = TEXT_LABELS[i].field;
+            }
+        }
+
+        if (field == FIELD_NUM)
+        {
+            return 0;
+        }
+
+        const char *arg = line + best;
+        while (*arg == ' ' || *arg == ':')
+        {
+            arg++;
+        }
+
+        if (field == F_WORKING_STATUS || field == F_FAILURE_STATUS)
+        {
+            int code = parseStatusName(arg, field == F_WORKING_STATUS ? workingStatusName : failureStatusName);
+            if (code < 0)
+            {
+                return 1;
+            }
+            value = code;
+        }
+        else
+        {
+            char *end;
+            value = strtod(arg, &end);
+            if (end == arg)
+            {
+                return 0;
+            }
+        }
+    }
+
+    // 同じ項目が2回来たら区切りの空行を取りこぼしているので, そこで1サンプルとする
+    if (textRecord.valid[field])
+    {
+        flushTextRecord();
+    }
+    setField(&textRecord, field, value);
+
+    return 1;
+}
+
+static void decodeFrame(const unsigned char *frame, unsigned char frameLen)
+{
+    unsigned char raw[TELEMETRY_RAW_MAX];
+    int len = decodeTelemetryFrame(frame, frameLen, raw);
+    static int lastSeq = -1;
+
+    if (len < 0)
+    {
+        counts.errors++;
+        return;
+    }
+
+    if (raw[0] == TELEMETRY_TYPE_STATUS && len == sizeof(TELEMETRY_STATUS))
+    {
+        TELEMETRY_STATUS status;
+        memcpy(&status, raw + 2, sizeof(status));
+
+        if (lastSeq >= 0)
+        {
+            counts.lost += (unsigned char)(raw[1] - lastSeq - 1);
+        }
+        lastSeq = raw[1];
+        counts.frames++;
+
+        decodeStatus(raw[1], &status);
+    }
+}
+
+static unsigned char isTextSegment(const unsigned char *seg, unsigned short len)
+{
+    for (unsigned short i = 0; i < len; i++)
+    {
+        if ((seg[i] < 0x20 || seg[i] > 0x7E) && seg[i] != '\r')
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * 受信したバイト列を区切る
+ * 0x00 はバイナリフレームの区切り, '\n' はテキストの行の区切り
+ * COBS の中にも 0x0A は現れるので, 印字可能な文字だけで既知のラベルの行のときだけテキストとする
+ */
+static void feed(const unsigned char *buf, size_t n)
+{
+    static unsigned char seg[TELEMETRY_FRAME_MAX > LINE_MAX_LEN ? TELEMETRY_FRAME_MAX : LINE_MAX_LEN];
+    static unsigned short segLen = 0;
+    static unsigned char overrun = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char c = buf[i];
+
+        if (c == TELEMETRY_DELIMITER)
+        {
+            // フレームの前後に区切りがあるので, 空のフレームは無視する
+            if (overrun)
+            {
+                counts.errors++;
+            }
+            else if (segLen > 0)
+            {
+                if (segLen <= TELEMETRY_FRAME_MAX)
+                {
+                    decodeFrame(seg, segLen);
+                }
+                else
+                {
+                    counts.errors++;
+                }
+            }
+            segLen = 0;
+            overrun = 0;
+            continue;
+        }
+
+        if (c == '\n' && !overrun && isTextSegment(seg, segLen))
+        {
+            char line[LINE_MAX_LEN + 1];
+            unsigned short len = segLen;
+
+            while (len > 0 && (seg[len - 1] == '\r' || seg[len - 1] == ' '))
+            {
+                len--;
+            }
+            memcpy(line, seg, len);
+            line[len] = '\0';
+
+            if (parseTextLine(line))
+            {
+                segLen = 0;
+                continue;
+            }
+
+            // LoopProfiler の表示などテキストでも知らない行は捨てる
+            if (segLen > TELEMETRY_FRAME_MAX || memchr(seg, ' ', segLen) != nullptr)
+            {
+                segLen = 0;
+                continue;
+            }
+        }
+
+        if (segLen < sizeof(seg))
+        {
+            seg[segLen++] = c;
+        }
+        else
+        {
+            overrun = 1;
+        }
+    }
+}
+
+static void printSparkline(const char *name, unsigned char index)
+{
+    static const char LEVEL[] = " .:-=+*#%@";
+    double lo = INFINITY;
+    double hi = -INFINITY;
+
+    for (unsigned short i = 0; i < historyCount; i++)
+    {
+        double v = history[index][i];
+        if (!isnan(v))
+        {
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    }
+
+    printf("%-20s |", name);
+    for (unsigned short i = 0; i < historyCount; i++)
+    {
+        double v = history[index][(historyHead + HISTORY_LEN - historyCount + i) % HISTORY_LEN];
+        if (isnan(v))
+        {
+            putchar(' ');
+        }
+        else
+        {
+            int level = hi > lo ? (int)((v - lo) / (hi - lo) * (sizeof(LEVEL) - 2) + 0.5) : 0;
+            putchar(LEVEL[level]);
+        }
+    }
+    if (historyCount > 0 && lo <= hi)
+    {
+        printf("| %.1f .. %.1f\n", lo, hi);
+    }
+    else
+    {
+        printf("|\n");
+    }
+}
+
+static void printView(void)
+{
+    // カーソルを左上に戻して上書きする
+    printf("\033[H\033[J");
+    printf("frames %lu  crc/format errors %lu  lost %lu  text samples %lu  bytes %llu\n\n",
+           counts.frames, counts.errors, counts.lost, counts.textRecords, counts.bytes);
+
+    for (int i = 0; i < FIELD_NUM; i++)
+    {
+        if (!latest.valid[i])
+        {
+            continue;
+        }
+
+        printf("%-20s ", FIELD_NAME[i]);
+        if (i == F_WORKING_STATUS)
+        {
+            printf("%s\n", workingStatusName(latest.value[i]));
+        }
+        else if (i == F_FAILURE_STATUS)
+        {
+            printf("%s\n", failureStatusName(latest.value[i]));
+        }
+        else
+        {
+            printf("%.6g\n", latest.value[i]);
+        }
+    }
+
+    printf("\n");
+    for (int i = 0; i < 3; i++)
+    {
+        printSparkline(FIELD_NAME[historyField[i]], i);
+    }
+    fflush(stdout);
+}
+
+static speed_t toSpeed(long baud)
+{
+    switch (baud)
+    {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 500000:
+        return B500000;
+    case 921600:
+        return B921600;
+    case 1000000:
+        return B1000000;
+    case 2000000:
+        return B2000000;
+    default:
+        return B0;
+    }
+}
+
+static int openInput(const char *path, speed_t speed)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+
+    if (fd < 0)
+    {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+    }
+
+    if (fd < 0 || !isatty(fd))
+    {
+        return fd;
+    }
+
+    // シリアルポートは raw モードにする
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+
+    return fd;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [-b baud] [-o out.csv] [-m b|t] [-q] [device | file | -]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    long baud = DEFAULT_BAUD;
+    const char *csvPath = nullptr;
+    int modeCommand = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:m:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = atol(optarg);
+            break;
+        case 'o':
+            csvPath = optarg;
+            break;
+        case 'm':
+            modeCommand = optarg[0] == 't' ? TELEMETRY_CMD_TEXT : TELEMETRY_CMD_BINARY;
+            break;
+        case 'q':
+            quiet = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    speed_t speed = toSpeed(baud);
+    if (speed == B0)
+    {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return 1;
+    }
+
+    const char *path = optind < argc ? argv[optind] : "-";
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : openInput(path, speed);
+
+    if (fd < 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    if (modeCommand != 0)
+    {
+        char c = modeCommand;
+        if (write(fd, &c, 1) != 1)
+        {
+            perror("mode command");
+        }
+    }
+
+    if (csvPath != nullptr)
+    {
+        if (strcmp(csvPath, "-") == 0)
+        {
+            csv = stdout;
+            quiet = 1;
+        }
+        else
+        {
+            csv = fopen(csvPath, "w");
+        }
+
+        if (csv == nullptr)
+        {
+            perror(csvPath);
+            return 1;
+        }
+
+        // 1 Mbaud 以上でも書き込みで読み出しが止まらないように大きなバッファにする
+        setvbuf(csv, nullptr, _IOFBF, CSV_BUFFER_SIZE);
+        writeCsvHeader();
+    }
+
+    if (!isatty(STDOUT_FILENO))
+    {
+        quiet = 1;
+    }
+
+    clearRecord(&textRecord, 't', -1);
+    clearRecord(&latest, 't', -1);
+
+    static unsigned char buf[READ_BUFFER_SIZE];
+    unsigned long long lastView = 0;
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+        counts.bytes += n;
+        feed(buf, n);
+
+        if (!quiet)
+        {
+            unsigned long long now = nowMs();
+            if (now - lastView >= VIEW_PERIOD_MS)
+            {
+                lastView = now;
+                printView();
+            }
+        }
+    }
+
+    flushTextRecord();
+
+    if (!quiet)
+    {
+        printView();
+    }
+
+    if (csv != nullptr)
+    {
+        fclose(csv);
+    }
+
+    fprintf(stderr, "frames %lu, errors %lu, lost %lu, text samples %lu, bytes %llu\n",
+            counts.frames, counts.errors, counts.lost, counts.textRecords, counts.bytes);
+
+    return 0;
+}
@@ -0,0 +1,369 @@
+/**
+ * アクセルセンサの変換値を AdcFilter に通して, ノイズの減り方と遅れを測る
+ *
+ * ADC の1周(ACCEL_SENSOR1, ACCEL_SENSOR2)ごとの変換値を順に AdcFilter へ入れ,
+ * TASK_PEDAL_PERIOD ごとに Accel へ渡す (ファームウェアの taskPedal と同じ)
+ * 比較のため, 同じ時刻の生の変換値 (以前の analogRead) も別の Accel へ渡す
+ *
+ * 表示するもの
+ *  - センサ値のノイズ (50 ms の移動平均からの残差の標準偏差, 10bit の LSB 換算) と有効ビット数
+ *    ペダルの動きの折れ目で残差が大きくなる所を除くため, 標準偏差は残差の中央絶対偏差から求める
+ *  - 小さい方のセンサ値から計算したトルクのリップル (calcTorque と同じ直線)
+ *  - 偏差が THRESHOLD_DEVIATION を超えた回数と, 3回続いて偏差異常になった回数
+ *  - ステップ入力に対して出力が50%を超えるまでの遅れ (フィルタが足す群遅延)
+ *
+ * usage : program [-n ノイズ[LSB]] [-s 乱数シード] [-t 1周の時間[us]] [-w 書き出すファイル] [トレース]
+ *  トレースを省略すると, ペダルを踏んで離す波形にガウスノイズを足したものを作る
+ *  トレースのファイルは1周ごとに "sensor1 sensor2" (10bit の変換値) の行, # 以降はコメント
+ *  -w で作った波形を同じ形式で書き出す
+ */
+#include <Arduino.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include "Accel.hpp"
+#include "AdcFilter.hpp"
+
+#define DEFAULT_NOISE (2.0)          // [LSB]
+#define DEFAULT_SCAN_PERIOD (156)    // 52 us x 3チャンネル (AdcScan_dfs.hpp のプリスケーラ 64)
+#define PEDAL_PERIOD (5000)          // TASK_PEDAL_PERIOD [us]
+#define DETREND_WINDOW (50000)       // ノイズを測るときに取り除く移動平均の幅[us]
+#define STEP_LOW (0.5f)              // 遅れを測るステップ[V]
+#define STEP_HIGH (1.0f)
+#define STEP_PHASES (64)             // ステップの時刻を1周ずつずらして平均する回数
+
+struct SCAN
+{
+    unsigned short v[2]; // 10bit の変換値
+};
+
+// ペダルを踏んで離す波形 (時刻[ms], センサ1の電圧[V]), 間は直線
+static const float PEDAL_PROFILE[][2] = {
+    {0, 0.5f}, {300, 0.5f}, {400, 1.0f}, {800, 1.0f}, {1000, 0.6f}, {1400, 0.6f},
+    {1500, 1.25f}, {1900, 1.25f}, {2100, 0.4f}, {2500, 0.4f}};
+
+static double gauss(void)
+{
+    const double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    const double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static unsigned short quantize(double lsb)
+{
+    const long v = lround(lsb);
+    return v < 0 ? 0 : v > 1023 ? 1023 : v;
+}
+
+static float profileVoltage(double ms)
+{
+    const int n = sizeof(PEDAL_PROFILE) / sizeof(PEDAL_PROFILE[0]);
+
+    for (int i = 1; i < n; i++)
+    {
+        if (ms <= PEDAL_PROFILE[i][0])
+        {
+            const float r = (ms - PEDAL_PROFILE[i - 1][0]) / (PEDAL_PROFILE[i][0] - PEDAL_PROFILE[i - 1][0]);
+            return PEDAL_PROFILE[i - 1][1] + r * (PEDAL_PROFILE[i][1] - PEDAL_PROFILE[i - 1][1]);
+        }
+    }
+
+    return PEDAL_PROFILE[n - 1][1];
+}
+
+// センサ2は傾きが負 (Accel::setValue(int, int) で反転される)
+static void makeTrace(std::vector<SCAN> *trace, double noise, unsigned long scanPeriod)
+{
+    const double lsbPerVolt = 1.0 / 0.0049;
+    const double end = PEDAL_PROFILE[sizeof(PEDAL_PROFILE) / sizeof(PEDAL_PROFILE[0]) - 1][0] * 1000.0;
+
+    for (double t = 0; t < end; t += scanPeriod)
+    {
+        const double v = profileVoltage(t / 1000.0) * lsbPerVolt;
+        SCAN scan;
+
+        scan.v[0] = quantize(v + noise * gauss());
+        scan.v[1] = quantize(1023 - v + noise * gauss());
+        trace->push_back(scan);
+    }
+}
+
+static unsigned char readTrace(const char *path, std::vector<SCAN> *trace)
+{
+    FILE *fp = fopen(path, "r");
+    char line[128];
+
+    if (fp == nullptr)
+    {
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        unsigned int a, b;
+
+        if (line[0] != '#' && sscanf(line, "%u %u", &a, &b) == 2)
+        {
+            SCAN scan = {{(unsigned short)(a > 1023 ? 1023 : a), (unsigned short)(b > 1023 ? 1023 : b)}};
+            trace->push_back(scan);
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static unsigned char writeTrace(const char *path, const std::vector<SCAN> *trace, unsigned long scanPeriod)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == nullptr)
+    {
+        return 1;
+    }
+
+    fprintf(fp, "# sensor1 sensor2 (10bit, %lu us per scan)\n", scanPeriod);
+    for (size_t i = 0; i < trace->size(); i++)
+    {
+        fprintf(fp, "%u %u\n", (*trace)[i].v[0], (*trace)[i].v[1]);
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static double median(std::vector<double> *x)
+{
+    std::nth_element(x->begin(), x->begin() + x->size() / 2, x->end());
+    return (*x)[x->size() / 2];
+}
+
+// 中心の移動平均 (幅 window 点) からの残差の標準偏差 (中央絶対偏差 x 1.4826)
+static double residualStd(const std::vector<double> *x, size_t window)
+{
+    const size_t half = window / 2;
+    std::vector<double> r;
+
+    if (half == 0 || x->size() <= window)
+    {
+        return 0;
+    }
+
+    for (size_t i = half; i + half < x->size(); i++)
+    {
+        double avg = 0;
+        for (size_t j = i - half; j <= i + half; j++)
+        {
+            avg += (*x)[j];
+        }
+        r.push_back((*x)[i] - avg / (2 * half + 1));
+    }
+
+    const double m = median(&r);
+    for (size_t i = 0; i < r.size(); i++)
+    {
+        r[i] = fabs(r[i] - m);
+    }
+
+    return 1.4826 * median(&r);
+}
+
+// 標準偏差 sigma [LSB] のノイズがあるときの 10bit 全幅に対する有効ビット数
+static double effectiveBits(double sigma)
+{
+    return sigma > 0 ? log2(1024.0 / (sigma * sqrt(12.0))) : 0;
+}
+
+struct RESULT
+{
+    std::vector<double> sensor; // センサ1 [10bit LSB]
+    std::vector<double> torque; // [Nm]
+    unsigned long devCount;     // 偏差が閾値以上だった回数
+    unsigned long devError;     // 3回続いた回数
+    unsigned long pedalCount;
+};
+
+static void addPedal(RESULT *result, Accel *accel, unsigned short v1, unsigned short v2, unsigned char *run)
+{
+    accel->setValue(v1, v2);
+
+    const unsigned short value = accel->getValue(0) < accel->getValue(1) ? accel->getValue(0) : accel->getValue(1);
+    float v = value * ADC_VOLTAGE_RESOLUTION;
+    v = v < MINIMUM_SENSOR_VOLTAGE ? MINIMUM_SENSOR_VOLTAGE : v > MAXIMUM_SENSOR_VOLTAGE ? MAXIMUM_SENSOR_VOLTAGE : v;
+    result->torque.push_back(MAXIMUM_TORQUE * (v - MINIMUM_SENSOR_VOLTAGE));
+
+    if (accel->getDev() >= THRESHOLD_DEVIATION)
+    {
+        result->devCount++;
+        if (++*run == 3)
+        {
+            result->devError++;
+        }
+    }
+    else
+    {
+        *run = 0;
+    }
+    result->pedalCount++;
+}
+
+/**
+ * トレースを流して, 生の変換値 (raw) と AdcFilter の出力 (filtered) の結果を求める
+ * raw は Accel のセンサ値の範囲に合わせて ADC_FILTER_EXTRA_BITS だけ左にずらす
+ */
+static void run(const std::vector<SCAN> *trace, unsigned long scanPeriod, RESULT *raw, RESULT *filtered)
+{
+    AdcFilter filters[2];
+    Accel rawAccel, filteredAccel;
+    unsigned char rawRun = 0, filteredRun = 0;
+    unsigned long nextPedal = PEDAL_PERIOD;
+
+    for (size_t i = 0; i < trace->size(); i++)
+    {
+        const SCAN *scan = &(*trace)[i];
+        const unsigned long t = (i + 1) * scanPeriod;
+
+        raw->sensor.push_back(scan->v[0]);
+        filters[0].add(scan->v[0]);
+        if (filters[1].add(scan->v[1]))
+        {
+            filtered->sensor.push_back((double)filters[0].get() / (1 << ADC_FILTER_EXTRA_BITS));
+        }
+
+        if (t >= nextPedal)
+        {
+            nextPedal += PEDAL_PERIOD;
+            addPedal(raw, &rawAccel, scan->v[0] << ADC_FILTER_EXTRA_BITS, scan->v[1] << ADC_FILTER_EXTRA_BITS, &rawRun);
+            addPedal(filtered, &filteredAccel, filters[0].get(), filters[1].get(), &filteredRun);
+        }
+    }
+}
+
+/**
+ * STEP_LOW から STEP_HIGH へのステップを入れ, 出力が50%を超えるまでの時間[us]
+ * ステップの時刻を間引きの区切りに対してずらして平均する
+ * 出力の時刻は間引きに使った最後の変換の時刻
+ */
+static double stepDelay(unsigned long scanPeriod)
+{
+    const double low = STEP_LOW / 0.0049, high = STEP_HIGH / 0.0049;
+    const double half = (low + high) / 2 * (1 << ADC_FILTER_EXTRA_BITS);
+    const long settle = 64L * ADC_FILTER_OVERSAMPLE;
+    double sum = 0;
+
+    for (int phase = 0; phase < STEP_PHASES; phase++)
+    {
+        AdcFilter filter;
+        const long step = settle + phase;
+
+        for (long i = 0; i < step + settle; i++)
+        {
+            if (filter.add(quantize(i < step ? low : high)) && i >= step && filter.get() >= half)
+            {
+                // ステップは変換 step の直前, 出力ができるのは変換 i の終わり
+                sum += (double)(i - step + 1) * scanPeriod;
+                break;
+            }
+        }
+    }
+
+    return sum / STEP_PHASES;
+}
+
+static void printResult(const char *name, const RESULT *result, double sensorNoise, double torqueNoise)
+{
+    printf("%-9s %12.3f %10.2f %14.4f %10lu %10lu\n", name, sensorNoise, effectiveBits(sensorNoise), torqueNoise,
+           result->devCount, result->devError);
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "usage : %s [-n noise[LSB]] [-s seed] [-t scan period[us]] [-w output] [trace]\n", program);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    double noise = DEFAULT_NOISE;
+    unsigned int seed = 1;
+    unsigned long scanPeriod = DEFAULT_SCAN_PERIOD;
+    const char *output = nullptr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:t:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            noise = atof(optarg);
+            break;
+        case 's':
+            seed = (unsigned int)atol(optarg);
+            break;
+        case 't':
+            scanPeriod = strtoul(optarg, nullptr, 10);
+            break;
+        case 'w':
+            output = optarg;
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+
+    if (scanPeriod == 0)
+    {
+        return usage(argv[0]);
+    }
+
+    std::vector<SCAN> trace;
+
+    if (optind < argc)
+    {
+        if (readTrace(argv[optind], &trace) != 0)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+        printf("trace             : %s (%lu scans)\n", argv[optind], (unsigned long)trace.size());
+    }
+    else
+    {
+        srand(seed);
+        makeTrace(&trace, noise, scanPeriod);
+        printf("trace             : synthetic, noise %.2f LSB, seed %u (%lu scans)\n", noise, seed, (unsigned long)trace.size());
+    }
+
+    if (output != nullptr && writeTrace(output, &trace, scanPeriod) != 0)
+    {
+        perror(output);
+        return 1;
+    }
+
+    const unsigned long outputPeriod = scanPeriod * ADC_FILTER_OVERSAMPLE;
+
+    printf("filter            : %d extra bits (%d samples), IIR shift %d\n", ADC_FILTER_EXTRA_BITS, ADC_FILTER_OVERSAMPLE, ADC_FILTER_IIR_SHIFT);
+    printf("scan / output     : %lu us / %lu us, pedal task %d us\n\n", scanPeriod, outputPeriod, PEDAL_PERIOD);
+
+    RESULT raw = {}, filtered = {};
+    run(&trace, scanPeriod, &raw, &filtered);
+
+    const double rawNoise = residualStd(&raw.sensor, DETREND_WINDOW / scanPeriod);
+    const double filteredNoise = residualStd(&filtered.sensor, DETREND_WINDOW / outputPeriod);
+    const size_t pedalWindow = DETREND_WINDOW / PEDAL_PERIOD;
+
+    printf("%-9s %12s %10s %14s %10s %10s\n", "", "noise [LSB]", "bits", "torque [Nm]", "dev >= th", "dev error");
+    printResult("raw", &raw, rawNoise, residualStd(&raw.torque, pedalWindow));
+    printResult("filtered", &filtered, filteredNoise, residualStd(&filtered.torque, pedalWindow));
+
+    if (filteredNoise > 0)
+    {
+        printf("\nnoise reduction   : %.2f x (%.2f bits)\n", rawNoise / filteredNoise, log2(rawNoise / filteredNoise));
+    }
+    printf("added delay       : %.0f us to 50%% of a step (pedal task period %d us)\n", stepDelay(scanPeriod), PEDAL_PERIOD);
+
+    return 0;
+}
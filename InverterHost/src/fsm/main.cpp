@@ -0,0 +1,162 @@
+/**
+ * Inverter::runInverter の状態遷移表の評価にかかる時間を測る
+ *
+ * Working Status (MG-ECU1 を Loopback_Bus で受信させる) × イベントの全ての組み合わせで
+ * runInverterFixed を繰り返し呼び, 1回ごとの時間の平均, 99.9パーセンタイル, 最大を表示する
+ * 最大は OS の割り込みを含むので, 最悪値の目安は 99.9パーセンタイルを見る
+ * アクションが最も重くなるように, プリチャージ完了の電圧, トルク制御中のフラグを与える
+ * 最後の行は毎回イベントが変わって StateTrace に記録される場合
+ * ホストPC (x86-64, -O2) の例 : 平均 15~46 ns, 99.9パーセンタイルの最悪 166~177 ns
+ *
+ * usage : program [繰り返し回数]
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Inverter.hpp"
+#include "Loopback_Bus.hpp"
+
+#define DEFAULT_REPEAT (200000)
+#define BATTERY_VOLTAGE (370)
+#define REQUEST_TORQUE (40) // [0.5 Nm]
+#define HISTOGRAM_SIZE (4096) // 1ns 刻み, これ以上は最後に入れる
+
+struct COST
+{
+    unsigned long long sum;
+    unsigned long max;
+    unsigned long count;
+    unsigned long histogram[HISTOGRAM_SIZE];
+};
+
+static unsigned long nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+// clock_gettime 2回分の時間 (測定値から引く)
+static unsigned long measureOverhead(void)
+{
+    unsigned long min = ~0UL;
+
+    for (int i = 0; i < 10000; i++)
+    {
+        const unsigned long t0 = nowNanos();
+        const unsigned long t1 = nowNanos();
+        min = t1 - t0 < min ? t1 - t0 : min;
+    }
+
+    return min;
+}
+
+static void sendMgecu(Loopback_Bus *bus, Inverter *inverter, unsigned char workingStatus)
+{
+    unsigned char mgecu1[8] = {0};
+    unsigned char mgecu2[8] = {0};
+
+    MG_ECU1::WorkingStatus::set(mgecu1, workingStatus);
+    MG_ECU1::InputDCVoltage::set(mgecu1, BATTERY_VOLTAGE);
+    MG_ECU1::MotorSpeed::set(mgecu1, 14000);
+    MG_ECU2::MaxAvailableMotorTorque::set(mgecu2, 120);
+    MG_ECU2::MaxAvailableGenerateTorque::set(mgecu2, 2000 - 120);
+
+    bus->write(MG_ECU1_ID, 8, mgecu1);
+    bus->write(MG_ECU2_ID, 8, mgecu2);
+    inverter->readMsgFromInverter(0);
+}
+
+static void measure(Inverter *inverter, COST *cost, unsigned char event, unsigned char toggle, long repeat, unsigned long overhead)
+{
+    cost->sum = 0;
+    cost->max = 0;
+    cost->count = 0;
+    memset(cost->histogram, 0, sizeof(cost->histogram));
+
+    for (long i = 0; i < repeat; i++)
+    {
+        // toggle のときは IDLE とイベントを交互にして毎回記録させる
+        const unsigned char e = toggle && (i & 1) ? INVERTER_EVENT_IDLE : event;
+        unsigned char flags[4] = {1, 1, e == INVERTER_EVENT_SHUTDOWN, e == INVERTER_EVENT_DRIVE};
+
+        const unsigned long t0 = nowNanos();
+        inverter->runInverterFixed(flags, BATTERY_VOLTAGE, REQUEST_TORQUE);
+        const unsigned long t1 = nowNanos();
+
+        const unsigned long t = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+        cost->sum += t;
+        cost->max = t > cost->max ? t : cost->max;
+        cost->count++;
+        cost->histogram[t < HISTOGRAM_SIZE ? t : HISTOGRAM_SIZE - 1]++;
+    }
+}
+
+static unsigned long percentile(const COST *cost, double p)
+{
+    const unsigned long long n = (unsigned long long)(cost->count * p);
+    unsigned long long sum = 0;
+
+    for (unsigned long i = 0; i < HISTOGRAM_SIZE; i++)
+    {
+        sum += cost->histogram[i];
+        if (sum >= n)
+        {
+            return i;
+        }
+    }
+
+    return HISTOGRAM_SIZE - 1;
+}
+
+static void printCost(const char *state, const char *event, const COST *cost, unsigned long *worst)
+{
+    const unsigned long p999 = percentile(cost, 0.999);
+
+    printf("%-16s %-9s %10.1f %10lu %10lu\n", state, event, (double)cost->sum / cost->count, p999, cost->max);
+    *worst = p999 > *worst ? p999 : *worst;
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned char WORKING_STATUS[] = {WORKING_INIT, WORKING_PRECHARGE, WORKING_STANDBY, WORKING_TORQUE_CONTROL, WORKING_RAPID_DISCHARGE};
+    static const char *WORKING_NAMES[] = {"INIT", "PRECHARGE", "STANDBY", "TORQUE_CONTROL", "RAPID_DISCHARGE"};
+    static const char *EVENT_NAMES[] = {"IDLE", "DRIVE", "SHUTDOWN"};
+    const long repeat = argc > 1 ? atol(argv[1]) : DEFAULT_REPEAT;
+
+    Loopback_Bus inverterBus, mgecuBus;
+    Inverter inverter(&inverterBus);
+    unsigned long worst = 0;
+    static COST cost;
+
+    inverterBus.connect(&mgecuBus);
+    mgecuBus.connect(&inverterBus);
+
+    hostSerialEnable(0);
+    hostUseVirtualClock(1);
+    inverter.init();
+
+    const unsigned long overhead = measureOverhead();
+
+    printf("%-16s %-9s %10s %10s %10s\n", "working status", "event", "avg [ns]", "p99.9 [ns]", "max [ns]");
+
+    for (unsigned int s = 0; s < sizeof(WORKING_STATUS); s++)
+    {
+        sendMgecu(&mgecuBus, &inverter, WORKING_STATUS[s]);
+
+        for (unsigned char e = 0; e < INVERTER_EVENT_NUM; e++)
+        {
+            measure(&inverter, &cost, e, 0, repeat, overhead);
+            printCost(WORKING_NAMES[s], EVENT_NAMES[e], &cost, &worst);
+        }
+    }
+
+    sendMgecu(&mgecuBus, &inverter, WORKING_TORQUE_CONTROL);
+    measure(&inverter, &cost, INVERTER_EVENT_DRIVE, 1, repeat, overhead);
+    printCost("TORQUE_CONTROL", "toggle", &cost, &worst);
+
+    printf("\nworst p99.9     : %lu ns (clock overhead %lu ns subtracted)\n", worst, overhead);
+
+    return 0;
+}
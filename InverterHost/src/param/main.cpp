@@ -0,0 +1,235 @@
+/**
+ * Parameter (テンプレート, 整数演算) を以前の Parameter (実行時の float, ポインタ経由) と比べる
+ *
+ * 1. 全ての Normal Value で calcPhysical が以前と同じ値になるか, calcFixed / calcPhysicalInt と矛盾しないか
+ * 2. 範囲内の Physical Value を細かく振って calcNormal が以前と同じ値になるか
+ *    (以前は範囲の制限が無かったので, 範囲外は新しい方だけ制限されていることを確認する)
+ * 3. 1回の変換の時間とサイクル数 (ホストPCの TSC) を比べる
+ *    以前の Parameter は Parameter.cpp にあり呼び出しがインライン展開されなかったので, noinline で再現する
+ *    AVR (FPU 無し) では float の掛け算/割り算がソフトウェアになるので差はホストPCより大きい
+ *
+ * usage : program [繰り返し回数]
+ * 戻り値 : 以前と一致しない変換があれば 1
+ */
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "EV_ECU1.hpp"
+#include "MG_ECU1.hpp"
+#include "MG_ECU2.hpp"
+
+#define DEFAULT_REPEAT (2000)
+#define BENCH_NUM (4096)
+#define PHYSICAL_STEP (0.01f) // calcNormal を確かめる Physical Value の刻み
+
+typedef Parameter<-25, 1, 2, -25, 100> AmsTempPara; // AMS_Temp_Master の CAN_Temp と同じ
+
+//-------------------------------------------------------
+//  以前の Parameter (比較用)
+//-------------------------------------------------------
+class LegacyParameter
+{
+private:
+    const short offset;
+    const float resolution;
+    const short minPhysical, maxPhysical;
+
+public:
+    LegacyParameter(short offset, float resolution, short minPhysical, short maxPhysical)
+        : offset(offset), resolution(resolution), minPhysical(minPhysical), maxPhysical(maxPhysical) {}
+
+    __attribute__((noinline)) float calcPhysical(unsigned short normal)
+    {
+        return (normal * resolution) + offset;
+    }
+
+    __attribute__((noinline)) unsigned short calcNormal(float physicalValue)
+    {
+        return static_cast<unsigned short>((physicalValue - offset) / resolution);
+    }
+};
+
+//-------------------------------------------------------
+
+struct RESULT
+{
+    unsigned long physicalDiff; // calcPhysical が以前と違った数
+    unsigned long fixedDiff;    // calcFixed / calcPhysicalInt が calcPhysical と合わなかった数
+    unsigned long normalDiff;   // calcNormal が以前と違った数 (範囲内)
+    unsigned long clampError;   // 範囲外の calcNormal が範囲の端になっていなかった数
+    unsigned long normalNum;
+    unsigned long physicalNum;
+};
+
+static volatile float floatSink;
+static volatile long longSink;
+
+static double nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long nowCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Fixed Value の倍率 (Parameter の ResolutionDen)
+template <class Para>
+static long resolutionDen(void)
+{
+    return Para::getMaxPhysical() != 0 ? Para::getMaxFixed() / Para::getMaxPhysical() : Para::getMinFixed() / Para::getMinPhysical();
+}
+
+template <class Para>
+static unsigned char check(const char *name, LegacyParameter *legacy, unsigned short normalMax)
+{
+    RESULT r = {};
+
+    // 1. Normal Value → Physical Value
+    for (unsigned long n = 0; n <= normalMax; n++)
+    {
+        const float physical = Para::calcPhysical(n);
+
+        if (physical != legacy->calcPhysical(n))
+        {
+            r.physicalDiff++;
+        }
+        if (Para::calcFixed(n) != lroundf(physical * resolutionDen<Para>()))
+        {
+            r.fixedDiff++;
+        }
+        if (Para::calcPhysicalInt(n) != (long)physical)
+        {
+            r.fixedDiff++;
+        }
+        r.normalNum++;
+    }
+
+    // 2. Physical Value → Normal Value, 範囲の外側も少し振る
+    const float span = Para::getMaxPhysical() - Para::getMinPhysical();
+    for (float p = Para::getMinPhysical() - span / 4; p <= Para::getMaxPhysical() + span / 4; p += PHYSICAL_STEP)
+    {
+        if (Para::inRange((long)floorf(p)) && Para::inRange((long)ceilf(p)))
+        {
+            if (Para::calcNormal(p) != legacy->calcNormal(p))
+            {
+                r.normalDiff++;
+            }
+        }
+        else
+        {
+            const unsigned short edge = p < Para::getMinPhysical() ? Para::calcNormalInt(Para::getMinPhysical())
+                                                                  : Para::calcNormalInt(Para::getMaxPhysical());
+            if (Para::calcNormal(p) != edge)
+            {
+                r.clampError++;
+            }
+        }
+        r.physicalNum++;
+    }
+
+    printf("%-26s: calcPhysical %lu / %lu differ, fixed %lu, calcNormal %lu / %lu differ, clamp error %lu\n", name,
+           r.physicalDiff, r.normalNum, r.fixedDiff, r.normalDiff, r.physicalNum, r.clampError);
+
+    return r.physicalDiff || r.fixedDiff || r.normalDiff || r.clampError;
+}
+
+struct TIME
+{
+    double ns;
+    double cycles;
+};
+
+// func を BENCH_NUM 個の入力に repeat 回ずつ呼ぶ, 1回あたり
+template <class Func>
+static TIME measure(Func func, long repeat)
+{
+    const double t0 = nowNanos();
+    const unsigned long long c0 = nowCycles();
+
+    for (long r = 0; r < repeat; r++)
+    {
+        for (int i = 0; i < BENCH_NUM; i++)
+        {
+            func(i);
+        }
+    }
+
+    const double n = (double)repeat * BENCH_NUM;
+    TIME t = {(nowNanos() - t0) / n, (double)(nowCycles() - c0) / n};
+    return t;
+}
+
+static unsigned short benchNormal[BENCH_NUM];
+static float benchPhysical[BENCH_NUM];
+
+template <class Para>
+static void bench(const char *name, LegacyParameter *legacy, unsigned short normalMax, long repeat)
+{
+    for (int i = 0; i < BENCH_NUM; i++)
+    {
+        benchNormal[i] = rand() % (normalMax + 1);
+        benchPhysical[i] = Para::getMinPhysical() + (float)rand() / RAND_MAX * (Para::getMaxPhysical() - Para::getMinPhysical());
+    }
+
+    const TIME legacyPhysical = measure([legacy](int i) { floatSink = legacy->calcPhysical(benchNormal[i]); }, repeat);
+    const TIME physical = measure([](int i) { floatSink = Para::calcPhysical(benchNormal[i]); }, repeat);
+    const TIME fixed = measure([](int i) { longSink = Para::calcFixed(benchNormal[i]); }, repeat);
+    const TIME legacyNormal = measure([legacy](int i) { longSink = legacy->calcNormal(benchPhysical[i]); }, repeat);
+    const TIME normal = measure([](int i) { longSink = Para::calcNormal(benchPhysical[i]); }, repeat);
+    const TIME normalFixed = measure([](int i) { longSink = Para::calcNormalFixed((long)benchNormal[i] - 300); }, repeat);
+
+    printf("%-26s: calcPhysical %5.2f -> %5.2f ns (%5.1f -> %5.1f cyc), calcFixed %5.2f ns (%5.1f cyc)\n", name,
+           legacyPhysical.ns, physical.ns, legacyPhysical.cycles, physical.cycles, fixed.ns, fixed.cycles);
+    printf("%-26s  calcNormal   %5.2f -> %5.2f ns (%5.1f -> %5.1f cyc), calcNormalFixed %5.2f ns (%5.1f cyc)\n", "",
+           legacyNormal.ns, normal.ns, legacyNormal.cycles, normal.cycles, normalFixed.ns, normalFixed.cycles);
+}
+
+int main(int argc, char **argv)
+{
+    const long repeat = argc > 1 ? atol(argv[1]) : DEFAULT_REPEAT;
+    unsigned char failed = 0;
+
+    // 以前の EV_ECU1/MG_ECU1/MG_ECU2/CAN_Temp のコンストラクタと同じ値
+    LegacyParameter torque(-1000, 0.5f, -1000, 1000);
+    LegacyParameter speed(-14000, 1, -14000, 14000);
+    LegacyParameter current(0, 0.5f, 0, 500);
+    LegacyParameter temp(-40, 1, -40, 210);
+    LegacyParameter motoring(0, 0.5f, 0, 1000);
+    LegacyParameter generating(-1000, 0.5f, -1000, 0);
+    LegacyParameter amsTemp(-25, 0.5f, -25, 100);
+
+    srand(1);
+
+    printf("equivalence to the float Parameter\n");
+    failed |= check<EV_ECU1::TorqueRequestPara>("EV_ECU1 requestTorque", &torque, 4000);
+    failed |= check<MG_ECU1::MotorSpeedPara>("MG_ECU1 motorSpeed", &speed, 28000);
+    failed |= check<MG_ECU1::MotorPhaseCurrentPara>("MG_ECU1 motorPhaseCurrent", &current, 1000);
+    failed |= check<MG_ECU2::InverterTemperaturePara>("MG_ECU2 inverterTemp", &temp, 250);
+    failed |= check<MG_ECU2::MaxAvailableMotoringTorquePara>("MG_ECU2 maxMotorTorque", &motoring, 2000);
+    failed |= check<MG_ECU2::MaxAvailableGeneratingTorquePara>("MG_ECU2 maxGenerateTorque", &generating, 2000);
+    failed |= check<AmsTempPara>("CAN_Temp temp", &amsTemp, 250);
+
+    printf("\ntime per conversion (host PC, float Parameter -> template)\n");
+    bench<EV_ECU1::TorqueRequestPara>("EV_ECU1 requestTorque", &torque, 4000, repeat);
+    bench<MG_ECU1::MotorSpeedPara>("MG_ECU1 motorSpeed", &speed, 28000, repeat);
+    bench<MG_ECU1::MotorPhaseCurrentPara>("MG_ECU1 motorPhaseCurrent", &current, 1000, repeat);
+    bench<MG_ECU2::InverterTemperaturePara>("MG_ECU2 inverterTemp", &temp, 250, repeat);
+    bench<AmsTempPara>("CAN_Temp temp", &amsTemp, 250, repeat);
+
+    printf("\n%s\n", failed ? "FAILED" : "OK");
+
+    return failed;
+}
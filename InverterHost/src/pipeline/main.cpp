@@ -0,0 +1,288 @@
+/**
+ * アクセルセンサ値から EV-ECU1 の要求トルクまでの固定小数点の経路を float の経路と比べる
+ *
+ * 固定小数点 : Accel::setValue (TorqueMap::lookup) → Inverter::fixedTorqueRequest → EV-ECU1 (整数演算だけ)
+ * float      : 以前の Accel の float 計算 (TorqueMap::calc) → Inverter::torqueRequest → EV-ECU1
+ *
+ * 1. 全てのマップ, 全てのセンサ値 (0~ACCEL_VALUE_MAX), MG-ECU2 の上限/下限トルクの組み合わせで
+ *    EV-ECU1 に入る要求トルクの Normal Value を比べ, 差が 1 LSB (0.5 Nm) 以内か確認する
+ *    MG-ECU2 は Loopback_Bus で受信させ, 要求トルクは taskControl と同じく符号を反転して渡す
+ * 2. taskPedal の Accel の計算と taskControl のトルク要求の1回分の時間を比べる
+ *    (ホストPCの時間なので, AVR ではファームウェアの LoopProfiler の 'p' で
+ *     FIXED_POINT_TORQUE の有無を切り替えて STAGE_ACCEL, STAGE_INVERTER を見る)
+ *    ホストPCの PROBE_SCOPE は micros() を呼んで計算より遅いので, PROBE_DISABLE でビルドする
+ *
+ * usage : program [繰り返し回数]
+ * 戻り値 : 差が 1 LSB を超えれば 1
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Accel.hpp"
+#include "Inverter.hpp"
+#include "Loopback_Bus.hpp"
+#include "TorqueMap.hpp"
+
+#define DEFAULT_REPEAT (200)
+#define PRIME_STEPS (8) // Accel の偏差異常フラグを解除するまでの setValue の回数
+#define MEASURE_TRIALS (5)
+
+static const char *MAP_NAMES[TORQUE_MAP_NUM] = {"LINEAR", "RAIN", "ENDURANCE", "ACCEL"};
+
+// MG-ECU2 の上限/下限トルク [Nm]
+struct TORQUE_LIMIT
+{
+    float motor;
+    float generate;
+};
+
+// 要求トルクは負なので下限が効く (マップの最大は MAXIMUM_TORQUE * 1 V = 2 Nm)
+static const TORQUE_LIMIT LIMITS[] = {{1000, -1000}, {1.5f, -1.5f}, {0.5f, -0.5f}, {0, 0}};
+
+#define LIMIT_NUM (sizeof(LIMITS) / sizeof(LIMITS[0]))
+
+static volatile long sink;
+
+//-------------------------------------------------------
+//  以前の Accel (float, 比較用)
+//  センサ値の範囲と電圧の換算は今の ACCEL_VALUE_MAX, ADC_VOLTAGE_RESOLUTION に合わせ,
+//  直線の代わりにマップの折れ線を float で計算する (TorqueMap::calc)
+//-------------------------------------------------------
+class LegacyAccel
+{
+private:
+    int val[2];
+    float avr;
+    unsigned char devErrorFlag;
+    float dev;
+    unsigned char lastDevError;
+    unsigned char devError;
+    unsigned char chatt[3];
+    unsigned char torqueOutputFlag;
+    float torque;
+    unsigned char map;
+
+    float calcDev(void)
+    {
+        float def = abs((val[0] - val[1]) * ADC_VOLTAGE_RESOLUTION);
+        return 100 * (def / AMOUNT_OF_MOVEMENT);
+    }
+
+    float calcTorque(void)
+    {
+        if (torqueOutputFlag)
+        {
+            unsigned short value = val[0] < val[1] ? val[0] : val[1];
+
+            if (value * ADC_VOLTAGE_RESOLUTION < MINIMUM_SENSOR_VOLTAGE)
+            {
+                return 0;
+            }
+
+            return TorqueMap::calc(map, value);
+        }
+
+        return 0;
+    }
+
+    void updateTorqueOutputFlag(void)
+    {
+        lastDevError = devError;
+        devError = (chatt[2] & chatt[1] & chatt[0]);
+        chatt[2] = chatt[1];
+        chatt[1] = chatt[0];
+        chatt[0] = dev >= THRESHOLD_DEVIATION;
+        if (lastDevError == 0 && devError == 1)
+        {
+            devErrorFlag = 1;
+        }
+
+        if (torqueOutputFlag)
+        {
+            if (devErrorFlag)
+            {
+                torqueOutputFlag = 0;
+            }
+            return;
+        }
+
+        if (devErrorFlag)
+        {
+            if (val[0] * ADC_VOLTAGE_RESOLUTION < 0.7f && val[1] * ADC_VOLTAGE_RESOLUTION < 0.7f && lastDevError == 0 && devError == 0)
+            {
+                devErrorFlag = 0;
+            }
+            return;
+        }
+
+        torqueOutputFlag = 1;
+    }
+
+public:
+    LegacyAccel(unsigned char map)
+        : val{0, 0}, avr(0), devErrorFlag(1), dev(0), lastDevError(0), devError(0), chatt{1, 1, 1}, torqueOutputFlag(0), torque(0.0f), map(map)
+    {
+    }
+
+    void setValue(int val1, int val2)
+    {
+        val[0] = val1;
+        val[1] = ((-1) * val2) + ACCEL_VALUE_MAX;
+        avr = (val[0] + val[1]) / 2.0f;
+        dev = calcDev();
+
+        updateTorqueOutputFlag();
+
+        torque = calcTorque();
+    }
+
+    inline float getTorque(void) { return torque; }
+};
+
+//-------------------------------------------------------
+
+static double nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// MG-ECU1 をトルク制御中, MG-ECU2 の上限/下限を limit にして受信させる
+static void sendMgecu(Loopback_Bus *bus, Inverter *inverter, const TORQUE_LIMIT *limit)
+{
+    unsigned char mgecu1[8] = {0};
+    unsigned char mgecu2[8] = {0};
+
+    MG_ECU1::WorkingStatus::set(mgecu1, WORKING_TORQUE_CONTROL);
+    MG_ECU2::MaxAvailableMotorTorque::set(mgecu2, (unsigned short)(limit->motor * 2));
+    MG_ECU2::MaxAvailableGenerateTorque::set(mgecu2, (unsigned short)((limit->generate + 1000) * 2));
+
+    bus->write(MG_ECU1_ID, 8, mgecu1);
+    bus->write(MG_ECU2_ID, 8, mgecu2);
+    inverter->readMsgFromInverter(0);
+}
+
+static unsigned short requestNormal(Inverter *inverter)
+{
+    unsigned char buf[8];
+
+    inverter->getMsg(EV_ECU1_ID, buf);
+    return EV_ECU1::RequestTorque::get(buf);
+}
+
+// 偏差異常フラグを解除してトルクを出せる状態にする (アクセルを離す)
+template <class ACCEL_T>
+static void prime(ACCEL_T *accel)
+{
+    for (int i = 0; i < PRIME_STEPS; i++)
+    {
+        accel->setValue(0, ACCEL_VALUE_MAX);
+    }
+}
+
+/**
+ * 全てのセンサ値で func を repeat 回呼ぶ時間 [ns / 回]
+ * OS の割り込みの影響を除くため, MEASURE_TRIALS 回測って最小を返す
+ */
+template <class Func>
+static double measure(Func func, long repeat)
+{
+    double min = 0;
+
+    for (int t = 0; t < MEASURE_TRIALS; t++)
+    {
+        const double t0 = nowNanos();
+
+        for (long r = 0; r < repeat; r++)
+        {
+            for (int v = 0; v <= ACCEL_VALUE_MAX; v++)
+            {
+                func(v);
+            }
+        }
+
+        const double time = (nowNanos() - t0) / ((double)repeat * (ACCEL_VALUE_MAX + 1));
+        min = t == 0 || time < min ? time : min;
+    }
+
+    return min;
+}
+
+int main(int argc, char **argv)
+{
+    const long repeat = argc > 1 ? atol(argv[1]) : DEFAULT_REPEAT;
+    Loopback_Bus bus;
+    Inverter inverter(&bus);
+    int result = 0;
+
+    hostSerialEnable(0);
+    inverter.init();
+
+    printf("EV-ECU1 request torque, fixed vs float (sensor 0..%d)\n", ACCEL_VALUE_MAX);
+
+    // 1. 一致の確認
+    for (unsigned int l = 0; l < LIMIT_NUM; l++)
+    {
+        sendMgecu(&bus, &inverter, &LIMITS[l]);
+
+        for (unsigned char map = 0; map < TORQUE_MAP_NUM; map++)
+        {
+            Accel accel;
+            LegacyAccel legacy(map);
+            unsigned long differ = 0;
+            long maxDiff = 0;
+            int worst = 0;
+
+            accel.setTorqueMap(map);
+            prime(&accel);
+            prime(&legacy);
+
+            for (int v = 0; v <= ACCEL_VALUE_MAX; v++)
+            {
+                accel.setValue(v, ACCEL_VALUE_MAX - v);
+                inverter.fixedTorqueRequest(-accel.getFixedTorque());
+                const long fixed = requestNormal(&inverter);
+
+                legacy.setValue(v, ACCEL_VALUE_MAX - v);
+                inverter.torqueRequest(-legacy.getTorque());
+                const long ref = requestNormal(&inverter);
+
+                const long d = labs(fixed - ref);
+                differ += d != 0;
+                if (d > maxDiff)
+                {
+                    maxDiff = d;
+                    worst = v;
+                }
+            }
+
+            printf("limit %6.1f/%7.1f Nm %-9s : max diff %ld LSB (at %d), %lu / %d values differ\n",
+                   LIMITS[l].motor, LIMITS[l].generate, MAP_NAMES[map], maxDiff, worst, differ, ACCEL_VALUE_MAX + 1);
+            result |= maxDiff > 1;
+        }
+    }
+
+    // 2. 時間
+    sendMgecu(&bus, &inverter, &LIMITS[1]);
+
+    Accel accel;
+    LegacyAccel legacy(TORQUE_MAP_DEFAULT);
+    prime(&accel);
+    prime(&legacy);
+
+    const double floatTime = measure([&](int v) {
+        legacy.setValue(v, ACCEL_VALUE_MAX - v);
+        inverter.torqueRequest(-legacy.getTorque());
+    }, repeat);
+    const double fixedTime = measure([&](int v) {
+        accel.setValue(v, ACCEL_VALUE_MAX - v);
+        inverter.fixedTorqueRequest(-accel.getFixedTorque());
+    }, repeat);
+
+    printf("\nsensor -> EV-ECU1 per step (host PC) : float %.2f ns, fixed %.2f ns\n", floatTime, fixedTime);
+    printf("\n%s\n", result ? "FAILED" : "OK");
+
+    return result;
+}
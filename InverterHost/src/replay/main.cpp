@@ -0,0 +1,299 @@
+/**
+ * 実機のCANトラフィックを記録し, Inverter の受信処理へ再生する
+ *
+ * record : SocketCAN で受信した全てのフレームを candump -L 形式 か ASC 形式で記録する
+ *          時刻はカーネルの受信時刻 (SIOCGSTAMP), Ctrl+C で終了
+ * replay : ログのフレームを Replay_Bus から Inverter::readMsgFromInverter へ渡す
+ *          仮想時計をログの時刻どおりに進めるので PeriodMonitor のタイムアウトも実機と同じに起きる
+ *          AMS の温度 (AMS_Temp_Master の CAN_Temp) も Inverter に処理関数を登録して読む
+ *
+ * usage : program record <ifname> <file> [asc | candump] [秒数]
+ *         program replay [-s 速さ] <file>
+ *  -s 1   : 実時間 (デフォルト)
+ *  -s 100 : 100倍速
+ *  -s max : 待たずに再生して受信処理の frames/s を測る
+ */
+#include <Arduino.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/sockios.h>
+#include "Inverter.hpp"
+#include "Signal.hpp"
+#include "CanLog.hpp"
+#include "Replay_Bus.hpp"
+
+#define REPLAY_LOOP_PERIOD (1000) // loop() 1回分の仮想時計の最大の進み[us]
+
+// AMS_Temp_Master の CAN_Temp_dfs.hpp, CAN_Temp.hpp と同じ
+#define AMS_TEMP_ID_NUM (5)
+static const unsigned long AMS_TEMP_IDS[AMS_TEMP_ID_NUM] = {0x340, 0x341, 0x342, 0x343, 0x344};
+static const char *AMS_TEMP_NAMES[AMS_TEMP_ID_NUM] = {"ACC", "SEG1", "SEG2", "SEG3", "SEG4"};
+typedef Parameter<-25, 1, 2, -25, 100> TempPara;
+typedef Signal<0, 8, SIGNAL_INTEL, TempPara> AvrTempSignal;
+typedef Signal<8, 8, SIGNAL_INTEL, TempPara> MaxTempSignal;
+typedef Signal<16, 8, SIGNAL_INTEL, TempPara> MinTempSignal;
+
+static volatile sig_atomic_t stopFlag = 0;
+
+static void onSignal(int)
+{
+    stopFlag = 1;
+}
+
+static unsigned long long wallMicros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+//-------------------------------------------------------
+//  record
+//-------------------------------------------------------
+static int record(const char *ifname, const char *path, unsigned char format, unsigned long seconds)
+{
+    CanLogWriter writer;
+    struct ifreq ifr;
+    struct sockaddr_can addr;
+
+    int sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (sock < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0)
+    {
+        perror(ifname);
+        close(sock);
+        return 1;
+    }
+
+    // 受信フィルタは設定しない (全てのIDを記録する)
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        close(sock);
+        return 1;
+    }
+
+    if (writer.open(path, format, ifname))
+    {
+        perror(path);
+        close(sock);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    const unsigned long long end = seconds ? wallMicros() + seconds * 1000000ULL : 0;
+    struct pollfd pfd = {sock, POLLIN, 0};
+
+    while (!stopFlag && (end == 0 || wallMicros() < end))
+    {
+        struct can_frame frame;
+        struct timeval tv;
+        CAN_LOG_RECORD rec;
+
+        if (poll(&pfd, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        if (recv(sock, &frame, sizeof(frame), 0) != sizeof(frame) || (frame.can_id & CAN_ERR_FLAG))
+        {
+            continue;
+        }
+
+        ioctl(sock, SIOCGSTAMP, &tv);
+
+        memset(&rec, 0, sizeof(rec));
+        rec.time = (unsigned long long)tv.tv_sec * 1000000ULL + tv.tv_usec;
+        rec.extended = (frame.can_id & CAN_EFF_FLAG) != 0;
+        rec.remote = (frame.can_id & CAN_RTR_FLAG) != 0;
+        rec.id = frame.can_id & (rec.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+        rec.len = frame.can_dlc > 8 ? 8 : frame.can_dlc;
+        memcpy(rec.buf, frame.data, rec.len);
+
+        writer.write(&rec);
+    }
+
+    fprintf(stderr, "recorded %lu frames\n", writer.getCount());
+    writer.close();
+    close(sock);
+
+    return 0;
+}
+
+//-------------------------------------------------------
+//  replay
+//-------------------------------------------------------
+struct AMS_TEMP
+{
+    unsigned long count;
+    float avrTemp;
+    float maxTemp; // 再生中の最大
+    float minTemp; // 再生中の最小
+};
+
+static unsigned char amsTempHandler(void *p, const unsigned char *buf, unsigned char len)
+{
+    AMS_TEMP *temp = (AMS_TEMP *)p;
+
+    if (len < 3)
+    {
+        return 1;
+    }
+
+    const float maxTemp = MaxTempSignal::getPhysical(buf);
+    const float minTemp = MinTempSignal::getPhysical(buf);
+
+    temp->avrTemp = AvrTempSignal::getPhysical(buf);
+    temp->maxTemp = temp->count == 0 || maxTemp > temp->maxTemp ? maxTemp : temp->maxTemp;
+    temp->minTemp = temp->count == 0 || minTemp < temp->minTemp ? minTemp : temp->minTemp;
+    temp->count++;
+
+    return 0;
+}
+
+static void printTimeout(Replay_Bus *bus, Inverter *inverter, unsigned long id, const char *name, unsigned char *last)
+{
+    const unsigned char timeout = inverter->getPeriodMonitor()->isTimeout(id);
+
+    if (timeout != *last)
+    {
+        printf("[%12.6f s] %s %s\n", bus->getLogTime() / 1e6, name, timeout ? "timeout" : "recovered");
+        *last = timeout;
+    }
+}
+
+static void printPeriod(Inverter *inverter, unsigned long id, const char *name)
+{
+    const PERIOD_STAT *stat = inverter->getPeriodMonitor()->getStat(id);
+
+    printf("%-16s: n %u, period min %lu avg %lu max %lu us, timeout %u\n", name, inverter->getReceivedCount(id),
+           stat->count ? stat->min : 0, inverter->getPeriodMonitor()->getMean(id), stat->max, stat->timeoutCount);
+}
+
+static int replay(const char *path, double speed)
+{
+    CanLogReader reader;
+    Replay_Bus bus(&reader);
+    Inverter inverter(&bus);
+    AMS_TEMP amsTemp[AMS_TEMP_ID_NUM];
+    unsigned char mgecu1Timeout = 0, mgecu2Timeout = 0;
+    unsigned long loopCount = 0, frameCount = 0;
+
+    if (reader.open(path))
+    {
+        perror(path);
+        return 1;
+    }
+
+    memset(amsTemp, 0, sizeof(amsTemp));
+    for (int i = 0; i < AMS_TEMP_ID_NUM; i++)
+    {
+        inverter.addMsgHandler(AMS_TEMP_IDS[i], amsTempHandler, &amsTemp[i]);
+    }
+
+    hostSerialEnable(0);
+    inverter.init();
+
+    if (bus.start(speed))
+    {
+        fprintf(stderr, "%s : no frame\n", path);
+        return 1;
+    }
+
+    const unsigned long long wallStart = wallMicros();
+
+    do
+    {
+        inverter.serviceCan(millis());
+        frameCount += inverter.readMsgFromInverter(0);
+        inverter.checkRxTimeout(micros());
+        loopCount++;
+
+        printTimeout(&bus, &inverter, MG_ECU1_ID, "MG_ECU1", &mgecu1Timeout);
+        printTimeout(&bus, &inverter, MG_ECU2_ID, "MG_ECU2", &mgecu2Timeout);
+    } while (bus.step(REPLAY_LOOP_PERIOD));
+
+    const double wall = (wallMicros() - wallStart) / 1e6;
+    const double logTime = bus.getLogTime() / 1e6;
+
+    printf("\nlog lines       : %lu (skipped %lu)\n", reader.getLineCount(), reader.getSkipCount());
+    printf("frames          : %lu replayed, %lu filtered, %u rx overflow\n",
+           bus.getReplayCount(), bus.getFilteredCount(), bus.getOverflowCount());
+    printf("frames handled  : %lu in %lu loops\n", frameCount, loopCount);
+    printf("log time        : %.3f s\n", logTime);
+    printf("wall time       : %.3f s (x%.1f)\n", wall, wall > 0 ? logTime / wall : 0.0);
+    printf("frames/s        : %.0f\n", wall > 0 ? frameCount / wall : 0.0);
+    printPeriod(&inverter, MG_ECU1_ID, "MG_ECU1");
+    printPeriod(&inverter, MG_ECU2_ID, "MG_ECU2");
+
+    for (int i = 0; i < AMS_TEMP_ID_NUM; i++)
+    {
+        if (amsTemp[i].count > 0)
+        {
+            printf("%-16s: n %lu, avr %.1f max %.1f min %.1f deg C\n", AMS_TEMP_NAMES[i], amsTemp[i].count,
+                   amsTemp[i].avrTemp, amsTemp[i].maxTemp, amsTemp[i].minTemp);
+        }
+    }
+
+    return 0;
+}
+
+static int usage(const char *program)
+{
+    fprintf(stderr, "usage : %s record <ifname> <file> [asc | candump] [seconds]\n", program);
+    fprintf(stderr, "        %s replay [-s speed | -s max] <file>\n", program);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "record") == 0)
+    {
+        const unsigned char format = argc > 4 && strcmp(argv[4], "asc") == 0 ? CAN_LOG_ASC : CAN_LOG_CANDUMP;
+        const unsigned long seconds = argc > 5 ? strtoul(argv[5], nullptr, 10) : 0;
+
+        return record(argv[2], argv[3], format, seconds);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0)
+    {
+        double speed = 1;
+        int i = 2;
+
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            speed = strcmp(argv[i + 1], "max") == 0 ? 0 : atof(argv[i + 1]);
+            i += 2;
+        }
+
+        if (i >= argc || speed < 0)
+        {
+            return usage(argv[0]);
+        }
+
+        return replay(argv[i], speed);
+    }
+
+    return usage(argv[0]);
+}
@@ -0,0 +1,271 @@
+/**
+ * MG-ECU シミュレータと Inverter を Loopback_Bus でつないだ閉ループ試験
+ *
+ * 1サイクル : 電源ON -> プリチャージ -> Ready to Drive -> 走行 -> 回生で停止 -> シャットダウン
+ * 仮想時計で 1ms ずつ進めるので実時間より速く回る
+ *
+ * 測定するもの
+ *  - プリチャージ完了からシミュレータが ecuEnable = 1 を受信するまでの時間
+ *  - アクセル指令の変化からシミュレータが新しい要求トルクを受信するまでの時間
+ *  - Critical Error (回転中の ecuEnable OFF など) の回数
+ *  - Inverter の PeriodMonitor で測った MG-ECU1/MG-ECU2 の受信間隔とタイムアウトの回数
+ *
+ * usage : program [サイクル数] [乱数シード]
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <time.h>
+#include "Inverter.hpp"
+#include "Loopback_Bus.hpp"
+#include "MGECUSim.hpp"
+
+#define DEFAULT_CYCLE (1000)
+#define BATTERY_VOLTAGE (370)
+#define READY_TO_DRIVE_DELAY (100)  // AIR ON から Ready to Drive SW を押すまで[ms]
+#define DRIVE_TIME (3000)           // 走行時間[ms]
+#define PEDAL_SEGMENT (200)         // アクセル指令を変える間隔[ms]
+#define PEDAL_MAX_TORQUE (60)       // アクセル全開のトルク[Nm]
+#define BRAKE_TORQUE (20)           // 停止時の回生トルク[Nm]
+#define STOP_SPEED (5.0f)           // 停止とみなす回転数[rpm]
+#define SHUTDOWN_TIME (200)         // シャットダウンから STANDBY を待つ時間[ms]
+#define CYCLE_TIMEOUT (30000)       // 1サイクルの最大時間[ms]
+
+struct LATENCY
+{
+    unsigned long count;
+    unsigned long sum;
+    unsigned long max;
+};
+
+static void addLatency(LATENCY *latency, unsigned long us)
+{
+    latency->count++;
+    latency->sum += us;
+    latency->max = us > latency->max ? us : latency->max;
+}
+
+static void printLatency(const char *name, const LATENCY *latency)
+{
+    printf("%-28s: n %lu avg %.2f ms max %.2f ms\n", name, latency->count,
+           latency->count ? latency->sum / 1000.0 / latency->count : 0.0, latency->max / 1000.0);
+}
+
+struct PERIOD
+{
+    unsigned long min;
+    unsigned long max;
+    unsigned long long sum;
+    unsigned long count;
+    unsigned long timeout;
+};
+
+// 1サイクル分の PeriodMonitor の統計をまとめる
+static void addPeriod(PERIOD *period, const PERIOD_STAT *stat)
+{
+    if (stat->count > 0)
+    {
+        period->min = stat->min < period->min ? stat->min : period->min;
+        period->max = stat->max > period->max ? stat->max : period->max;
+        period->sum += stat->sum;
+        period->count += stat->count;
+    }
+    period->timeout += stat->timeoutCount;
+}
+
+static void printPeriod(const char *name, const PERIOD *period)
+{
+    printf("%-28s: min %lu avg %.0f max %lu us, timeout %lu\n", name, period->count ? period->min : 0,
+           period->count ? (double)period->sum / period->count : 0.0, period->max, period->timeout);
+}
+
+enum Phase
+{
+    PHASE_PRECHARGE,
+    PHASE_DRIVE,
+    PHASE_BRAKE,
+    PHASE_SHUTDOWN,
+    PHASE_END
+};
+
+int main(int argc, char **argv)
+{
+    const long cycleNum = argc > 1 ? atol(argv[1]) : DEFAULT_CYCLE;
+    unsigned int seed = argc > 2 ? (unsigned int)atol(argv[2]) : 1;
+
+    LATENCY prechargeLatency = {0, 0, 0};
+    PERIOD mgecu1Period = {0xFFFFFFFF, 0, 0, 0, 0};
+    PERIOD mgecu2Period = {0xFFFFFFFF, 0, 0, 0, 0};
+    LATENCY torqueLatency = {0, 0, 0};
+    long completed = 0;
+    long criticalError = 0;
+    long timeout = 0;
+    unsigned long long simulatedMs = 0;
+
+    clock_t wallStart = clock();
+
+    hostUseVirtualClock(1);
+    hostSerialEnable(0);
+
+    for (long cycle = 0; cycle < cycleNum; cycle++)
+    {
+        Loopback_Bus inverterBus;
+        Loopback_Bus mgecuBus;
+        inverterBus.connect(&mgecuBus);
+
+        MGECUSim sim(&mgecuBus, BATTERY_VOLTAGE);
+        Inverter inverter(&inverterBus);
+
+        sim.begin();
+        inverter.init();
+        sim.setTractiveSystem(1);
+
+        unsigned char flags[4] = {0, 0, 0, 0};
+        short torque = 0; // 0.5 Nm 単位
+        Phase phase = PHASE_PRECHARGE;
+        unsigned long phaseTime = 0;
+        unsigned long prechargeTime = 0;   // プリチャージ完了条件を満たした時刻[us]
+        unsigned char ecuEnableFlag = 0;   // ecuEnable = 1 を受信した
+        unsigned long torqueCmdTime = 0;   // アクセル指令を変えた時刻[us]
+        float lastRequestTorque = 0;
+        unsigned short lastCommandCount = 0;
+        unsigned long ms;
+
+        for (ms = 0; ms < CYCLE_TIMEOUT && phase != PHASE_END; ms++)
+        {
+            hostAdvanceMicros(1000);
+
+            sim.setAir(flags[0]);
+            sim.step();
+
+            inverter.serviceCan(ms);
+            inverter.readMsgFromInverter(0);
+            inverter.checkRxTimeout(micros());
+            inverter.runInverterFixed(flags, BATTERY_VOLTAGE, torque);
+
+            if (inverter.isTxDue(ms))
+            {
+                inverter.sendMsgToInverter(0);
+            }
+
+            sim.step();
+
+            unsigned long now = micros();
+
+            // プリチャージ完了 (Inverter と同じ条件) から ecuEnable を受信するまで
+            if (!prechargeTime && sim.getWorkingStatus() == WORKING_PRECHARGE &&
+                BATTERY_VOLTAGE - (unsigned short)sim.getDCVoltage() < BATTERY_VOLTAGE / 10)
+            {
+                prechargeTime = now;
+            }
+            if (prechargeTime && !ecuEnableFlag && sim.getEcuEnable())
+            {
+                addLatency(&prechargeLatency, sim.getLastCommandTime() - prechargeTime);
+                ecuEnableFlag = 1;
+            }
+
+            // アクセル指令から要求トルクの変化を受信するまで
+            if (torqueCmdTime && sim.getCommandCount() != lastCommandCount && sim.getRequestTorque() != lastRequestTorque)
+            {
+                addLatency(&torqueLatency, sim.getLastCommandTime() - torqueCmdTime);
+                torqueCmdTime = 0;
+            }
+            lastRequestTorque = sim.getRequestTorque();
+            lastCommandCount = sim.getCommandCount();
+
+            switch (phase)
+            {
+            case PHASE_PRECHARGE:
+                if (flags[0])
+                {
+                    phase = PHASE_DRIVE;
+                    phaseTime = ms;
+                }
+                break;
+
+            case PHASE_DRIVE:
+                if (ms - phaseTime >= READY_TO_DRIVE_DELAY)
+                {
+                    flags[3] = 1;
+                }
+
+                if (ms - phaseTime >= READY_TO_DRIVE_DELAY + DRIVE_TIME)
+                {
+                    phase = PHASE_BRAKE;
+                    phaseTime = ms;
+                }
+                else if (flags[1] && (ms - phaseTime) % PEDAL_SEGMENT == 0)
+                {
+                    // main.cpp と同じく符号を反転してトルク指令にする
+                    short next = -(short)(rand_r(&seed) % (PEDAL_MAX_TORQUE * FIXED_TORQUE_RESOLUTION + 1));
+                    if (next != torque)
+                    {
+                        torque = next;
+                        torqueCmdTime = now;
+                    }
+                }
+                break;
+
+            case PHASE_BRAKE:
+                if (fabsf(sim.getMotorSpeed()) < STOP_SPEED)
+                {
+                    torque = 0;
+                    flags[2] = 1;
+                    phase = PHASE_SHUTDOWN;
+                    phaseTime = ms;
+                }
+                else
+                {
+                    torque = sim.getMotorSpeed() > 0 ? -BRAKE_TORQUE * FIXED_TORQUE_RESOLUTION : BRAKE_TORQUE * FIXED_TORQUE_RESOLUTION;
+                    torqueCmdTime = 0;
+                }
+                break;
+
+            case PHASE_SHUTDOWN:
+                if (ms - phaseTime >= SHUTDOWN_TIME)
+                {
+                    sim.setTractiveSystem(0);
+                    phase = PHASE_END;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        simulatedMs += ms;
+
+        addPeriod(&mgecu1Period, inverter.getPeriodMonitor()->getStat(MG_ECU1_ID));
+        addPeriod(&mgecu2Period, inverter.getPeriodMonitor()->getStat(MG_ECU2_ID));
+
+        if (sim.getFailureStatus() == FAILURE_CRITICAL_ERROR)
+        {
+            criticalError++;
+        }
+        else if (phase != PHASE_END)
+        {
+            timeout++;
+        }
+        else if (sim.getWorkingStatus() == WORKING_STANDBY)
+        {
+            completed++;
+        }
+    }
+
+    hostSerialEnable(1);
+
+    double wall = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    printf("cycles                      : %ld\n", cycleNum);
+    printf("completed                   : %ld\n", completed);
+    printf("critical error              : %ld\n", criticalError);
+    printf("timeout                     : %ld\n", timeout);
+    printf("simulated time              : %.1f s (wall %.2f s, x%.0f)\n",
+           simulatedMs / 1000.0, wall, wall > 0 ? simulatedMs / 1000.0 / wall : 0.0);
+    printLatency("precharge -> ecuEnable", &prechargeLatency);
+    printLatency("pedal -> request torque", &torqueLatency);
+    printPeriod("MG-ECU1 period", &mgecu1Period);
+    printPeriod("MG-ECU2 period", &mgecu2Period);
+
+    return completed == cycleNum ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/**
+ * TorqueMap の表引きを折れ線の float 計算, 以前の直線の計算と比べる
+ *
+ * 1. 全てのマップで, 全てのセンサ値 (0~ACCEL_VALUE_MAX) の表引きの結果を
+ *    TorqueMap::calc (float) を 1/FIXED_TORQUE_RESOLUTION Nm に四捨五入した値と比べる
+ * 2. TORQUE_MAP_LINEAR を以前の calcTorque (float), calcFixedTorque (Q16) と比べる
+ * 3. 1回あたりの時間を比べる (ホストPCの時間なので AVR の比較はファームウェアの PROBE_SCOPE で見る)
+ *
+ * トルクの刻みが粗いと差が出にくいので, 細かく比べるときは
+ * build_flags に -DFIXED_TORQUE_RESOLUTION=64 を足してビルドする
+ *
+ * usage : program [繰り返し回数]
+ * 戻り値 : 表引きと float の差が1刻みを超えれば 1
+ */
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Accel_dfs.hpp"
+#include "TorqueMap.hpp"
+
+#define DEFAULT_REPEAT (2000)
+#define FLOOR_EPSILON (1e-3f) // float の丸め誤差で 4.0 が 3.9999 になって切り捨てで1減らないようにする
+
+static const char *MAP_NAMES[TORQUE_MAP_NUM] = {"LINEAR", "RAIN", "ENDURANCE", "ACCEL"};
+
+static volatile long sink;
+
+//-------------------------------------------------------
+//  以前の Accel の計算 (比較用)
+//-------------------------------------------------------
+static float legacyTorque(unsigned short value)
+{
+    float v = value * ADC_VOLTAGE_RESOLUTION;
+
+    if (v < MINIMUM_SENSOR_VOLTAGE)
+    {
+        return 0;
+    }
+    else if (v > MAXIMUM_SENSOR_VOLTAGE)
+    {
+        v = MAXIMUM_SENSOR_VOLTAGE;
+    }
+
+    return MAXIMUM_TORQUE * (v - MINIMUM_SENSOR_VOLTAGE);
+}
+
+static short legacyFixedTorque(unsigned short value)
+{
+    static const long GAIN_Q16 = (long)(MAXIMUM_TORQUE * FIXED_TORQUE_RESOLUTION * ADC_VOLTAGE_RESOLUTION * 65536.0f + 0.5f);
+    static const long OFFSET_Q16 = (long)(MAXIMUM_TORQUE * FIXED_TORQUE_RESOLUTION * MINIMUM_SENSOR_VOLTAGE * 65536.0f + 0.5f);
+    static const long MAX_Q16 = (long)(MAXIMUM_TORQUE * FIXED_TORQUE_RESOLUTION * (MAXIMUM_SENSOR_VOLTAGE - MINIMUM_SENSOR_VOLTAGE) * 65536.0f + 0.5f);
+
+    long t = (long)value * GAIN_Q16 - OFFSET_Q16;
+
+    t = t < 0 ? 0 : t > MAX_Q16 ? MAX_Q16 : t;
+    return (short)(t >> 16);
+}
+
+//-------------------------------------------------------
+
+struct DIFF
+{
+    long maxDiff;
+    unsigned long mismatch;
+    unsigned short worstValue;
+};
+
+static void addDiff(DIFF *diff, unsigned short value, long a, long b)
+{
+    const long d = labs(a - b);
+
+    if (d > 0)
+    {
+        diff->mismatch++;
+    }
+    if (d > diff->maxDiff)
+    {
+        diff->maxDiff = d;
+        diff->worstValue = value;
+    }
+}
+
+static void printDiff(const char *name, const DIFF *diff)
+{
+    printf("%-34s: max diff %ld (at %u), %lu / %d values differ\n", name, diff->maxDiff, diff->worstValue,
+           diff->mismatch, ACCEL_VALUE_MAX + 1);
+}
+
+static double nowNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// センサ値を全て1回ずつ, repeat 回計算する時間 [ns / 回]
+template <class Func>
+static double measure(Func func, long repeat)
+{
+    const double t0 = nowNanos();
+
+    for (long r = 0; r < repeat; r++)
+    {
+        for (unsigned short v = 0; v <= ACCEL_VALUE_MAX; v++)
+        {
+            sink += func(v);
+        }
+    }
+
+    return (nowNanos() - t0) / ((double)repeat * (ACCEL_VALUE_MAX + 1));
+}
+
+int main(int argc, char **argv)
+{
+    const long repeat = argc > 1 ? atol(argv[1]) : DEFAULT_REPEAT;
+    int result = 0;
+
+    printf("sensor value 0..%d, table %d points x %d maps (%u bytes), step %d\n\n", ACCEL_VALUE_MAX, TORQUE_MAP_SIZE,
+           TORQUE_MAP_NUM, (unsigned int)(TORQUE_MAP_SIZE * TORQUE_MAP_NUM * sizeof(unsigned short)), 1 << TORQUE_MAP_SHIFT);
+
+    // 1. 表引きと float の折れ線
+    for (unsigned char map = 0; map < TORQUE_MAP_NUM; map++)
+    {
+        DIFF diff = {};
+        char name[40];
+
+        for (unsigned short v = 0; v <= ACCEL_VALUE_MAX; v++)
+        {
+            const long ref = lroundf(TorqueMap::calc(map, v) * FIXED_TORQUE_RESOLUTION);
+            addDiff(&diff, v, TorqueMap::lookup(map, v), ref);
+        }
+
+        snprintf(name, sizeof(name), "%s lookup vs calc", MAP_NAMES[map]);
+        printDiff(name, &diff);
+        result |= diff.maxDiff > 1;
+    }
+
+    // 2. 以前の直線
+    DIFF floatDiff = {}, fixedDiff = {};
+    for (unsigned short v = 0; v <= ACCEL_VALUE_MAX; v++)
+    {
+        const short lookup = v < MINIMUM_SENSOR_VOLTAGE / ADC_VOLTAGE_RESOLUTION ? 0 : TorqueMap::lookup(TORQUE_MAP_LINEAR, v);
+        addDiff(&floatDiff, v, lookup, (long)(legacyTorque(v) * FIXED_TORQUE_RESOLUTION + FLOOR_EPSILON));
+        addDiff(&fixedDiff, v, lookup, legacyFixedTorque(v));
+    }
+    printDiff("LINEAR lookup vs legacy float", &floatDiff);
+    printDiff("LINEAR lookup vs legacy Q16", &fixedDiff);
+
+    // 3. 時間
+    const double legacyFloat = measure([](unsigned short v) { return (long)(legacyTorque(v) * FIXED_TORQUE_RESOLUTION); }, repeat);
+    const double legacyFixed = measure([](unsigned short v) { return (long)legacyFixedTorque(v); }, repeat);
+    const double calc = measure([](unsigned short v) { return (long)(TorqueMap::calc(TORQUE_MAP_ACCEL, v) * FIXED_TORQUE_RESOLUTION); }, repeat);
+    const double lookup = measure([](unsigned short v) { return (long)TorqueMap::lookup(TORQUE_MAP_ACCEL, v); }, repeat);
+
+    printf("\n%-34s: %8.2f ns\n", "legacy float (linear)", legacyFloat);
+    printf("%-34s: %8.2f ns\n", "legacy Q16 (linear)", legacyFixed);
+    printf("%-34s: %8.2f ns\n", "TorqueMap::calc (ACCEL, 5 points)", calc);
+    printf("%-34s: %8.2f ns\n", "TorqueMap::lookup (ACCEL)", lookup);
+
+    return result;
+}
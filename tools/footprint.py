@@ -0,0 +1,409 @@
+"""
+Flash/RAM/スタックの使用量をライブラリごと, シンボルごとに集計し, 予算と baseline と比べる
+
+PlatformIO の extra_scripts (pre) として読み込むと,
+  -fstack-usage と -Wl,-Map を全てのビルドに追加し, 次のターゲットを登録する
+    pio run -t footprint           : 集計を表示し, 予算を超えたか baseline から増えすぎたら失敗する
+    pio run -t footprint_baseline  : 今の集計を footprint/<env>.json に baseline として保存する
+
+platformio.ini の設定 (省略時は予算 = ボードの最大値, 増加の上限なし)
+    custom_footprint_flash_budget = 245760   ; flash の予算[bytes]
+    custom_footprint_ram_budget = 7168       ; RAM (.data + .bss) の予算[bytes], スタックの分は残しておく
+    custom_footprint_max_growth = 1024       ; baseline からの flash, RAM それぞれの増加の上限[bytes]
+                                             ; baseline (footprint/<env>.json) が無いときは今の集計で作るので, コミットすること
+
+単体でも動く (ホストPCのビルドや CI で使う)
+    python3 tools/footprint.py --elf firmware.elf --map firmware.map [--build-dir .pio/build/uno]
+                               [--baseline footprint/uno.json] [--update-baseline]
+                               [--flash-budget N] [--ram-budget N] [--max-growth N] [--nm avr-nm]
+
+スタックは -fstack-usage の関数ごとのフレームの大きさで, 呼び出しの深さは考慮しない
+"""
+
+import argparse
+import bisect
+import json
+import os
+import re
+import subprocess
+import sys
+
+# 出力セクションの分類
+FLASH_SECTIONS = (".text", ".rodata", ".ARM.exidx", ".ARM.extab", ".preinit_array", ".init_array", ".fini_array")
+FLASH_RAM_SECTIONS = (".data",)  # flash に初期値, RAM に実体 (AVR は文字列などの .rodata もここに入る)
+RAM_SECTIONS = (".bss", ".noinit")
+
+TOP_SYMBOLS = 15
+TOP_STACK = 10
+
+
+def section_class(name):
+    def match(names):
+        return any(name == n or name.startswith(n + ".") for n in names)
+
+    if match(FLASH_RAM_SECTIONS):
+        return "data"
+    if match(FLASH_SECTIONS):
+        return "flash"
+    if match(RAM_SECTIONS):
+        return "ram"
+    return None
+
+
+def library_of(path):
+    """
+    オブジェクトファイルのパスからライブラリ名を決める
+      .pio/build/<env>/lib1a2/libInverter.a(Inverter.cpp.o) -> Inverter
+      .pio/build/<env>/lib1a2/Inverter/Inverter.cpp.o        -> Inverter
+      .pio/build/<env>/libFrameworkArduino.a(wiring.c.o)      -> FrameworkArduino
+      .pio/build/<env>/src/main.cpp.o                         -> src
+      .../toolchain-atmelavr/avr/lib/avr6/libm.a(addsf3.o)    -> libm
+    """
+    p = "/" + path.replace("\\", "/")
+
+    m = re.search(r"/lib[0-9a-f]+/lib([^/]+)\.a\(", p)
+    if m:
+        return m.group(1)
+    m = re.search(r"/lib[0-9a-f]+/([^/]+)/", p)
+    if m:
+        return m.group(1)
+    m = re.search(r"/lib(FrameworkArduino[^/]*)\.a\(", p)
+    if m:
+        return m.group(1)
+    if "/FrameworkArduino/" in p:
+        return "FrameworkArduino"
+    if "/src/" in p:
+        return "src"
+    m = re.search(r"/([^/]+)\.a\(", p)
+    if m:
+        return m.group(1)
+    return os.path.basename(p).split(".")[0]
+
+
+def parse_map(path):
+    """
+    GNU ld のマップファイルから出力セクションの大きさと入力セクションの範囲を読む
+    @return  (出力セクション {name: size}, 入力セクション [(start, end, library, class)])
+    """
+    outputs = {}
+    inputs = []
+    current = None
+    pending = None  # 名前が長くて次の行にアドレスが続くセクション ("out" か "in", 名前)
+    started = False
+
+    addr_size = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+
+    with open(path, errors="replace") as fp:
+        for line in fp:
+            line = line.rstrip("\n")
+
+            if not started:
+                started = line.startswith("Linker script and memory map")
+                continue
+
+            if pending is not None:
+                kind, name = pending
+                pending = None
+                m = addr_size.match(line)
+                if m:
+                    if kind == "out":
+                        current = name
+                        outputs[name] = outputs.get(name, 0) + int(m.group(2), 16)
+                    else:
+                        add_input(inputs, current, int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+                    continue
+
+            if line.startswith("/DISCARD/"):
+                current = None
+                continue
+
+            # 出力セクション (行頭から)
+            m = re.match(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?", line)
+            if m:
+                if m.group(2) is None:
+                    pending = ("out", m.group(1))
+                else:
+                    current = m.group(1)
+                    outputs[current] = outputs.get(current, 0) + int(m.group(3), 16)
+                continue
+
+            # 入力セクション (空白1つの後)
+            m = re.match(r"^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$", line)
+            if m and current is not None:
+                if m.group(2) is None:
+                    pending = ("in", m.group(1))
+                else:
+                    add_input(inputs, current, int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+
+    inputs.sort()
+    return outputs, inputs
+
+
+def add_input(inputs, output, start, size, obj):
+    cls = section_class(output or "")
+    if cls is None or size == 0 or obj is None:
+        return
+    inputs.append((start, start + size, library_of(obj.strip()), cls))
+
+
+def parse_symbols(nm, elf, inputs):
+    """
+    nm の大きさ付きのシンボルを入力セクションの範囲からライブラリへ割り当てる
+    @return  [(name, size, library, class)]
+    """
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", elf], stdout=subprocess.PIPE,
+                         universal_newlines=True, check=True).stdout
+    starts = [i[0] for i in inputs]
+    symbols = []
+
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        addr, size, name = int(parts[0], 16), int(parts[1], 16), parts[3]
+
+        i = bisect.bisect_right(starts, addr) - 1
+        if i < 0 or addr >= inputs[i][1]:
+            continue
+        symbols.append((name, size, inputs[i][2], inputs[i][3]))
+
+    return symbols
+
+
+def parse_stack(build_dir):
+    """
+    -fstack-usage の .su ファイルを読む
+    @return  [(function, bytes, qualifier, library)]
+    """
+    frames = []
+
+    if not build_dir or not os.path.isdir(build_dir):
+        return frames
+
+    for root, _, files in os.walk(build_dir):
+        for f in files:
+            if not f.endswith(".su"):
+                continue
+            path = os.path.join(root, f)
+            library = library_of(os.path.relpath(path, build_dir))
+            with open(path, errors="replace") as fp:
+                for line in fp:
+                    parts = line.rstrip("\n").split("\t")
+                    if len(parts) != 3:
+                        continue
+                    function = parts[0].split(":", 3)[-1]
+                    frames.append((function, int(parts[1]), parts[2], library))
+
+    return frames
+
+
+def collect(elf, map_path, build_dir, nm):
+    outputs, inputs = parse_map(map_path)
+    symbols = parse_symbols(nm, elf, inputs)
+    frames = parse_stack(build_dir)
+
+    flash = ram = 0
+    for name, size in outputs.items():
+        cls = section_class(name)
+        flash += size if cls in ("flash", "data") else 0
+        ram += size if cls in ("ram", "data") else 0
+
+    libraries = {}
+    for start, end, library, cls in inputs:
+        lib = libraries.setdefault(library, {"flash": 0, "ram": 0, "stack": 0})
+        lib["flash"] += end - start if cls in ("flash", "data") else 0
+        lib["ram"] += end - start if cls in ("ram", "data") else 0
+    for function, size, qualifier, library in frames:
+        lib = libraries.setdefault(library, {"flash": 0, "ram": 0, "stack": 0})
+        lib["stack"] = max(lib["stack"], size)
+
+    symbol_table = {}
+    for name, size, library, cls in symbols:
+        entry = symbol_table.setdefault(name, {"library": library, "flash": 0, "ram": 0})
+        entry["flash"] += size if cls in ("flash", "data") else 0
+        entry["ram"] += size if cls in ("ram", "data") else 0
+
+    return {
+        "flash": flash,
+        "ram": ram,
+        "libraries": libraries,
+        "symbols": symbol_table,
+        "stack": sorted(frames, key=lambda f: -f[1])[:TOP_STACK],
+    }
+
+
+def delta(now, base):
+    return "" if base is None else "%+d" % (now - base)
+
+
+def report(name, result, baseline, flash_budget, ram_budget, max_growth):
+    """
+    集計を表示する
+    @return  予算内(0), 超えた(1)
+    """
+    errors = []
+    base_libs = baseline["libraries"] if baseline else {}
+    base_syms = baseline["symbols"] if baseline else {}
+
+    print("footprint : %s" % name)
+    for key, budget in (("flash", flash_budget), ("ram", ram_budget)):
+        now = result[key]
+        base = baseline[key] if baseline else None
+        line = "  %-5s %8d bytes" % (key, now)
+        if budget:
+            line += "  budget %8d (%5.1f %%)" % (budget, 100.0 * now / budget)
+            if now > budget:
+                errors.append("%s %d bytes exceeds budget %d" % (key, now, budget))
+        if base is not None:
+            line += "  baseline %8d (%s)" % (base, delta(now, base))
+            if max_growth is not None and now - base > max_growth:
+                errors.append("%s grew %d bytes from baseline (max %d)" % (key, now - base, max_growth))
+        print(line)
+
+    print("\n  %-24s %8s %8s %8s %8s %9s" % ("library", "flash", "ram", "d flash", "d ram", "max frame"))
+    for library, v in sorted(result["libraries"].items(), key=lambda kv: -kv[1]["flash"]):
+        b = base_libs.get(library)
+        print("  %-24s %8d %8d %8s %8s %9d" % (library, v["flash"], v["ram"],
+                                             delta(v["flash"], b["flash"] if b else 0 if baseline else None),
+                                             delta(v["ram"], b["ram"] if b else 0 if baseline else None), v["stack"]))
+    for library in sorted(set(base_libs) - set(result["libraries"])):
+        print("  %-24s %8s %8s %8s %8s" % (library, "-", "-", delta(0, base_libs[library]["flash"]),
+                                           delta(0, base_libs[library]["ram"])))
+
+    symbols = result["symbols"]
+    for key in ("flash", "ram"):
+        top = sorted(symbols.items(), key=lambda kv: -kv[1][key])[:TOP_SYMBOLS]
+        print("\n  top %s symbols" % key)
+        for sym, v in top:
+            if v[key] > 0:
+                print("  %8d  %-16s %s" % (v[key], v["library"], sym))
+
+    if baseline:
+        added = sorted((s for s in symbols if s not in base_syms), key=lambda s: -(symbols[s]["flash"] + symbols[s]["ram"]))
+        if added:
+            print("\n  new symbols since baseline (float routines, malloc and the like show up here)")
+            for sym in added[:TOP_SYMBOLS]:
+                v = symbols[sym]
+                print("  %8d %6d  %-16s %s" % (v["flash"], v["ram"], v["library"], sym))
+
+    if result["stack"]:
+        print("\n  largest stack frames")
+        for function, size, qualifier, library in result["stack"]:
+            print("  %8d  %-16s %s (%s)" % (size, library, function, qualifier))
+
+    for e in errors:
+        print("footprint : ERROR : %s" % e)
+
+    return 1 if errors else 0
+
+
+def load_baseline(path):
+    if path and os.path.isfile(path):
+        with open(path) as fp:
+            return json.load(fp)
+    return None
+
+
+def save_baseline(path, result):
+    directory = os.path.dirname(path)
+    if directory and not os.path.isdir(directory):
+        os.makedirs(directory)
+    data = {k: result[k] for k in ("flash", "ram", "libraries", "symbols")}
+    with open(path, "w") as fp:
+        json.dump(data, fp, indent=1, sort_keys=True)
+        fp.write("\n")
+    print("footprint : baseline saved to %s" % path)
+
+
+def run(name, elf, map_path, build_dir, nm, baseline_path, update, flash_budget, ram_budget, max_growth):
+    result = collect(elf, map_path, build_dir, nm)
+
+    if update:
+        save_baseline(baseline_path, result)
+        return 0
+
+    baseline = load_baseline(baseline_path)
+
+    # 増加の上限があるのに baseline が無いと増加を確かめられないので, 今の集計を baseline にする
+    # (次の実行から増加を確かめる. 作ったファイルはコミットすること)
+    if baseline is None and max_growth is not None and baseline_path:
+        save_baseline(baseline_path, result)
+        print("footprint : WARNING : no baseline, created %s from this build. "
+              "Commit it, growth is checked from the next run" % baseline_path)
+        baseline = load_baseline(baseline_path)
+
+    failed = report(name, result, baseline, flash_budget, ram_budget, max_growth)
+
+    if baseline is None:
+        print("footprint : no baseline (%s), run the footprint_baseline target to create it" % baseline_path)
+
+    return failed
+
+
+#-------------------------------------------------------
+#  PlatformIO
+#-------------------------------------------------------
+def register(env):
+    env.Append(CCFLAGS=["-fstack-usage"], LINKFLAGS=["-Wl,-Map,${BUILD_DIR}/${PROGNAME}.map"])
+
+    def option(key, default):
+        value = env.GetProjectOption("custom_footprint_" + key, "")
+        return int(value, 0) if value else default
+
+    def action(update):
+        def execute(target, source, env):
+            board = env.BoardConfig()
+            cc = env.subst("$CC")
+            nm = cc[:-3] + "nm" if cc.endswith("gcc") else "nm"
+
+            return run(env["PIOENV"],
+                       env.subst("$BUILD_DIR/${PROGNAME}.elf"),
+                       env.subst("$BUILD_DIR/${PROGNAME}.map"),
+                       env.subst("$BUILD_DIR"),
+                       nm,
+                       os.path.join(env.subst("$PROJECT_DIR"), "footprint", env["PIOENV"] + ".json"),
+                       update,
+                       option("flash_budget", int(board.get("upload.maximum_size", 0))),
+                       option("ram_budget", int(board.get("upload.maximum_ram_size", 0))),
+                       option("max_growth", None))
+        return execute
+
+    env.AddCustomTarget(name="footprint", dependencies="$BUILD_DIR/${PROGNAME}.elf", actions=[action(False)],
+                        title="Footprint", description="Flash/RAM/stack usage per library and symbol")
+    env.AddCustomTarget(name="footprint_baseline", dependencies="$BUILD_DIR/${PROGNAME}.elf", actions=[action(True)],
+                        title="Footprint baseline", description="Save the current footprint as the baseline")
+
+
+#-------------------------------------------------------
+#  command line
+#-------------------------------------------------------
+def main():
+    parser = argparse.ArgumentParser(description="Flash/RAM/stack footprint report")
+    parser.add_argument("--elf", required=True)
+    parser.add_argument("--map", required=True)
+    parser.add_argument("--build-dir", default=None, help="directory searched for .su files")
+    parser.add_argument("--nm", default="nm")
+    parser.add_argument("--name", default=None)
+    parser.add_argument("--baseline", default=None)
+    parser.add_argument("--update-baseline", action="store_true")
+    parser.add_argument("--flash-budget", type=int, default=0)
+    parser.add_argument("--ram-budget", type=int, default=0)
+    parser.add_argument("--max-growth", type=int, default=None)
+    args = parser.parse_args()
+
+    if args.update_baseline and not args.baseline:
+        parser.error("--update-baseline needs --baseline")
+
+    return run(args.name or os.path.basename(args.elf), args.elf, args.map, args.build_dir, args.nm,
+               args.baseline, args.update_baseline, args.flash_budget, args.ram_budget, args.max_growth)
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO / SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    register(env)
+elif __name__ == "__main__":
+    sys.exit(main())